@@ -13,27 +13,68 @@
  */
 
 #include "MySQLConnector.h"
+#include "MySQLQueryKiller.h"
 #include "MySQLResultImpl.h"
 #include <algorithm>
+#include <charconv>
 #include <exception>
 #include <db/DbTypes.h>
 #include <string_view>
 #include <poll.h>
 #include <regex>
+#include <strings.h>
+#include <sys/stat.h>
 #include <mariadb/errmsg.h>
 #include "Exception.h"
+#include "SqlTemplate.h"
+#include "utils/utils.h"
 
 using namespace cxk;
 
+namespace
+{
+// 超过这个大小的SQL缓冲区在下次执行前释放，避免一次大语句长期占用内存
+constexpr size_t kMaxRetainedSqlBuffer = 1024 * 1024;
+// 逐行读取时每次至少从连接池的预算中占用这么多，避免每行都修改共享的计数
+constexpr size_t kBudgetReserveStep = 64 * 1024;
+
+template <typename T>
+void appendInteger(std::string &buf, T value)
+{
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    buf.append(tmp, res.ptr - tmp);
+}
+
+// 在开头的SELECT之后插入MAX_EXECUTION_TIME提示，以注释开头等其他情况不做处理
+void insertExecutionTimeHint(std::string &sql, double timeout)
+{
+    auto pos = sql.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos || sql.size() - pos < 7 ||
+        strncasecmp(sql.data() + pos, "select", 6) != 0 ||
+        !isspace(static_cast<unsigned char>(sql[pos + 6])))
+        return;
+    std::string hint(" /*+ MAX_EXECUTION_TIME(");
+    appendInteger(hint, static_cast<uint64_t>(timeout * 1000) + 1);
+    hint.append(") */");
+    sql.insert(pos + 6, hint);
+}
+
+}  // namespace
+
 namespace cxk
 {
 Result makeResult(std::shared_ptr<MYSQL_RES> &&r = nullptr,
                   Result::SizeType affectedRows = 0,
-                  unsigned long long insertId = 0)
+                  unsigned long long insertId = 0,
+                  std::pmr::memory_resource *upstream = nullptr,
+                  ResultMemoryBudgetPtr budget = nullptr)
 {
     return Result{std::make_shared<MySQLResultImpl>(std::move(r),
                                                     affectedRows,
-                                                    insertId)};
+                                                    insertId,
+                                                    upstream,
+                                                    std::move(budget))};
 }
 
 
@@ -85,11 +126,31 @@ MySQLConnector::MySQLConnector(EventLoop *loop,
         {
             passwd_ = value;
         }
+        else if (key == "socket")
+        {
+            socket_ = value;
+        }
         else if (key == "client_encoding")
         {
             characterSet_ = value;
         }
+        else if (key == "max_execution_time_hint")
+        {
+            executionTimeHint_ = value == "1" || value == "true";
+        }
+        else if (key == "detach_results")
+        {
+            detachResults_ = value == "1" || value == "true";
+        }
+        else if (key == "max_result_bytes")
+        {
+            std::from_chars(value.data(),
+                            value.data() + value.size(),
+                            maxResultBytes_);
+        }
     }
+    fastEscape_ = isEscapeSafeCharset(characterSet_);
+    socket_ = resolveUnixSocket(host_, socket_);
 }
 void MySQLConnector::init()
 {
@@ -98,7 +159,8 @@ void MySQLConnector::init()
         status_ = ConnectStatus::Connecting;
         ABSL_LOG(INFO) << "Connecting to MySQL server: "
                   << "host=" << host_ << ", user=" << user_
-                  << ", dbname=" << dbname_ << ", port=" << port_;
+                  << ", dbname=" << dbname_ << ", port=" << port_
+                  << ", socket=" << socket_;
 
         // 设置超时选项（使用正确的方法）
         unsigned int timeout = 10; // 10 seconds timeout
@@ -114,7 +176,7 @@ void MySQLConnector::init()
                                               passwd_.empty() ? nullptr : passwd_.c_str(),
                                               dbname_.empty() ? nullptr : dbname_.c_str(),
                                               port_.empty() ? 3306 : atol(port_.c_str()),
-                                              nullptr,
+                                              socket_.empty() ? nullptr : socket_.c_str(),
                                               0);
 
         // 检查连接状态
@@ -160,11 +222,17 @@ void MySQLConnector::execSql(std::string_view&& sql, size_t paraNum, std::vector
     ABSL_LOG(INFO) << "Executing SQL: " << sql;
     if (loop_->isInLoopThread())
     {
+        assert(paraNum == parameters.size());
+        assert(paraNum == length.size());
+        assert(paraNum == format.size());
         execSqlInLoop(std::move(sql),
                       paraNum,
-                      std::move(parameters),
-                      std::move(length),
-                      std::move(format),
+                      parameters.data(),
+                      length.data(),
+                      format.data(),
+                      0.0,
+                      nullptr,
+                      0,
                       std::move(rcb),
                       std::move(exceptCallback));
     }
@@ -182,15 +250,60 @@ void MySQLConnector::execSql(std::string_view&& sql, size_t paraNum, std::vector
              exceptCallback = std::move(exceptCallback)]() mutable {
                 thisPtr->execSqlInLoop(std::move(sql),
                                        paraNum,
-                                       std::move(parameters),
-                                       std::move(length),
-                                       std::move(format),
+                                       parameters.data(),
+                                       length.data(),
+                                       format.data(),
+                                       0.0,
+                                       nullptr,
+                                       0,
                                        std::move(rcb),
                                        std::move(exceptCallback));
             });
     }
 }
 
+void MySQLConnector::execSql(std::string_view &&sql,
+                             SqlBinderPtr &&binder,
+                             ResultCallback &&rcb,
+                             ExceptPtrCallback &&exceptCallback)
+{
+    ABSL_LOG(INFO) << "Executing SQL: " << sql;
+    if (loop_->isInLoopThread())
+    {
+        execSqlInLoop(std::move(sql),
+                      binder->size(),
+                      binder->parameters(),
+                      binder->lengths(),
+                      binder->formats(),
+                      binder->timeout(),
+                      binder->resultResource(),
+                      binder->maxResultBytes(),
+                      std::move(rcb),
+                      std::move(exceptCallback));
+    }
+    else
+    {
+        auto thisPtr = shared_from_this();
+        loop_->queueInLoop([thisPtr,
+                            sql = std::move(sql),
+                            binder = std::move(binder),
+                            rcb = std::move(rcb),
+                            exceptCallback =
+                                std::move(exceptCallback)]() mutable {
+            thisPtr->execSqlInLoop(std::move(sql),
+                                   binder->size(),
+                                   binder->parameters(),
+                                   binder->lengths(),
+                                   binder->formats(),
+                                   binder->timeout(),
+                                   binder->resultResource(),
+                                   binder->maxResultBytes(),
+                                   std::move(rcb),
+                                   std::move(exceptCallback));
+        });
+    }
+}
+
 void MySQLConnector::batchSql(std::deque<std::shared_ptr<SqlCmd>>&&)
 {
     ABSL_LOG(FATAL) << "The mysql library does not support batch mode";
@@ -227,6 +340,11 @@ void MySQLConnector::setEventDispatcher()
     }
 }
 
+MySQLConnector::~MySQLConnector()
+{
+    releaseStreamedResult();
+}
+
 void MySQLConnector::handleClosed()
 {
     loop_->assertInLoopThread();
@@ -235,6 +353,7 @@ void MySQLConnector::handleClosed()
     status_ = ConnectStatus::Bad;
     eventDispatcherPtr_->disableAll();
     eventDispatcherPtr_->remove();
+    releaseStreamedResult();
     assert(closeCallback_);
     auto thisPtr = shared_from_this();
     closeCallback_(thisPtr);
@@ -249,6 +368,8 @@ void MySQLConnector::disconnect()
         thisPtr->status_ = ConnectStatus::Bad;
         thisPtr->eventDispatcherPtr_->disableAll();
         thisPtr->eventDispatcherPtr_->remove();
+        // MYSQL_RES引用着MYSQL，必须在关闭连接之前释放
+        thisPtr->releaseStreamedResult();
         thisPtr->mysqlPtr_.reset();
         pro.set_value(1);
     });
@@ -315,11 +436,11 @@ void MySQLConnector::handleCmd(int status)
                 if (err)
                 {
                     execStatus_ = ExecStatus::None;
-                    ABSL_LOG(FATAL) << "error:" << err << " status:" << status;
+                    ABSL_LOG(ERROR) << "error:" << err << " status:" << status;
                     outputError();
                     return;
                 }
-                startStoreResult(false);
+                startReadResult(false);
             }
             setEventDispatcher();
             break;
@@ -335,7 +456,7 @@ void MySQLConnector::handleCmd(int status)
                 if (!ret && mysql_errno(mysqlPtr_.get()))
                 {
                     execStatus_ = ExecStatus::None;
-                    ABSL_LOG(FATAL) << "error";
+                    ABSL_LOG(ERROR) << "error";
                     outputError();
                     return;
                 }
@@ -344,6 +465,15 @@ void MySQLConnector::handleCmd(int status)
             setEventDispatcher();
             break;
         }
+        case ExecStatus::FetchRow:
+        {
+            MYSQL_ROW row;
+            waitStatus_ = mysql_fetch_row_cont(&row, streamResult_, status);
+            if (!fetchRows(row, false))
+                return;
+            setEventDispatcher();
+            break;
+        }
         case ExecStatus::NextResult:
         {
             int err;
@@ -353,11 +483,11 @@ void MySQLConnector::handleCmd(int status)
                 if (err)
                 {
                     execStatus_ = ExecStatus::None;
-                    ABSL_LOG(FATAL) << "error:" << err << " status:" << status;
+                    ABSL_LOG(ERROR) << "error:" << err << " status:" << status;
                     outputError();
                     return;
                 }
-                startStoreResult(false);
+                startReadResult(false);
             }
             setEventDispatcher();
             break;
@@ -484,95 +614,77 @@ void MySQLConnector::startSetCharacterSet()
 void MySQLConnector::execSqlInLoop(
     std::string_view &&sql,
     size_t paraNum,
-    std::vector<const char *> &&parameters,
-    std::vector<int> &&length,
-    std::vector<int> &&format,
+    const char *const *parameters,
+    const int *length,
+    const int *format,
+    double timeout,
+    std::pmr::memory_resource *resultResource,
+    size_t maxResultBytes,
     ResultCallback &&rcb,
     std::function<void(const std::exception_ptr &)> &&exceptCallback)
 {
     ABSL_LOG(INFO) << sql;
-    assert(paraNum == parameters.size());
-    assert(paraNum == length.size());
-    assert(paraNum == format.size());
     assert(rcb);
     assert(!isWorking_);
     assert(!sql.empty());
 
+    SqlTemplatePtr sqlTemplate;
+    if (paraNum > 0)
+    {
+        sqlTemplate = SqlTemplate::get(sql);
+        if (sqlTemplate->placeholders() != paraNum)
+        {
+            ABSL_LOG(ERROR) << "The number of placeholders("
+                            << sqlTemplate->placeholders()
+                            << ") does not match the number of parameters("
+                            << paraNum << "): " << sql;
+            if (exceptCallback)
+                exceptCallback(std::make_exception_ptr(ArgumentError(
+                    "The number of placeholders does not match the number "
+                    "of parameters")));
+            idleCb_();
+            return;
+        }
+    }
+
     callback_ = std::move(rcb);
     isWorking_ = true;
+    resultResource_ = resultResource ? resultResource
+                      : detachResults_ ? std::pmr::get_default_resource()
+                                       : nullptr;
+    queryMaxResultBytes_ = maxResultBytes > 0 ? maxResultBytes : maxResultBytes_;
+    streaming_ = queryMaxResultBytes_ > 0 || resultBudget_->limit() > 0;
     exceptionCallback_ = std::move(exceptCallback);
+    if (sql_.capacity() > kMaxRetainedSqlBuffer)
+        std::string().swap(sql_);
     sql_.clear();
     if (paraNum > 0)
     {
-        std::string::size_type pos = 0;
-        std::string::size_type seekPos = std::string::npos;
-        for (size_t i = 0; i < paraNum; ++i)
-        {
-            seekPos = sql.find('?', pos);
-            if (seekPos == std::string::npos)
-            {
-                auto sub = sql.substr(pos);
-                sql_.append(sub.data(), sub.length());
-                pos = seekPos;
-                break;
-            }
-            else
-            {
-                auto sub = sql.substr(pos, seekPos - pos);
-                sql_.append(sub.data(), sub.length());
-                pos = seekPos + 1;
-                switch (format[i])
-                {
-                case cxk::type::MySqlTiny:
-                        sql_.append(std::to_string(*((char*)parameters[i])));
-                        break;
-                    case cxk::type::MySqlShort:
-                        sql_.append(std::to_string(*((short *)parameters[i])));
-                        break;
-                    case cxk::type::MySqlLong:
-                        sql_.append(
-                            std::to_string(*((int32_t *)parameters[i])));
-                        break;
-                    case cxk::type::MySqlLongLong:
-                        sql_.append(
-                            std::to_string(*((int64_t *)parameters[i])));
-                        break;
-                    case cxk::type::MySqlNull:
-                        sql_.append("NULL");
-                        break;
-                    case cxk::type::MySqlString:
-                    {
-                        sql_.append("'");
-                        std::string to(length[i] * 2, '\0');
-                        auto len = mysql_real_escape_string(mysqlPtr_.get(),
-                                                            (char *)to.c_str(),
-                                                            parameters[i],
-                                                            length[i]);
-                        to.resize(len);
-                        sql_.append(to);
-                        sql_.append("'");
-                    }
-                    break;
-                    case cxk::type::DrogonDefaultValue:
-                        sql_.append("default");
-                        break;
-                    default:
-                        ABSL_LOG(FATAL)
-                            << "MySQL does not recognize the parameter type";
-                        abort();
-                        break;
-                }
-            }
-        }
-        if (pos < sql.length())
-        {
-            auto sub = sql.substr(pos);
-            sql_.append(sub.data(), sub.length());
-        }
+        // NO_BACKSLASH_ESCAPES模式下只能交给libmariadb转义
+        bindParameters(sql_,
+                       mysqlPtr_.get(),
+                       fastEscape_ && !(mysqlPtr_->server_status &
+                                        SERVER_STATUS_NO_BACKSLASH_ESCAPES),
+                       *sqlTemplate,
+                       parameters,
+                       length,
+                       format);
     }
     else
     {
-        sql_ = std::string(sql.data(), sql.length());
+        sql_.assign(sql.data(), sql.length());
+    }
+    ++queryId_;
+    if (timeout > 0)
+    {
+        if (executionTimeHint_)
+            insertExecutionTimeHint(sql_, timeout);
+        std::weak_ptr<MySQLConnector> weakPtr = shared_from_this();
+        timeoutTimer_ = loop_->runAfter(timeout, [weakPtr, id = queryId_]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->handleQueryTimeout(id);
+        });
     }
     ABSL_LOG(INFO) << "Prepared SQL: " << sql_;
     startQuery();
@@ -583,22 +695,28 @@ void MySQLConnector::outputError()
 {
     eventDispatcherPtr_->disableAll();
     auto errorNo = mysql_errno(mysqlPtr_.get());
-    ABSL_LOG(FATAL) << "Error(" << errorNo << ") [" << mysql_sqlstate(mysqlPtr_.get())
+    ABSL_LOG(ERROR) << "Error(" << errorNo << ") [" << mysql_sqlstate(mysqlPtr_.get())
               << "] \"" << mysql_error(mysqlPtr_.get()) << "\"";
-    ABSL_LOG(FATAL) << "sql:" << sql_;
+    ABSL_LOG(ERROR) << "sql:" << sql_;
     if (isWorking_)
     {
-        // TODO: exception type
-        auto exceptPtr = std::make_exception_ptr(
-            SqlError(mysql_error(mysqlPtr_.get()), sql_));
-        exceptionCallback_(exceptPtr);
-        exceptionCallback_ = nullptr;
-
-        callback_ = nullptr;
-        isWorking_ = false;
+        // 放弃的语句已经回调过异常，被KILL中断产生的错误不再通知
+        if (!abandoned_)
+        {
+            // TODO: exception type
+            auto exceptPtr = std::make_exception_ptr(
+                SqlError(mysql_error(mysqlPtr_.get()), sql_));
+            exceptionCallback_(exceptPtr);
+        }
         if (errorNo != CR_SERVER_GONE_ERROR && errorNo != CR_SERVER_LOST)
         {
-            idleCb_();
+            finishQuery();
+        }
+        else
+        {
+            exceptionCallback_ = nullptr;
+            callback_ = nullptr;
+            isWorking_ = false;
         }
     }
     if (errorNo == CR_SERVER_GONE_ERROR || errorNo == CR_SERVER_LOST)
@@ -623,15 +741,23 @@ void MySQLConnector::startQuery()
     {
         if (err)
         {
-            ABSL_LOG(FATAL) << "error";
+            ABSL_LOG(ERROR) << "error";
             loop_->queueInLoop(
                 [thisPtr = shared_from_this()] { thisPtr->outputError(); });
             return;
         }
-        startStoreResult(true);
+        startReadResult(true);
     }
 }
 
+void MySQLConnector::startReadResult(bool queueInLoop)
+{
+    if (streaming_)
+        startUseResult(queueInLoop);
+    else
+        startStoreResult(queueInLoop);
+}
+
 void MySQLConnector::startStoreResult(bool queueInLoop)
 {
     MYSQL_RES *ret;
@@ -672,18 +798,148 @@ void MySQLConnector::getResult(MYSQL_RES *res)
     auto resultPtr = std::shared_ptr<MYSQL_RES>(res, [](MYSQL_RES *r) {
         mysql_free_result(r);
     });
-    auto Result = makeResult(std::move(resultPtr),
-                             mysql_affected_rows(mysqlPtr_.get()),
-                             mysql_insert_id(mysqlPtr_.get()));
+    handleResult(makeResult(std::move(resultPtr),
+                            mysql_affected_rows(mysqlPtr_.get()),
+                            mysql_insert_id(mysqlPtr_.get()),
+                            resultResource_,
+                            resultBudget_));
+}
+
+void MySQLConnector::startUseResult(bool queueInLoop)
+{
+    // mysql_use_result只处理已经读到的列信息，没有网络交互，不需要非阻塞版本
+    auto res = mysql_use_result(mysqlPtr_.get());
+    if (!res)
+    {
+        execStatus_ = ExecStatus::None;
+        bool failed = mysql_errno(mysqlPtr_.get()) != 0;
+        if (queueInLoop)
+        {
+            loop_->queueInLoop([thisPtr = shared_from_this(), failed] {
+                if (failed)
+                    thisPtr->outputError();
+                else
+                    thisPtr->getResult(nullptr);
+            });
+        }
+        else if (failed)
+        {
+            outputError();
+        }
+        else
+        {
+            getResult(nullptr);
+        }
+        return;
+    }
+    execStatus_ = ExecStatus::FetchRow;
+    streamResult_ = res;
+    // 已经放弃的语句的后续结果集只读出丢弃
+    if (!abandoned_)
+        streamedRows_.emplace(MySQLResultImpl::metadataOf(res), resultResource_);
+    MYSQL_ROW row;
+    waitStatus_ = mysql_fetch_row_start(&row, res);
+    fetchRows(row, queueInLoop);
+}
+
+bool MySQLConnector::fetchRows(MYSQL_ROW row, bool queueInLoop)
+{
+    // waitStatus_为0时row是刚读到的行，处理完已经到达的行再等待下一次可读
+    while (waitStatus_ == 0)
+    {
+        if (!row)
+            return finishUseResult(queueInLoop);
+        if (streamedRows_)
+            appendStreamedRow(row);
+        waitStatus_ = mysql_fetch_row_start(&row, streamResult_);
+    }
+    return true;
+}
+
+void MySQLConnector::appendStreamedRow(MYSQL_ROW row)
+{
+    streamedRows_->append(row, mysql_fetch_lengths(streamResult_));
+    auto bytes = streamedRows_->bytes();
+    if (queryMaxResultBytes_ > 0 && bytes > queryMaxResultBytes_)
+    {
+        ABSL_LOG(WARNING) << "The result exceeds the statement memory limit("
+                          << queryMaxResultBytes_ << " bytes): " << sql_;
+        abandonQuery(std::make_exception_ptr(
+            ResultTooLarge("The result exceeds the statement memory limit")));
+        return;
+    }
+    if (bytes <= reservedBytes_)
+        return;
+    auto needed = bytes - reservedBytes_;
+    auto step = std::max(needed, kBudgetReserveStep);
+    if (!resultBudget_->tryReserve(step))
+    {
+        step = needed;
+        if (!resultBudget_->tryReserve(step))
+        {
+            ABSL_LOG(WARNING) << "The result exceeds the pool memory limit("
+                              << resultBudget_->limit() << " bytes): " << sql_;
+            abandonQuery(std::make_exception_ptr(
+                ResultTooLarge("The result exceeds the pool memory limit")));
+            return;
+        }
+    }
+    reservedBytes_ += step;
+}
+
+bool MySQLConnector::finishUseResult(bool queueInLoop)
+{
+    execStatus_ = ExecStatus::None;
+    bool failed = mysql_errno(mysqlPtr_.get()) != 0;
+    // 行已经全部读出（或连接出错），释放时不再有网络交互
+    mysql_free_result(streamResult_);
+    streamResult_ = nullptr;
+    if (failed)
+    {
+        resultBudget_->release(reservedBytes_);
+        reservedBytes_ = 0;
+        streamedRows_.reset();
+        if (queueInLoop)
+            loop_->queueInLoop(
+                [thisPtr = shared_from_this()] { thisPtr->outputError(); });
+        else
+            outputError();
+        return false;
+    }
+    Result result = makeResult();
+    if (streamedRows_)
+    {
+        result = Result{std::make_shared<MySQLResultImpl>(
+            std::move(*streamedRows_),
+            mysql_affected_rows(mysqlPtr_.get()),
+            mysql_insert_id(mysqlPtr_.get()),
+            resultBudget_,
+            reservedBytes_)};
+        reservedBytes_ = 0;
+        streamedRows_.reset();
+    }
+    if (queueInLoop)
+    {
+        loop_->queueInLoop([thisPtr = shared_from_this(), result] {
+            thisPtr->handleResult(result);
+        });
+    }
+    else
+    {
+        handleResult(result);
+    }
+    return true;
+}
+
+void MySQLConnector::handleResult(const Result &result)
+{
     if (isWorking_)
     {
-        callback_(Result);
+        if (!abandoned_)
+            callback_(result);
         if (!mysql_more_results(mysqlPtr_.get()))
         {
-            callback_ = nullptr;
-            exceptionCallback_ = nullptr;
-            isWorking_ = false;
-            idleCb_();
+            finishQuery();
         }
         else
         {
@@ -695,12 +951,212 @@ void MySQLConnector::getResult(MYSQL_RES *res)
                 if (err)
                 {
                     execStatus_ = ExecStatus::None;
-                    ABSL_LOG(FATAL) << "error:" << err;
+                    ABSL_LOG(ERROR) << "error:" << err;
                     outputError();
                     return;
                 }
-                startStoreResult(false);
+                startReadResult(false);
             }
         }
     }
 }
+
+void MySQLConnector::finishQuery()
+{
+    callback_ = nullptr;
+    exceptionCallback_ = nullptr;
+    isWorking_ = false;
+    if (timeoutTimer_ != InvalidTimerId)
+    {
+        loop_->invalidateTimer(timeoutTimer_);
+        timeoutTimer_ = InvalidTimerId;
+    }
+    // KILL QUERY还没有执行时不能接受新语句，否则可能中断的是下一条语句
+    if (killPending_)
+        return;
+    abandoned_ = false;
+    idleCb_();
+}
+
+void MySQLConnector::handleQueryTimeout(uint64_t queryId)
+{
+    if (queryId != queryId_ || !isWorking_ || abandoned_)
+        return;
+    timeoutTimer_ = InvalidTimerId;
+    ABSL_LOG(WARNING) << "SQL execution timeout: " << sql_;
+    abandonQuery(
+        std::make_exception_ptr(TimeoutError("SQL execution timeout")));
+}
+
+void MySQLConnector::abandonQuery(std::exception_ptr exception)
+{
+    abandoned_ = true;
+    // 已经读到的行不再需要，马上归还内存
+    if (streamedRows_)
+    {
+        streamedRows_.reset();
+        resultBudget_->release(reservedBytes_);
+        reservedBytes_ = 0;
+    }
+    auto exceptionCallback = std::move(exceptionCallback_);
+    exceptionCallback_ = nullptr;
+    callback_ = nullptr;
+    if (killer_)
+    {
+        killPending_ = true;
+        std::weak_ptr<MySQLConnector> weakPtr = shared_from_this();
+        auto loop = loop_;
+        killer_->killQuery(mysql_thread_id(mysqlPtr_.get()),
+                           [weakPtr, loop]() {
+                               loop->queueInLoop([weakPtr]() {
+                                   auto thisPtr = weakPtr.lock();
+                                   if (thisPtr)
+                                       thisPtr->handleQueryKilled();
+                               });
+                           });
+    }
+    if (exceptionCallback)
+        exceptionCallback(exception);
+}
+
+void MySQLConnector::releaseStreamedResult()
+{
+    if (streamResult_)
+    {
+        // 连接已经不再使用，不让mysql_free_result把剩余的行从网络上读完
+        if (mysqlPtr_)
+            mysqlPtr_->status = MYSQL_STATUS_READY;
+        mysql_free_result(streamResult_);
+        streamResult_ = nullptr;
+        execStatus_ = ExecStatus::None;
+    }
+    streamedRows_.reset();
+    resultBudget_->release(reservedBytes_);
+    reservedBytes_ = 0;
+}
+
+void MySQLConnector::handleQueryKilled()
+{
+    killPending_ = false;
+    // 语句已经结束时由这里恢复空闲，否则等finishQuery()
+    if (abandoned_ && !isWorking_ && status_ == ConnectStatus::Ok)
+    {
+        abandoned_ = false;
+        idleCb_();
+    }
+}
+
+const std::string &MySQLConnector::localUnixSocket()
+{
+    static const std::string path = []() {
+        std::vector<std::string> candidates;
+        if (auto env = getenv("MYSQL_UNIX_PORT"))
+            candidates.emplace_back(env);
+        candidates.insert(candidates.end(),
+                          {"/run/mysqld/mysqld.sock",
+                           "/var/run/mysqld/mysqld.sock",
+                           "/var/lib/mysql/mysql.sock",
+                           "/tmp/mysql.sock"});
+        for (auto const &candidate : candidates)
+        {
+            struct stat st;
+            if (stat(candidate.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+                return candidate;
+        }
+        return std::string();
+    }();
+    return path;
+}
+
+std::string MySQLConnector::resolveUnixSocket(const std::string &host,
+                                              const std::string &socket)
+{
+    if (!socket.empty())
+        return socket;
+    // 127.0.0.1等地址表示调用者明确要求TCP
+    if (host.empty() || strcasecmp(host.c_str(), "localhost") == 0)
+        return localUnixSocket();
+    return std::string();
+}
+
+bool MySQLConnector::isEscapeSafeCharset(std::string charset)
+{
+    std::transform(charset.begin(),
+                   charset.end(),
+                   charset.begin(),
+                   [](unsigned char c) { return tolower(c); });
+    return charset == "utf8" || charset == "utf8mb4" ||
+           charset == "utf8mb3" || charset == "latin1" || charset == "ascii";
+}
+
+void MySQLConnector::bindParameters(std::string &out,
+                                    MYSQL *mysql,
+                                    bool fastEscape,
+                                    const SqlTemplate &sqlTemplate,
+                                    const char *const *parameters,
+                                    const int *length,
+                                    const int *format)
+{
+    auto paraNum = sqlTemplate.placeholders();
+    // 预先算出最终长度的上限，整个拼接过程最多只分配一次
+    size_t reserveSize = out.size() + sqlTemplate.sql().size();
+    for (size_t i = 0; i < paraNum; ++i)
+    {
+        reserveSize += format[i] == cxk::type::MySqlString
+                           ? static_cast<size_t>(length[i]) * 2 + 2
+                           : 20;
+    }
+    out.reserve(reserveSize);
+    for (size_t i = 0; i < paraNum; ++i)
+    {
+        auto fragment = sqlTemplate.fragment(i);
+        out.append(fragment.data(), fragment.size());
+        switch (format[i])
+        {
+            case cxk::type::MySqlTiny:
+                appendInteger(out, static_cast<int>(*((char *)parameters[i])));
+                break;
+            case cxk::type::MySqlShort:
+                appendInteger(out, *((short *)parameters[i]));
+                break;
+            case cxk::type::MySqlLong:
+                appendInteger(out, *((int32_t *)parameters[i]));
+                break;
+            case cxk::type::MySqlLongLong:
+                appendInteger(out, *((int64_t *)parameters[i]));
+                break;
+            case cxk::type::MySqlNull:
+                out.append("NULL");
+                break;
+            case cxk::type::MySqlString:
+            {
+                // 直接转义到out的尾部，不再经过临时字符串
+                out.push_back('\'');
+                auto offset = out.size();
+                out.resize(offset + length[i] * 2 + 1);
+                size_t len;
+                if (fastEscape)
+                    len = utils::escapeSqlString(parameters[i],
+                                                 length[i],
+                                                 &out[offset]);
+                else
+                    len = mysql_real_escape_string(mysql,
+                                                   &out[offset],
+                                                   parameters[i],
+                                                   length[i]);
+                out.resize(offset + len);
+                out.push_back('\'');
+            }
+            break;
+            case cxk::type::DrogonDefaultValue:
+                out.append("default");
+                break;
+            default:
+                ABSL_LOG(FATAL) << "MySQL does not recognize the parameter type";
+                abort();
+                break;
+        }
+    }
+    auto fragment = sqlTemplate.fragment(paraNum);
+    out.append(fragment.data(), fragment.size());
+}
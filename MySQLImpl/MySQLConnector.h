@@ -0,0 +1,248 @@
+/**
+ *
+ *  @file MySQLConnector.h
+ *  @author An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#ifndef MYSQLCONNECTOR_H
+#define MYSQLCONNECTOR_H
+#pragma once
+
+#include <db/DbConnection.h>
+#include <db/ResultMemoryBudget.h>
+#include <db/SqlTemplate.h>
+#include <event/EventDispatcher.h>
+#include <event/EventLoop.h>
+#include <NonCopyable.h>
+#include <mariadb/mysql.h>
+#include "MySQLResultImpl.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace cxk
+{
+/**
+ * @brief libmariadb全局环境，进程内只需初始化一次
+ */
+class MysqlEnv
+{
+  public:
+    MysqlEnv()
+    {
+        mysql_library_init(0, nullptr, nullptr);
+    }
+    ~MysqlEnv()
+    {
+        mysql_library_end();
+    }
+};
+
+/**
+ * @brief libmariadb线程环境，每个使用连接的线程初始化一次
+ */
+class MysqlThreadEnv
+{
+  public:
+    MysqlThreadEnv()
+    {
+        mysql_thread_init();
+    }
+    ~MysqlThreadEnv()
+    {
+        mysql_thread_end();
+    }
+};
+
+class MySQLQueryKiller;
+class MySQLConnector;
+using MySQLConnectorPtr = std::shared_ptr<MySQLConnector>;
+
+/**
+ * @brief 基于libmariadb非阻塞接口的MySQL连接
+ *
+ * 所有的网络交互都在所属EventLoop线程中完成，同一时刻只执行一条SQL
+ *
+ * 绑定对象设置了超时时间时，超时后立即以TimeoutError回调，并通过
+ * MySQLQueryKiller中断服务端上的语句；语句结束且KILL完成后连接重新变为空闲。
+ * 连接串中的socket指定unix socket路径；未指定且host为localhost时，
+ * 自动使用本机服务端的socket，避免经过TCP回环。
+ * 连接串中detach_results=1时，结果默认拷贝到arena中并立即释放MYSQL_RES
+ * （见MySQLResultImpl），绑定对象指定的resultResource优先。
+ * 连接串中max_execution_time_hint=1时，同时为SELECT加上MAX_EXECUTION_TIME提示。
+ *
+ * 结果占用的内存记在setResultBudget()设置的预算上。语句有结果内存上限
+ * （绑定对象的maxResultBytes，或连接串中的max_result_bytes=N），或预算本身
+ * 有上限时，结果不再用mysql_store_result整体缓冲，而是用mysql_use_result
+ * 逐行读取并记账；超出任一上限时立即以ResultTooLarge回调，已读的行随即释放，
+ * 并像超时一样通过MySQLQueryKiller中断语句，剩余的行读出后丢弃。
+ */
+class MySQLConnector : public DbConnection,
+                       public std::enable_shared_from_this<MySQLConnector>
+{
+  public:
+    MySQLConnector(EventLoop *loop, const std::string &connInfo);
+
+    ~MySQLConnector() override;
+
+    void init() override;
+
+    using DbConnection::execSql;
+
+    void execSql(
+        std::string_view &&sql,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback)
+        override;
+
+    void execSql(std::string_view &&sql,
+                 SqlBinderPtr &&binder,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback) override;
+
+    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&) override;
+
+    void disconnect() override;
+
+    /**
+     * @brief 设置语句超时时用于中断语句的控制连接，未设置时只回调TimeoutError，
+     * 连接要等到语句自然结束才重新变为空闲
+     */
+    void setQueryKiller(std::shared_ptr<MySQLQueryKiller> killer)
+    {
+        killer_ = std::move(killer);
+    }
+
+    /**
+     * @brief 设置结果占用内存的预算，未设置时记在ResultMemoryBudget::unbounded()上
+     */
+    void setResultBudget(ResultMemoryBudgetPtr budget)
+    {
+        resultBudget_ = std::move(budget);
+    }
+
+    /**
+     * @brief 按模板把参数拼接到out的尾部，参数数量必须等于模板的占位符数量
+     * @param fastEscape 为true时使用utils::escapeSqlString，否则交给libmariadb转义
+     */
+    static void bindParameters(std::string &out,
+                               MYSQL *mysql,
+                               bool fastEscape,
+                               const SqlTemplate &sqlTemplate,
+                               const char *const *parameters,
+                               const int *length,
+                               const int *format);
+
+    /**
+     * @brief 字符集是否与ASCII兼容，且多字节字符中不会出现反斜杠和引号，
+     * 满足时可以直接按字节转义
+     */
+    static bool isEscapeSafeCharset(std::string charset);
+
+    /**
+     * @brief 本机MySQL服务端的unix socket路径，找不到时返回空串
+     *
+     * 依次检查环境变量MYSQL_UNIX_PORT和常见的安装路径，结果在进程内缓存。
+     */
+    static const std::string &localUnixSocket();
+
+    /**
+     * @brief 连接时使用的unix socket：连接串指定了socket时直接使用，
+     * host为空或localhost时使用localUnixSocket()，否则返回空串（走TCP）
+     */
+    static std::string resolveUnixSocket(const std::string &host,
+                                         const std::string &socket);
+
+  private:
+    // 参数数组只在拼接SQL期间访问，返回后即可释放
+    void execSqlInLoop(
+        std::string_view &&sql,
+        size_t paraNum,
+        const char *const *parameters,
+        const int *length,
+        const int *format,
+        double timeout,
+        std::pmr::memory_resource *resultResource,
+        size_t maxResultBytes,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback);
+
+    std::unique_ptr<EventDispatcher> eventDispatcherPtr_;
+    std::shared_ptr<MYSQL> mysqlPtr_;
+    std::string characterSet_;
+    my_bool reconnect_{1};
+
+    void handleTimeout();
+    void handleClosed();
+    void handleEvent();
+    void handleCmd(int status);
+    void setEventDispatcher();
+    void getResult(MYSQL_RES *res);
+    void handleResult(const Result &result);
+    void startQuery();
+    void startReadResult(bool queueInLoop);
+    void startStoreResult(bool queueInLoop);
+    void startUseResult(bool queueInLoop);
+    bool fetchRows(MYSQL_ROW row, bool queueInLoop);
+    bool finishUseResult(bool queueInLoop);
+    void appendStreamedRow(MYSQL_ROW row);
+    void abandonQuery(std::exception_ptr exception);
+    void releaseStreamedResult();
+    void outputError();
+    void continueSetCharacterSet(int status);
+    void startSetCharacterSet();
+    void finishQuery();
+    void handleQueryTimeout(uint64_t queryId);
+    void handleQueryKilled();
+
+    int waitStatus_{0};
+
+    enum class ExecStatus
+    {
+        None = 0,
+        RealQuery,
+        StoreResult,
+        FetchRow,
+        NextResult
+    };
+    ExecStatus execStatus_{ExecStatus::None};
+
+    std::string sql_;  ///< 拼接后的SQL，在多次执行之间复用
+    bool fastEscape_{false};  ///< 字符集是否允许使用utils::escapeSqlString
+    std::string host_, user_, passwd_, dbname_, port_, socket_;
+
+    std::shared_ptr<MySQLQueryKiller> killer_;
+    bool executionTimeHint_{false};
+    bool detachResults_{false};
+    std::pmr::memory_resource *resultResource_{nullptr};  ///< 当前语句的结果内存资源
+    uint64_t queryId_{0};  ///< 每条语句递增，用于识别过期的超时定时器
+    TimerId timeoutTimer_{InvalidTimerId};
+    bool abandoned_{false};  ///< 当前语句已经以异常回调（超时或结果超出预算），结果不再回调
+    bool killPending_{false};  ///< KILL QUERY尚未执行完，连接不能接受新语句
+
+    ResultMemoryBudgetPtr resultBudget_{ResultMemoryBudget::unbounded()};
+    size_t maxResultBytes_{0};       ///< 连接串中的默认单条语句上限
+    size_t queryMaxResultBytes_{0};  ///< 当前语句的上限
+    bool streaming_{false};  ///< 当前语句的结果是否逐行读取
+    MYSQL_RES *streamResult_{nullptr};  ///< 正在逐行读取的结果集
+    std::optional<MySQLResultImpl::StreamedRows> streamedRows_;
+    size_t reservedBytes_{0};  ///< 读取中的结果已经在resultBudget_上占用的字节数
+};
+
+}  // namespace cxk
+
+#endif  // MYSQLCONNECTOR_H
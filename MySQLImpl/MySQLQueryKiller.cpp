@@ -0,0 +1,105 @@
+//
+// Created by cxk_zjq on 25-6-27.
+//
+
+#include "MySQLQueryKiller.h"
+#include "MySQLSyncConnector.h"
+#include "Exception.h"
+#include <db/SqlBinder.h>
+#include <absl/log/absl_log.h>
+
+using namespace cxk;
+
+MySQLQueryKiller::MySQLQueryKiller(const std::string &connInfo)
+    : connInfo_(connInfo)
+{
+}
+
+MySQLQueryKiller::~MySQLQueryKiller()
+{
+    // 先结束控制线程，再释放只在该线程中使用的连接
+    thread_.reset();
+}
+
+EventLoop *MySQLQueryKiller::loop()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!thread_)
+    {
+        thread_ = std::make_unique<EventLoopThread>("MySQLQueryKiller");
+        thread_->run();
+    }
+    return thread_->getLoop();
+}
+
+void MySQLQueryKiller::kill(unsigned long threadId)
+{
+    try
+    {
+        if (!conn_ || !conn_->connected())
+        {
+            conn_ = std::make_unique<MySQLSyncConnector>(connInfo_);
+            conn_->connect();
+        }
+        conn_->execSql("KILL QUERY " + std::to_string(threadId),
+                       VectorSqlBinder({}, {}, {}));
+    }
+    catch (const DrogonDbException &e)
+    {
+        // 语句可能恰好已经结束，这里只记录日志
+        ABSL_LOG(WARNING) << "Failed to kill query on thread " << threadId
+                          << ": " << e.base().what();
+    }
+}
+
+void MySQLQueryKiller::killQuery(unsigned long threadId,
+                                 std::function<void()> &&done)
+{
+    loop()->queueInLoop([this, threadId, done = std::move(done)]() {
+        kill(threadId);
+        done();
+    });
+}
+
+std::shared_ptr<MySQLQueryKiller::Deadline> MySQLQueryKiller::killQueryAfter(
+    unsigned long threadId,
+    double timeout)
+{
+    auto deadline = std::make_shared<Deadline>();
+    std::weak_ptr<Deadline> weakPtr = deadline;
+    deadline->timerId = loop()->runAfter(timeout, [this, threadId, weakPtr]() {
+        auto statePtr = weakPtr.lock();
+        if (!statePtr)
+            return;
+        {
+            std::lock_guard<std::mutex> guard(statePtr->mutex);
+            if (statePtr->finished)
+                return;
+            statePtr->killing = true;
+        }
+        kill(threadId);
+        {
+            std::lock_guard<std::mutex> guard(statePtr->mutex);
+            statePtr->killing = false;
+            statePtr->killed = true;
+        }
+        statePtr->cond.notify_all();
+    });
+    return deadline;
+}
+
+bool MySQLQueryKiller::finish(const std::shared_ptr<Deadline> &deadline)
+{
+    TimerId timerId;
+    bool killed;
+    {
+        std::unique_lock<std::mutex> guard(deadline->mutex);
+        deadline->finished = true;
+        deadline->cond.wait(guard, [&deadline]() { return !deadline->killing; });
+        timerId = deadline->timerId;
+        killed = deadline->killed;
+    }
+    if (!killed)
+        loop()->invalidateTimer(timerId);
+    return killed;
+}
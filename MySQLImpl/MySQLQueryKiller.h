@@ -0,0 +1,79 @@
+//
+// Created by cxk_zjq on 25-6-27.
+//
+
+#ifndef MYSQLQUERYKILLER_H
+#define MYSQLQUERYKILLER_H
+
+#include <event/EventLoopThread.h>
+#include <NonCopyable.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace cxk
+{
+class MySQLSyncConnector;
+
+/**
+ * @brief 通过一个独立的控制连接执行KILL QUERY
+ *
+ * 语句超时后，数据连接本身正阻塞在等待结果上，只能由另一个连接通知服务端中断它。
+ * 控制连接和它所在的线程在第一次使用时才创建，断开后下次使用时重新建立。
+ */
+class MySQLQueryKiller : public NonCopyable
+{
+  public:
+    explicit MySQLQueryKiller(const std::string &connInfo);
+    ~MySQLQueryKiller();
+
+    /**
+     * @brief 中断服务端线程threadId上正在执行的语句
+     * @param done 在控制线程中调用，无论KILL是否成功
+     */
+    void killQuery(unsigned long threadId, std::function<void()> &&done);
+
+    /**
+     * @brief 阻塞执行的语句的截止时间，在执行线程和控制线程之间共享
+     */
+    struct Deadline
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        TimerId timerId{InvalidTimerId};
+        bool finished{false};  ///< 语句已经结束，不再中断
+        bool killing{false};   ///< KILL正在发出
+        bool killed{false};    ///< 发出过KILL
+    };
+
+    /**
+     * @brief timeout秒后中断threadId上的语句，供阻塞连接使用
+     *
+     * 语句结束后必须调用finish()。
+     */
+    std::shared_ptr<Deadline> killQueryAfter(unsigned long threadId,
+                                             double timeout);
+
+    /**
+     * @brief 语句结束时调用，取消定时器并等待已经发出的KILL完成
+     *
+     * 返回后不会再有针对该语句的KILL，不会误伤连接上的下一条语句。
+     * @return 是否中断过该语句
+     */
+    bool finish(const std::shared_ptr<Deadline> &deadline);
+
+  private:
+    EventLoop *loop();
+    void kill(unsigned long threadId);  ///< 只在控制线程中调用
+
+    std::string connInfo_;
+    std::unique_ptr<MySQLSyncConnector> conn_;  ///< 只在控制线程中访问
+    std::mutex mutex_;
+    std::unique_ptr<EventLoopThread> thread_;
+};
+
+}  // namespace cxk
+
+#endif  // MYSQLQUERYKILLER_H
@@ -15,48 +15,263 @@
 #include "MySQLResultImpl.h"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <db/Exception.h>
 
 using namespace cxk;
 
-MySQLResultImpl::MySQLResultImpl(std::shared_ptr<MYSQL_RES> r, SizeType affectedRows, unsigned long long insertId) noexcept
-: result_(std::move(r)),
-          rowsNumber_(result_ ? mysql_num_rows(result_.get()) : 0),
-          fieldArray_(result_ ? mysql_fetch_fields(result_.get()) : nullptr),
-          fieldsNumber_(result_ ? mysql_num_fields(result_.get()) : 0),
-          affectedRows_(affectedRows),
-          insertId_(insertId)
+namespace
 {
-    if (fieldsNumber_ > 0)
+// 字符集编号63是binary，用来区分BLOB/BINARY与TEXT/CHAR
+constexpr unsigned int kBinaryCharset = 63;
+// MYSQL_RES中每行的链表节点（next、data、length）
+constexpr size_t kStoredRowOverhead = 3 * sizeof(void *);
+
+ColumnKind columnKindOf(const MYSQL_FIELD &field)
+{
+    switch (field.type)
     {
-        fieldsMapPtr_ = std::make_shared<
-            std::unordered_map<std::string, RowSizeType>>();
-        for (RowSizeType i = 0; i < fieldsNumber_; ++i)
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+            return (field.flags & UNSIGNED_FLAG) ? ColumnKind::UnsignedInteger
+                                                 : ColumnKind::Integer;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            return ColumnKind::Real;
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+            return ColumnKind::Decimal;
+        case MYSQL_TYPE_DATE:
+        case MYSQL_TYPE_NEWDATE:
+            return ColumnKind::Date;
+        case MYSQL_TYPE_TIME:
+        case MYSQL_TYPE_TIME2:
+            return ColumnKind::Time;
+        case MYSQL_TYPE_DATETIME:
+        case MYSQL_TYPE_DATETIME2:
+        case MYSQL_TYPE_TIMESTAMP:
+        case MYSQL_TYPE_TIMESTAMP2:
+            return ColumnKind::DateTime;
+        case MYSQL_TYPE_BIT:
+            return ColumnKind::Bit;
+        case MYSQL_TYPE_JSON:
+            return ColumnKind::Json;
+        case MYSQL_TYPE_GEOMETRY:
+            return ColumnKind::Binary;
+        case MYSQL_TYPE_NULL:
+            return ColumnKind::Unknown;
+        default:
+            return field.charsetnr == kBinaryCharset ? ColumnKind::Binary
+                                                     : ColumnKind::String;
+    }
+}
+}  // namespace
+
+MySQLResultImpl::StreamedRows::StreamedRows(ColumnMetadataPtr metadata,
+                                           std::pmr::memory_resource *upstream)
+    : arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(
+          upstream ? upstream : std::pmr::get_default_resource())),
+      metadata_(std::move(metadata)),
+      fieldsNumber_(metadata_ ? metadata_->size() : 0)
+{
+}
+
+void MySQLResultImpl::StreamedRows::append(MYSQL_ROW row,
+                                           const unsigned long *lengths)
+{
+    size_t total = 0;
+    for (RowSizeType i = 0; i < fieldsNumber_; ++i)
+    {
+        if (row[i])
+            total += lengths[i] + 1;
+    }
+    // 一行的字段值在arena中连续存放，每个后面补'\0'
+    auto buffer = total ? static_cast<char *>(arena_->allocate(total, 1))
+                        : nullptr;
+    for (RowSizeType i = 0; i < fieldsNumber_; ++i)
+    {
+        lengths_.push_back(lengths[i]);
+        if (!row[i])
         {
-            std::string fieldName = fieldArray_[i].name;
-            std::transform(fieldName.begin(),
-                           fieldName.end(),
-                           fieldName.begin(),
-                           [](unsigned char c) { return tolower(c); });
-            (*fieldsMapPtr_)[fieldName] = i;
+            values_.push_back(nullptr);
+            continue;
         }
+        memcpy(buffer, row[i], lengths[i]);
+        buffer[lengths[i]] = '\0';
+        values_.push_back(buffer);
+        buffer += lengths[i] + 1;
+    }
+    dataBytes_ += total;
+    ++rowsNumber_;
+}
+
+MySQLResultImpl::MySQLResultImpl(std::shared_ptr<MYSQL_RES> r,
+                                 SizeType affectedRows,
+                                 unsigned long long insertId,
+                                 std::pmr::memory_resource *upstream,
+                                 ResultMemoryBudgetPtr budget) noexcept
+    : result_(std::move(r)),
+      rowsNumber_(result_ ? mysql_num_rows(result_.get()) : 0),
+      fieldsNumber_(result_ ? mysql_num_fields(result_.get()) : 0),
+      affectedRows_(affectedRows),
+      insertId_(insertId),
+      arena_(upstream
+                 ? std::make_unique<std::pmr::monotonic_buffer_resource>(upstream)
+                 : nullptr),
+      values_(arena_ ? arena_.get() : std::pmr::get_default_resource()),
+      lengths_(arena_ ? arena_.get() : std::pmr::get_default_resource())
+{
+    if (fieldsNumber_ > 0)
+        metadata_ = metadataOf(result_.get());
+    budget_ = budget ? std::move(budget) : ResultMemoryBudget::unbounded();
+    charge(rowsNumber_ * (kStoredRowOverhead +
+                          (fieldsNumber_ + 1) * sizeof(char *)));
+    if (arena_ && result_)
+    {
+        // 马上要释放MYSQL_RES，只能一次建好全部索引
+        indexAll();
+        copyToArena();
+    }
+}
+
+MySQLResultImpl::MySQLResultImpl(StreamedRows &&rows,
+                                 SizeType affectedRows,
+                                 unsigned long long insertId,
+                                 ResultMemoryBudgetPtr budget,
+                                 size_t reservedBytes) noexcept
+    : rowsNumber_(rows.rowsNumber_),
+      fieldsNumber_(rows.fieldsNumber_),
+      affectedRows_(affectedRows),
+      insertId_(insertId),
+      arena_(std::move(rows.arena_)),
+      metadata_(std::move(rows.metadata_)),
+      values_(std::move(rows.values_)),
+      lengths_(std::move(rows.lengths_)),
+      indexedRows_(rows.rowsNumber_),
+      budget_(budget ? std::move(budget) : ResultMemoryBudget::unbounded()),
+      chargedBytes_(reservedBytes)
+{
+    // rows中的容器已经移走，按接管后的容量计算
+    auto bytes = rows.dataBytes_ + values_.capacity() * sizeof(const char *) +
+                 lengths_.capacity() * sizeof(unsigned long);
+    if (bytes > chargedBytes_)
+        charge(bytes - chargedBytes_);
+    else
+    {
+        budget_->release(chargedBytes_ - bytes);
+        chargedBytes_ = bytes;
+    }
+}
+
+MySQLResultImpl::~MySQLResultImpl()
+{
+    budget_->release(chargedBytes_);
+}
+
+ColumnMetadataPtr MySQLResultImpl::metadataOf(MYSQL_RES *result)
+{
+    auto fieldsNumber = mysql_num_fields(result);
+    if (fieldsNumber == 0)
+        return nullptr;
+    auto fieldArray = mysql_fetch_fields(result);
+    // 只在本线程内复用，避免每个结果都分配一次描述数组
+    thread_local std::vector<ColumnDesc> columns;
+    columns.clear();
+    for (RowSizeType i = 0; i < fieldsNumber; ++i)
+    {
+        columns.push_back({std::string_view(fieldArray[i].name,
+                                            fieldArray[i].name_length),
+                           static_cast<int>(fieldArray[i].type),
+                           fieldArray[i].flags,
+                           columnKindOf(fieldArray[i])});
     }
-    if (size() > 0)
+    return ColumnMetadata::get(columns.data(), columns.size());
+}
+
+void MySQLResultImpl::charge(size_t bytes) const
+{
+    budget_->reserve(bytes);
+    chargedBytes_ += bytes;
+}
+
+void MySQLResultImpl::indexRows(SizeType row) const
+{
+    if (row < indexedRows_.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock(indexMutex_);
+    auto indexed = indexedRows_.load(std::memory_order_relaxed);
+    if (row < indexed)
+        return;
+    if (indexed == 0)
+    {
+        // 行数在mysql_store_result之后已知，第一次访问时按精确大小一次分配。
+        // 此时还没有读者越过快速路径，可以安全地改变数组
+        values_.resize(rowsNumber_ * fieldsNumber_);
+        lengths_.resize(rowsNumber_ * fieldsNumber_);
+        charge(values_.size() *
+               (sizeof(const char *) + sizeof(unsigned long)));
+    }
+    auto target = std::min<SizeType>(rowsNumber_,
+                                     (row / kIndexChunkRows + 1) * kIndexChunkRows);
+    auto valueIter = values_.data() + indexed * fieldsNumber_;
+    auto lengthIter = lengths_.data() + indexed * fieldsNumber_;
+    size_t dataBytes = 0;
+    // 存储的结果集按游标顺序读取，不再访问连接，可以在任意线程进行
+    for (; indexed < target; ++indexed)
     {
-        rowsPtr_ = std::make_shared<
-            std::vector<std::pair<char **, std::vector<unsigned long>>>>();
-        MYSQL_ROW row;
-        std::vector<unsigned long> vLens;
-        vLens.resize(fieldsNumber_);
-        while ((row = mysql_fetch_row(result_.get())) != NULL)
+        MYSQL_ROW fetched = mysql_fetch_row(result_.get());
+        assert(fetched);
+        auto lengths = mysql_fetch_lengths(result_.get());
+        std::copy(fetched, fetched + fieldsNumber_, valueIter);
+        memcpy(lengthIter, lengths, sizeof(unsigned long) * fieldsNumber_);
+        for (RowSizeType i = 0; i < fieldsNumber_; ++i)
         {
-            auto lengths = mysql_fetch_lengths(result_.get());
-            memcpy(vLens.data(),
-                   lengths,
-                   sizeof(unsigned long) * fieldsNumber_);
-            rowsPtr_->push_back(std::make_pair(row, vLens));
+            if (fetched[i])
+                dataBytes += lengths[i] + 1;
         }
+        valueIter += fieldsNumber_;
+        lengthIter += fieldsNumber_;
     }
+    charge(dataBytes);
+    indexedDataBytes_ += dataBytes;
+    indexedRows_.store(indexed, std::memory_order_release);
+}
+
+void MySQLResultImpl::indexAll() const
+{
+    if (rowsNumber_ > 0 && fieldsNumber_ > 0)
+        indexRows(rowsNumber_ - 1);
+}
+
+void MySQLResultImpl::copyToArena()
+{
+    // 先算出总大小，所有字段值只占arena中的一块连续内存，列名已经在metadata_中
+    size_t total = 0;
+    for (size_t i = 0; i < values_.size(); ++i)
+    {
+        if (values_[i])
+            total += lengths_[i] + 1;
+    }
+    auto buffer = static_cast<char *>(arena_->allocate(total ? total : 1, 1));
+    for (size_t i = 0; i < values_.size(); ++i)
+    {
+        if (!values_[i])
+            continue;
+        memcpy(buffer, values_[i], lengths_[i]);
+        buffer[lengths_[i]] = '\0';
+        values_[i] = buffer;
+        buffer += lengths_[i] + 1;
+    }
+    result_.reset();
+    // arena中的字段值与建索引时计入的行数据等长，只归还MYSQL_RES的行结构
+    auto released =
+        rowsNumber_ * (kStoredRowOverhead + (fieldsNumber_ + 1) * sizeof(char *));
+    budget_->release(released);
+    chargedBytes_ -= released;
 }
 
 Result::SizeType MySQLResultImpl::size() const noexcept
@@ -72,9 +287,13 @@ Result::RowSizeType MySQLResultImpl::columns() const noexcept
 const char *MySQLResultImpl::columnName(RowSizeType number) const
 {
     assert(number < fieldsNumber_);
-    if (fieldArray_)
-        return fieldArray_[number].name;
-    return "";
+    return metadata_->name(number);
+}
+
+ColumnKind MySQLResultImpl::columnKind(RowSizeType number) const
+{
+    assert(number < fieldsNumber_);
+    return metadata_->kind(number);
 }
 
 Result::SizeType MySQLResultImpl::affectedRows() const noexcept
@@ -84,24 +303,20 @@ Result::SizeType MySQLResultImpl::affectedRows() const noexcept
 
 Result::RowSizeType MySQLResultImpl::columnNumber(const char colName[]) const
 {
-    if (!fieldsMapPtr_)
+    if (fieldsNumber_ == 0)
         return -1;
-    std::string col(colName);
-    std::transform(col.begin(), col.end(), col.begin(), [](unsigned char c) {
-        return tolower(c);
-    });
-    if (fieldsMapPtr_->find(col) != fieldsMapPtr_->end())
-        return (*fieldsMapPtr_)[col];
+    auto number = metadata_->find(colName);
+    if (number >= 0)
+        return static_cast<RowSizeType>(number);
     throw RangeError(std::string("no column named ") + colName);
 }
 
 const char *MySQLResultImpl::getValue(SizeType row, RowSizeType column) const
 {
-    if (rowsNumber_ == 0 || fieldsNumber_ == 0)
-        return NULL;
     assert(row < rowsNumber_);
     assert(column < fieldsNumber_);
-    return (*rowsPtr_)[row].first[column];
+    indexRows(row);
+    return values_[row * fieldsNumber_ + column];
 }
 
 bool MySQLResultImpl::isNull(SizeType row, RowSizeType column) const
@@ -112,14 +327,38 @@ bool MySQLResultImpl::isNull(SizeType row, RowSizeType column) const
 Result::FieldSizeType MySQLResultImpl::getLength(SizeType row,
                                                  RowSizeType column) const
 {
-    if (rowsNumber_ == 0 || fieldsNumber_ == 0)
-        return 0;
     assert(row < rowsNumber_);
     assert(column < fieldsNumber_);
-    return (*rowsPtr_)[row].second[column];
+    indexRows(row);
+    return lengths_[row * fieldsNumber_ + column];
 }
 
 unsigned long long MySQLResultImpl::insertId() const noexcept
 {
     return insertId_;
 }
+
+size_t MySQLResultImpl::memoryBytes() const
+{
+    if (result_ && rowsNumber_ > 0 && fieldsNumber_ > 0)
+        indexRows(0);
+    std::lock_guard<std::mutex> lock(indexMutex_);
+    auto indexed = indexedRows_.load(std::memory_order_relaxed);
+    auto bytes = chargedBytes_;
+    if (indexed > 0 && indexed < rowsNumber_)
+        bytes += static_cast<size_t>(static_cast<double>(indexedDataBytes_) /
+                                     indexed * (rowsNumber_ - indexed));
+    return bytes;
+}
+
+bool MySQLResultImpl::columnCells(RowSizeType column, ColumnCells &cells) const
+{
+    assert(column < fieldsNumber_);
+    if (rowsNumber_ == 0 || fieldsNumber_ == 0)
+        return false;
+    indexAll();
+    cells.values = values_.data() + column;
+    cells.lengths = lengths_.data() + column;
+    cells.stride = fieldsNumber_;
+    return true;
+}
@@ -8,45 +8,149 @@
 #include <mysql_connection.h>
 #include <mysqlx/devapi/result.h>
 #include <mysqlx/xdevapi.h>
+#include <db/ColumnMetadata.h>
 #include <db/ResultImpl.h>
-#include <algorithm>
+#include <db/ResultMemoryBudget.h>
+#include <atomic>
 #include <memory>
-#include <string>
-#include <unordered_map>
+#include <memory_resource>
+#include <mutex>
 #include <vector>
 #include <mariadb/mysql.h>
 namespace cxk
 {
 
 
+/**
+ * @brief 基于MYSQL_RES的结果集
+ *
+ * 各字段的指针和长度按行优先存放在两个连续数组中，下标为row * columns() + column，
+ * 整个结果集只需两次分配。行索引在第一次访问时才按块建立：访问第row行时
+ * 用mysql_fetch_row顺序取到包含该行的整块为止，构造（在EventLoop线程中）
+ * 不遍历任何行，只看front()或第一页的调用者也不会为其余行付出代价。
+ * 建索引由互斥锁保护，已建好的行通过原子计数无锁读取，结果可以跨线程共享。
+ *
+ * 列名、类型和列名索引放在按形状共享的ColumnMetadata中，同一条语句的结果
+ * 不再各自建表，按列名查找也不分配内存。
+ *
+ * 指定了upstream时，字段值在构造时整体拷贝到一个基于upstream的
+ * bump-pointer arena中，随后立即释放MYSQL_RES；结果不再依赖libmariadb的内存，
+ * 析构时arena一次性归还。upstream需要比结果活得更久。
+ *
+ * 结果占用的字节数（字段值长度之和与行、字段的索引开销）记在构造时给出的
+ * ResultMemoryBudget上，析构时归还。MYSQL_RES中行数据的长度要在建索引时
+ * 才能得到，在此之前只计入行结构的开销。
+ */
 class MySQLResultImpl : public ResultImpl
 {
   public:
+    /**
+     * @brief mysql_use_result逐行读取的结果
+     *
+     * 每行读到后立即把字段值拷贝到arena中（MYSQL_ROW只在读取下一行之前有效），
+     * 并累计占用的字节数，调用者据此在读取过程中检查内存预算。
+     * 读完后交给MySQLResultImpl，结果不再引用MYSQL_RES。
+     */
+    class StreamedRows
+    {
+      public:
+        StreamedRows(ColumnMetadataPtr metadata,
+                     std::pmr::memory_resource *upstream);
+
+        void append(MYSQL_ROW row, const unsigned long *lengths);
+
+        /**
+         * @brief 已读取的行占用的字节数
+         */
+        size_t bytes() const noexcept
+        {
+            return dataBytes_ + values_.capacity() * sizeof(const char *) +
+                   lengths_.capacity() * sizeof(unsigned long);
+        }
+
+      private:
+        friend class MySQLResultImpl;
+
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        ColumnMetadataPtr metadata_;
+        RowSizeType fieldsNumber_;
+        SizeType rowsNumber_{0};
+        size_t dataBytes_{0};
+        std::pmr::vector<const char *> values_;
+        std::pmr::vector<unsigned long> lengths_;
+    };
+
     MySQLResultImpl(std::shared_ptr<MYSQL_RES> r,
                     SizeType affectedRows,
-                    unsigned long long insertId) noexcept;
+                    unsigned long long insertId,
+                    std::pmr::memory_resource *upstream = nullptr,
+                    ResultMemoryBudgetPtr budget = nullptr) noexcept;
+
+    /**
+     * @param reservedBytes 读取过程中已经在budget上占用的字节数，
+     * 由结果接管，并按实际大小调整
+     */
+    MySQLResultImpl(StreamedRows &&rows,
+                    SizeType affectedRows,
+                    unsigned long long insertId,
+                    ResultMemoryBudgetPtr budget,
+                    size_t reservedBytes) noexcept;
+
+    ~MySQLResultImpl() override;
+
+    /**
+     * @brief 由MYSQL_RES的列信息得到共享的ColumnMetadata，没有列时返回nullptr
+     */
+    static ColumnMetadataPtr metadataOf(MYSQL_RES *result);
 
 
     SizeType size() const noexcept override;
     RowSizeType columns() const noexcept override;
     const char *columnName(RowSizeType number) const override;
+    ColumnKind columnKind(RowSizeType number) const override;
     SizeType affectedRows() const noexcept override;
     RowSizeType columnNumber(const char colName[]) const override;
     const char *getValue(SizeType row, RowSizeType column) const override;
     bool isNull(SizeType row, RowSizeType column) const override;
     FieldSizeType getLength(SizeType row, RowSizeType column) const override;
     unsigned long long insertId() const noexcept override;
+    bool columnCells(RowSizeType column, ColumnCells &cells) const override;
+
+    /**
+     * @brief 已经记在budget_上的字节数，加上按已建索引的行推算的其余行的字段值
+     *
+     * 还没有建过索引时先建第一块，不会为此读取全部行。
+     */
+    size_t memoryBytes() const override;
+
+    ColumnMetadataPtr metadata() const override
+    {
+        return metadata_;
+    }
 
   private:
-    const std::shared_ptr<MYSQL_RES> result_;
+    static constexpr SizeType kIndexChunkRows = 256;
+
+    void indexRows(SizeType row) const;  ///< 确保第row行所在的块已经建好索引
+    void indexAll() const;
+    void copyToArena();
+    void charge(size_t bytes) const;
+
+    std::shared_ptr<MYSQL_RES> result_;
     const Result::SizeType rowsNumber_;
-    const MYSQL_FIELD *fieldArray_;
     const Result::RowSizeType fieldsNumber_;
     const SizeType affectedRows_;
     const unsigned long long insertId_;
-    std::shared_ptr<std::unordered_map<std::string, RowSizeType>> fieldsMapPtr_;
-    std::shared_ptr<std::vector<std::pair<char **, std::vector<unsigned long>>>>
-        rowsPtr_;
+    /// 放在容器之前，保证容器先于arena析构
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    ColumnMetadataPtr metadata_;
+    mutable std::pmr::vector<const char *> values_;  ///< rowsNumber_ * fieldsNumber_个字段值
+    mutable std::pmr::vector<unsigned long> lengths_;  ///< 与values_一一对应的字段长度
+    mutable std::atomic<SizeType> indexedRows_{0};  ///< 已建好索引的行数
+    mutable std::mutex indexMutex_;
+    ResultMemoryBudgetPtr budget_;
+    mutable size_t chargedBytes_{0};  ///< 已记在budget_上的字节数，建索引时由indexMutex_保护
+    mutable size_t indexedDataBytes_{0};  ///< 已建索引的行中字段值的字节数，由indexMutex_保护
 };
 
 } // cxk
@@ -0,0 +1,224 @@
+//
+// Created by cxk_zjq on 25-6-25.
+//
+
+#include "MySQLSyncConnector.h"
+#include "MySQLConnector.h"
+#include "MySQLQueryKiller.h"
+#include "MySQLResultImpl.h"
+#include "Exception.h"
+#include <db/DbConnection.h>
+#include <db/SqlTemplate.h>
+#include <mariadb/errmsg.h>
+#include <absl/log/absl_log.h>
+#include <algorithm>
+
+using namespace cxk;
+
+MySQLSyncConnector::MySQLSyncConnector(const std::string &connInfo)
+    : mysqlPtr_(std::shared_ptr<MYSQL>(new MYSQL, [](MYSQL *p) {
+          mysql_close(p);
+          delete p;
+      }))
+{
+    static MysqlEnv env;
+    static thread_local MysqlThreadEnv threadEnv;
+    mysql_init(mysqlPtr_.get());
+    auto connParams = DbConnection::parseConnString(connInfo);
+    for (auto const &kv : connParams)
+    {
+        auto key = kv.first;
+        std::transform(key.begin(),
+                       key.end(),
+                       key.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (key == "host")
+            host_ = kv.second;
+        else if (key == "user")
+            user_ = kv.second;
+        else if (key == "dbname")
+            dbname_ = kv.second;
+        else if (key == "port")
+            port_ = kv.second;
+        else if (key == "password")
+            passwd_ = kv.second;
+        else if (key == "socket")
+            socket_ = kv.second;
+        else if (key == "client_encoding")
+            characterSet_ = kv.second;
+    }
+    fastEscape_ = MySQLConnector::isEscapeSafeCharset(characterSet_);
+    socket_ = MySQLConnector::resolveUnixSocket(host_, socket_);
+}
+
+void MySQLSyncConnector::connect()
+{
+    unsigned int timeout = 10;
+    mysql_options(mysqlPtr_.get(), MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+    mysql_options(mysqlPtr_.get(), MYSQL_OPT_READ_TIMEOUT, &timeout);
+    mysql_options(mysqlPtr_.get(), MYSQL_OPT_WRITE_TIMEOUT, &timeout);
+    if (!mysql_real_connect(mysqlPtr_.get(),
+                            host_.empty() ? nullptr : host_.c_str(),
+                            user_.empty() ? nullptr : user_.c_str(),
+                            passwd_.empty() ? nullptr : passwd_.c_str(),
+                            dbname_.empty() ? nullptr : dbname_.c_str(),
+                            port_.empty() ? 3306 : atol(port_.c_str()),
+                            socket_.empty() ? nullptr : socket_.c_str(),
+                            0))
+    {
+        ABSL_LOG(ERROR) << "Failed to connect to MySQL: Error("
+                        << mysql_errno(mysqlPtr_.get()) << ") \""
+                        << mysql_error(mysqlPtr_.get()) << "\"";
+        throw BrokenConnection(mysql_error(mysqlPtr_.get()));
+    }
+    if (!characterSet_.empty() &&
+        mysql_set_character_set(mysqlPtr_.get(), characterSet_.c_str()) != 0)
+    {
+        ABSL_LOG(ERROR) << "Failed to set character set: "
+                        << mysql_error(mysqlPtr_.get());
+        throw BrokenConnection(mysql_error(mysqlPtr_.get()));
+    }
+    connected_ = true;
+}
+
+Result MySQLSyncConnector::execSql(std::string_view sql,
+                                   const SqlBinder &binder,
+                                   double timeout,
+                                   size_t maxResultBytes)
+{
+    assert(connected_);
+    auto paraNum = binder.size();
+    sql_.clear();
+    if (paraNum > 0)
+    {
+        auto sqlTemplate = SqlTemplate::get(sql);
+        if (sqlTemplate->placeholders() != paraNum)
+            throw ArgumentError(
+                "The number of placeholders does not match the number of "
+                "parameters");
+        MySQLConnector::bindParameters(
+            sql_,
+            mysqlPtr_.get(),
+            fastEscape_ && !(mysqlPtr_->server_status &
+                             SERVER_STATUS_NO_BACKSLASH_ESCAPES),
+            *sqlTemplate,
+            binder.parameters(),
+            binder.lengths(),
+            binder.formats());
+    }
+    else
+    {
+        sql_.assign(sql.data(), sql.size());
+    }
+
+    if (timeout <= 0 || !killer_)
+        return query(maxResultBytes);
+    auto deadline =
+        killer_->killQueryAfter(mysql_thread_id(mysqlPtr_.get()), timeout);
+    try
+    {
+        auto result = query(maxResultBytes);
+        killer_->finish(deadline);
+        return result;
+    }
+    catch (const SqlError &)
+    {
+        // 被KILL中断的语句以SqlError结束，换成与异步接口一致的TimeoutError
+        if (killer_->finish(deadline))
+        {
+            ABSL_LOG(WARNING) << "SQL execution timeout: " << sql_;
+            throw TimeoutError("SQL execution timeout");
+        }
+        throw;
+    }
+    catch (...)
+    {
+        killer_->finish(deadline);
+        throw;
+    }
+}
+
+Result MySQLSyncConnector::query(size_t maxResultBytes)
+{
+    if (mysql_real_query(mysqlPtr_.get(), sql_.data(), sql_.size()) != 0)
+        throwError();
+    Result result(nullptr);
+    for (;;)
+    {
+        result = maxResultBytes > 0 ? useResult(maxResultBytes) : storeResult();
+        auto next = mysql_next_result(mysqlPtr_.get());
+        if (next > 0)
+            throwError();
+        if (next < 0)
+            break;
+    }
+    return result;
+}
+
+Result MySQLSyncConnector::storeResult()
+{
+    auto res = mysql_store_result(mysqlPtr_.get());
+    if (!res && mysql_errno(mysqlPtr_.get()))
+        throwError();
+    return Result(std::make_shared<MySQLResultImpl>(
+        std::shared_ptr<MYSQL_RES>(res,
+                                   [](MYSQL_RES *r) { mysql_free_result(r); }),
+        mysql_affected_rows(mysqlPtr_.get()),
+        mysql_insert_id(mysqlPtr_.get())));
+}
+
+Result MySQLSyncConnector::useResult(size_t maxResultBytes)
+{
+    auto res = mysql_use_result(mysqlPtr_.get());
+    if (!res)
+    {
+        // 没有结果集的语句与mysql_store_result相同
+        if (mysql_errno(mysqlPtr_.get()))
+            throwError();
+        return Result(std::make_shared<MySQLResultImpl>(
+            nullptr,
+            mysql_affected_rows(mysqlPtr_.get()),
+            mysql_insert_id(mysqlPtr_.get())));
+    }
+    MySQLResultImpl::StreamedRows rows(MySQLResultImpl::metadataOf(res),
+                                       nullptr);
+    while (MYSQL_ROW row = mysql_fetch_row(res))
+    {
+        rows.append(row, mysql_fetch_lengths(res));
+        if (rows.bytes() > maxResultBytes)
+        {
+            ABSL_LOG(WARNING) << "The result exceeds the statement memory limit("
+                              << maxResultBytes << " bytes): " << sql_;
+            // 不让mysql_free_result把剩余的行从网络上读完，连接不再使用
+            mysqlPtr_->status = MYSQL_STATUS_READY;
+            mysql_free_result(res);
+            connected_ = false;
+            throw ResultTooLarge(
+                "The result exceeds the statement memory limit");
+        }
+    }
+    bool failed = mysql_errno(mysqlPtr_.get()) != 0;
+    mysql_free_result(res);
+    if (failed)
+        throwError();
+    return Result(std::make_shared<MySQLResultImpl>(
+        std::move(rows),
+        mysql_affected_rows(mysqlPtr_.get()),
+        mysql_insert_id(mysqlPtr_.get()),
+        nullptr,
+        0));
+}
+
+void MySQLSyncConnector::throwError()
+{
+    auto errorNo = mysql_errno(mysqlPtr_.get());
+    ABSL_LOG(ERROR) << "Error(" << errorNo << ") ["
+                    << mysql_sqlstate(mysqlPtr_.get()) << "] \""
+                    << mysql_error(mysqlPtr_.get()) << "\"";
+    if (errorNo == CR_SERVER_GONE_ERROR || errorNo == CR_SERVER_LOST)
+    {
+        connected_ = false;
+        throw BrokenConnection(mysql_error(mysqlPtr_.get()));
+    }
+    throw SqlError(mysql_error(mysqlPtr_.get()), sql_);
+}
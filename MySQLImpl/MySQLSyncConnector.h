@@ -0,0 +1,81 @@
+//
+// Created by cxk_zjq on 25-6-25.
+//
+
+#ifndef MYSQLSYNCCONNECTOR_H
+#define MYSQLSYNCCONNECTOR_H
+
+#include <db/Result.h>
+#include <db/SqlBinder.h>
+#include <NonCopyable.h>
+#include <mariadb/mysql.h>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace cxk
+{
+class MySQLQueryKiller;
+
+/**
+ * @brief 使用libmariadb阻塞接口的MySQL连接
+ *
+ * 不依赖EventLoop，在调用线程中直接完成网络交互，
+ * 供DatabaseManager::execSqlSync()在非事件循环线程中使用。
+ * 连接串格式同MySQLConnector。
+ *
+ * @note 非线程安全，一个对象只应由一个线程使用
+ */
+class MySQLSyncConnector : public NonCopyable
+{
+  public:
+    explicit MySQLSyncConnector(const std::string &connInfo);
+
+    /**
+     * @brief 建立连接，失败时抛出BrokenConnection
+     */
+    void connect();
+
+    /**
+     * @brief 执行SQL语句并返回结果
+     *
+     * 多条语句时返回最后一个结果。占位符与参数数量不一致时抛出ArgumentError，
+     * 执行失败时抛出SqlError，连接断开时抛出BrokenConnection，
+     * 之后connected()返回false。
+     * @param timeout 大于0时，超时的语句通过setQueryKiller()给出的控制连接中断，
+     * 并抛出TimeoutError；没有设置控制连接时不限制
+     * @param maxResultBytes 大于0时结果逐行读取，超出时抛出ResultTooLarge，
+     * 剩余的行不再读取，连接随之作废（connected()返回false）
+     */
+    Result execSql(std::string_view sql,
+                   const SqlBinder &binder,
+                   double timeout = 0.0,
+                   size_t maxResultBytes = 0);
+
+    void setQueryKiller(std::shared_ptr<MySQLQueryKiller> killer)
+    {
+        killer_ = std::move(killer);
+    }
+
+    bool connected() const noexcept
+    {
+        return connected_;
+    }
+
+  private:
+    [[noreturn]] void throwError();
+    Result query(size_t maxResultBytes);
+    Result storeResult();
+    Result useResult(size_t maxResultBytes);
+
+    std::shared_ptr<MYSQL> mysqlPtr_;
+    std::shared_ptr<MySQLQueryKiller> killer_;
+    std::string host_, user_, passwd_, dbname_, port_, socket_, characterSet_;
+    std::string sql_;  ///< 拼接后的SQL，在多次执行之间复用
+    bool fastEscape_{false};
+    bool connected_{false};
+};
+
+}  // namespace cxk
+
+#endif  // MYSQLSYNCCONNECTOR_H
@@ -0,0 +1,354 @@
+//
+// Created by cxk_zjq on 25-6-26.
+//
+
+#include "MySQLXConnector.h"
+#include "MySQLXResultImpl.h"
+#include "Exception.h"
+#include <db/DbTypes.h>
+#include <absl/log/absl_log.h>
+#include <algorithm>
+#include <future>
+
+using namespace cxk;
+
+namespace
+{
+mysqlx::Value toValue(const char *parameter, int length, int format)
+{
+    switch (format)
+    {
+        case cxk::type::MySqlTiny:
+            return mysqlx::Value(static_cast<int64_t>(*parameter));
+        case cxk::type::MySqlShort:
+            return mysqlx::Value(
+                static_cast<int64_t>(*((const short *)parameter)));
+        case cxk::type::MySqlLong:
+            return mysqlx::Value(
+                static_cast<int64_t>(*((const int32_t *)parameter)));
+        case cxk::type::MySqlLongLong:
+            return mysqlx::Value(*((const int64_t *)parameter));
+        case cxk::type::MySqlNull:
+            return mysqlx::Value(nullptr);
+        case cxk::type::MySqlString:
+            return mysqlx::Value(std::string(parameter, length));
+        default:
+            throw ArgumentError(
+                "The parameter type is not supported by the X Protocol");
+    }
+}
+
+// 用户回调抛出的异常不能逃逸到EventLoop中，否则事件循环随之退出；
+// 结果回调抛出的异常交给异常回调，异常回调再抛出时只记录日志
+void invokeCallbacks(const ResultCallback &rcb,
+                     const ExceptPtrCallback &exceptCallback,
+                     const std::shared_ptr<ResultImpl> &resultImpl,
+                     std::exception_ptr exceptPtr)
+{
+    if (!exceptPtr)
+    {
+        try
+        {
+            rcb(Result(resultImpl));
+            return;
+        }
+        catch (...)
+        {
+            exceptPtr = std::current_exception();
+        }
+    }
+    if (!exceptCallback)
+        return;
+    try
+    {
+        exceptCallback(exceptPtr);
+    }
+    catch (const std::exception &e)
+    {
+        ABSL_LOG(ERROR) << "Exception thrown from the exception callback: "
+                        << e.what();
+    }
+    catch (...)
+    {
+        ABSL_LOG(ERROR) << "Unknown exception thrown from the exception "
+                           "callback";
+    }
+}
+}  // namespace
+
+MySQLXConnector::MySQLXConnector(EventLoop *loop, const std::string &connInfo)
+    : DbConnection(loop), worker_("MySQLXWorker")
+{
+    auto connParams = parseConnString(connInfo);
+    for (auto const &kv : connParams)
+    {
+        auto key = kv.first;
+        std::transform(key.begin(),
+                       key.end(),
+                       key.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (key == "host")
+            host_ = kv.second;
+        else if (key == "user")
+            user_ = kv.second;
+        else if (key == "dbname")
+            dbname_ = kv.second;
+        else if (key == "port")
+            port_ = kv.second;
+        else if (key == "password")
+            passwd_ = kv.second;
+        else if (key == "socket")
+            socket_ = kv.second;
+        else if (key == "pipeline")
+            pipelineDepth_ = std::max(1L, atol(kv.second.c_str()));
+    }
+}
+
+MySQLXConnector::~MySQLXConnector()
+{
+}
+
+void MySQLXConnector::init()
+{
+    status_ = ConnectStatus::Connecting;
+    worker_.run();
+    std::weak_ptr<MySQLXConnector> weakPtr = shared_from_this();
+    worker_.getLoop()->queueInLoop([weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        bool ok = true;
+        try
+        {
+            mysqlx::SessionSettings settings(mysqlx::SessionOption::USER,
+                                             thisPtr->user_,
+                                             mysqlx::SessionOption::PWD,
+                                             thisPtr->passwd_);
+            if (!thisPtr->socket_.empty())
+            {
+                settings.set(mysqlx::SessionOption::SOCKET, thisPtr->socket_);
+            }
+            else
+            {
+                settings.set(mysqlx::SessionOption::HOST,
+                             thisPtr->host_.empty() ? std::string("localhost")
+                                                    : thisPtr->host_);
+                settings.set(mysqlx::SessionOption::PORT,
+                             thisPtr->port_.empty()
+                                 ? 33060
+                                 : atoi(thisPtr->port_.c_str()));
+            }
+            if (!thisPtr->dbname_.empty())
+                settings.set(mysqlx::SessionOption::DB, thisPtr->dbname_);
+            thisPtr->session_ = std::make_unique<mysqlx::Session>(settings);
+        }
+        catch (const mysqlx::Error &e)
+        {
+            ABSL_LOG(ERROR) << "Failed to connect to MySQL over X Protocol: "
+                            << e.what();
+            ok = false;
+        }
+        // 引用交给EventLoop线程，保证连接不会在工作线程中析构
+        auto loop = thisPtr->loop_;
+        loop->queueInLoop([thisPtr = std::move(thisPtr), ok]() {
+            if (!ok)
+            {
+                thisPtr->handleClosed();
+                return;
+            }
+            thisPtr->status_ = ConnectStatus::Ok;
+            thisPtr->okCallback_(thisPtr);
+        });
+    });
+}
+
+void MySQLXConnector::execSql(
+    std::string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    assert(paraNum == parameters.size());
+    (void)paraNum;
+    execSql(std::move(sql),
+            std::make_shared<VectorSqlBinder>(std::move(parameters),
+                                              std::move(length),
+                                              std::move(format)),
+            std::move(rcb),
+            std::move(exceptCallback));
+}
+
+void MySQLXConnector::execSql(std::string_view &&sql,
+                              SqlBinderPtr &&binder,
+                              ResultCallback &&rcb,
+                              ExceptPtrCallback &&exceptCallback)
+{
+    if (loop_->isInLoopThread())
+    {
+        execSqlInLoop(std::move(sql),
+                      std::move(binder),
+                      std::move(rcb),
+                      std::move(exceptCallback));
+    }
+    else
+    {
+        auto thisPtr = shared_from_this();
+        loop_->queueInLoop([thisPtr,
+                            sql = std::move(sql),
+                            binder = std::move(binder),
+                            rcb = std::move(rcb),
+                            exceptCallback =
+                                std::move(exceptCallback)]() mutable {
+            thisPtr->execSqlInLoop(std::move(sql),
+                                   std::move(binder),
+                                   std::move(rcb),
+                                   std::move(exceptCallback));
+        });
+    }
+}
+
+void MySQLXConnector::batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
+{
+    for (auto &cmd : sqlCommands)
+    {
+        auto binder = cmd->binder_
+                          ? std::move(cmd->binder_)
+                          : std::make_shared<VectorSqlBinder>(
+                                std::move(cmd->parameters_),
+                                std::move(cmd->lengths_),
+                                std::move(cmd->formats_));
+        execSql(std::move(cmd->sql_),
+                std::move(binder),
+                std::move(cmd->callback_),
+                std::move(cmd->exceptionCallback_));
+    }
+}
+
+void MySQLXConnector::execSqlInLoop(std::string_view &&sql,
+                                    SqlBinderPtr &&binder,
+                                    ResultCallback &&rcb,
+                                    ExceptPtrCallback &&exceptCallback)
+{
+    assert(rcb);
+    ++outstanding_;
+    isWorking_ = outstanding_ >= pipelineDepth_;
+    worker_.getLoop()->queueInLoop([thisPtr = shared_from_this(),
+                                    sql = std::move(sql),
+                                    binder = std::move(binder),
+                                    rcb = std::move(rcb),
+                                    exceptCallback =
+                                        std::move(exceptCallback)]() mutable {
+        runInWorker(std::move(thisPtr),
+                    sql,
+                    binder,
+                    std::move(rcb),
+                    std::move(exceptCallback));
+    });
+    if (!isWorking_)
+    {
+        // 还能接受更多语句，让连接池继续派发
+        loop_->queueInLoop([thisPtr = shared_from_this()]() {
+            if (!thisPtr->isWorking_ &&
+                thisPtr->status_ == ConnectStatus::Ok)
+                thisPtr->idleCb_();
+        });
+    }
+}
+
+void MySQLXConnector::runInWorker(MySQLXConnectorPtr &&thisPtr,
+                                  std::string_view sql,
+                                  const SqlBinderPtr &binder,
+                                  ResultCallback &&rcb,
+                                  ExceptPtrCallback &&exceptCallback)
+{
+    std::shared_ptr<ResultImpl> resultImpl;
+    std::exception_ptr exceptPtr;
+    bool closed = false;
+    try
+    {
+        if (!thisPtr->session_)
+            throw BrokenConnection("The X Protocol session is not open");
+        auto stmt = thisPtr->session_->sql(std::string(sql));
+        for (size_t i = 0; i < binder->size(); ++i)
+        {
+            stmt.bind(toValue(binder->parameters()[i],
+                              binder->lengths()[i],
+                              binder->formats()[i]));
+        }
+        auto result = stmt.execute();
+        resultImpl = std::make_shared<MySQLXResultImpl>(result);
+    }
+    catch (const DrogonDbException &)
+    {
+        exceptPtr = std::current_exception();
+        closed = !thisPtr->session_;
+    }
+    catch (const mysqlx::Error &e)
+    {
+        ABSL_LOG(ERROR) << "X Protocol error: " << e.what() << " sql: " << sql;
+        exceptPtr = std::make_exception_ptr(SqlError(e.what(), std::string(sql)));
+        // 区分语句错误和连接断开
+        try
+        {
+            thisPtr->session_->sql("DO 1").execute();
+        }
+        catch (...)
+        {
+            closed = true;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // 结果转换等过程中的异常（如内存不足）原样交给调用者
+        ABSL_LOG(ERROR) << "Failed to execute over X Protocol: " << e.what()
+                        << " sql: " << sql;
+        exceptPtr = std::current_exception();
+    }
+    catch (...)
+    {
+        ABSL_LOG(ERROR) << "Unknown exception while executing over X Protocol"
+                        << " sql: " << sql;
+        exceptPtr = std::current_exception();
+    }
+    auto loop = thisPtr->loop_;
+    loop->queueInLoop([thisPtr = std::move(thisPtr),
+                       resultImpl = std::move(resultImpl),
+                       exceptPtr,
+                       closed,
+                       rcb = std::move(rcb),
+                       exceptCallback = std::move(exceptCallback)]() {
+        // 先更新状态再回调，回调中派发的新语句能看到正确的在途数量
+        --thisPtr->outstanding_;
+        thisPtr->isWorking_ = thisPtr->outstanding_ >= thisPtr->pipelineDepth_;
+        invokeCallbacks(rcb, exceptCallback, resultImpl, exceptPtr);
+        if (closed)
+        {
+            thisPtr->handleClosed();
+            return;
+        }
+        thisPtr->idleCb_();
+    });
+}
+
+void MySQLXConnector::handleClosed()
+{
+    if (status_ == ConnectStatus::Bad)
+        return;
+    status_ = ConnectStatus::Bad;
+    closeCallback_(shared_from_this());
+}
+
+void MySQLXConnector::disconnect()
+{
+    std::promise<int> pro;
+    auto f = pro.get_future();
+    loop_->runInLoop([this]() { status_ = ConnectStatus::Bad; });
+    worker_.getLoop()->runInLoop([this, &pro]() {
+        session_.reset();
+        pro.set_value(1);
+    });
+    f.get();
+}
@@ -0,0 +1,88 @@
+//
+// Created by cxk_zjq on 25-6-26.
+//
+
+#ifndef MYSQLXCONNECTOR_H
+#define MYSQLXCONNECTOR_H
+
+#include <db/DbConnection.h>
+#include <event/EventLoop.h>
+#include <event/EventLoopThread.h>
+#include <mysqlx/xdevapi.h>
+#include <memory>
+#include <string>
+
+namespace cxk
+{
+class MySQLXConnector;
+using MySQLXConnectorPtr = std::shared_ptr<MySQLXConnector>;
+
+/**
+ * @brief 基于X Protocol（默认端口33060）的MySQL连接
+ *
+ * 连接串与MySQLConnector相同，另外支持pipeline=N（默认4）。
+ * mysqlx DevAPI只提供阻塞接口，Session运行在连接自己的工作线程中，
+ * 回调仍在连接所属的EventLoop线程中执行。
+ *
+ * pipeline=N是本连接最多接受的在途语句数，不是协议层的流水线：
+ * 工作线程每次只向服务端发送一条语句，读完结果后再发送下一条，
+ * 其余语句在工作线程的队列中排队。在途语句未达到上限时，接受一条语句后
+ * 立即通知空闲，连接池因此可以提前把后续SQL交给同一连接，
+ * 省掉的只是语句之间EventLoop与工作线程的往返，而不是服务端的往返。
+ */
+class MySQLXConnector : public DbConnection,
+                        public std::enable_shared_from_this<MySQLXConnector>
+{
+  public:
+    MySQLXConnector(EventLoop *loop, const std::string &connInfo);
+    ~MySQLXConnector() override;
+
+    void init() override;
+
+    using DbConnection::execSql;
+
+    void execSql(
+        std::string_view &&sql,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback)
+        override;
+
+    void execSql(std::string_view &&sql,
+                 SqlBinderPtr &&binder,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback) override;
+
+    /**
+     * @brief 批量执行，命令依次进入工作线程，不需要等待前一条返回
+     */
+    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) override;
+
+    void disconnect() override;
+
+  private:
+    void execSqlInLoop(std::string_view &&sql,
+                       SqlBinderPtr &&binder,
+                       ResultCallback &&rcb,
+                       ExceptPtrCallback &&exceptCallback);
+    // 在工作线程中执行，连接的引用随结果交回EventLoop线程释放，避免在工作线程中析构
+    static void runInWorker(MySQLXConnectorPtr &&thisPtr,
+                            std::string_view sql,
+                            const SqlBinderPtr &binder,
+                            ResultCallback &&rcb,
+                            ExceptPtrCallback &&exceptCallback);
+    void handleClosed();
+
+    std::string host_, user_, passwd_, dbname_, port_, socket_;
+    size_t pipelineDepth_{4};
+    size_t outstanding_{0};  ///< 已接受、尚未回调的语句数量，只在loop_线程中访问
+    std::unique_ptr<mysqlx::Session> session_;  ///< 只在工作线程中访问
+    EventLoopThread worker_;
+};
+
+}  // namespace cxk
+
+#endif  // MYSQLXCONNECTOR_H
@@ -0,0 +1,356 @@
+//
+// Created by cxk_zjq on 25-6-26.
+//
+
+#include "MySQLXResultImpl.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstdio>
+#include <sstream>
+#include <db/Exception.h>
+
+using namespace cxk;
+
+namespace
+{
+// protobuf的varint编码，读取失败时返回false
+bool readVarint(const mysqlx::byte *&pos, const mysqlx::byte *end, uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7)
+    {
+        auto b = *pos++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+void appendPadded(std::string &out, uint64_t v, int width)
+{
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    for (auto len = res.ptr - buf; len < width; ++len)
+        out.push_back('0');
+    out.append(buf, res.ptr);
+}
+
+void appendMicroseconds(std::string &out, uint64_t usec, unsigned digits)
+{
+    if (digits == 0)
+        return;
+    char buf[8];
+    snprintf(buf, sizeof(buf), "%06u", static_cast<unsigned>(usec % 1000000));
+    out.push_back('.');
+    out.append(buf, std::min(digits, 6u));
+}
+
+// DATE/DATETIME/TIMESTAMP：年、月、日，之后可选时、分、秒、微秒
+void decodeDateTime(const mysqlx::bytes &raw,
+                    bool dateOnly,
+                    unsigned digits,
+                    std::string &out)
+{
+    auto pos = raw.first;
+    auto end = raw.first + raw.second;
+    uint64_t parts[7] = {0, 0, 0, 0, 0, 0, 0};
+    for (auto &part : parts)
+    {
+        if (pos >= end || !readVarint(pos, end, part))
+            break;
+    }
+    appendPadded(out, parts[0], 4);
+    out.push_back('-');
+    appendPadded(out, parts[1], 2);
+    out.push_back('-');
+    appendPadded(out, parts[2], 2);
+    if (dateOnly)
+        return;
+    out.push_back(' ');
+    appendPadded(out, parts[3], 2);
+    out.push_back(':');
+    appendPadded(out, parts[4], 2);
+    out.push_back(':');
+    appendPadded(out, parts[5], 2);
+    appendMicroseconds(out, parts[6], digits);
+}
+
+// TIME：一个字节的符号，之后可选时、分、秒、微秒
+void decodeTime(const mysqlx::bytes &raw, unsigned digits, std::string &out)
+{
+    auto pos = raw.first;
+    auto end = raw.first + raw.second;
+    if (pos < end && *pos++ != 0)
+        out.push_back('-');
+    uint64_t parts[4] = {0, 0, 0, 0};
+    for (auto &part : parts)
+    {
+        if (pos >= end || !readVarint(pos, end, part))
+            break;
+    }
+    appendPadded(out, parts[0], 2);
+    out.push_back(':');
+    appendPadded(out, parts[1], 2);
+    out.push_back(':');
+    appendPadded(out, parts[2], 2);
+    appendMicroseconds(out, parts[3], digits);
+}
+
+// DECIMAL：一个字节的小数位数，之后是BCD编码的数字，以符号半字节(0xc/0xd)结束
+void decodeDecimal(const mysqlx::bytes &raw, std::string &out)
+{
+    if (raw.second == 0)
+        return;
+    auto scale = raw.first[0];
+    std::string digits;
+    bool negative = false;
+    for (size_t i = 1; i < raw.second; ++i)
+    {
+        for (int shift : {4, 0})
+        {
+            auto nibble = (raw.first[i] >> shift) & 0x0f;
+            if (nibble < 10)
+            {
+                digits.push_back(static_cast<char>('0' + nibble));
+                continue;
+            }
+            negative = nibble == 0x0d || nibble == 0x0b;
+            i = raw.second;
+            break;
+        }
+    }
+    if (digits.size() <= scale)
+        digits.insert(0, scale - digits.size() + 1, '0');
+    if (negative)
+        out.push_back('-');
+    out.append(digits, 0, digits.size() - scale);
+    if (scale > 0)
+    {
+        out.push_back('.');
+        out.append(digits, digits.size() - scale, scale);
+    }
+}
+
+template <typename T>
+void appendNumber(std::string &out, T value)
+{
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+void appendValue(const mysqlx::Value &value, std::string &out)
+{
+    switch (value.getType())
+    {
+        case mysqlx::Value::UINT64:
+            appendNumber(out, value.get<uint64_t>());
+            break;
+        case mysqlx::Value::INT64:
+            appendNumber(out, value.get<int64_t>());
+            break;
+        case mysqlx::Value::FLOAT:
+            appendNumber(out, value.get<float>());
+            break;
+        case mysqlx::Value::DOUBLE:
+            appendNumber(out, value.get<double>());
+            break;
+        case mysqlx::Value::BOOL:
+            out.push_back(value.get<bool>() ? '1' : '0');
+            break;
+        case mysqlx::Value::STRING:
+            out.append(value.get<std::string>());
+            break;
+        case mysqlx::Value::RAW:
+        {
+            auto raw = value.getRawBytes();
+            out.append(reinterpret_cast<const char *>(raw.first), raw.second);
+            break;
+        }
+        default:
+        {
+            // DOCUMENT和ARRAY按JSON输出
+            std::ostringstream os;
+            os << value;
+            out.append(os.str());
+            break;
+        }
+    }
+}
+ColumnKind columnKindOf(const mysqlx::Column &column)
+{
+    switch (column.getType())
+    {
+        case mysqlx::Type::TINYINT:
+        case mysqlx::Type::SMALLINT:
+        case mysqlx::Type::MEDIUMINT:
+        case mysqlx::Type::INT:
+        case mysqlx::Type::BIGINT:
+            return column.isNumberSigned() ? ColumnKind::Integer
+                                           : ColumnKind::UnsignedInteger;
+        case mysqlx::Type::FLOAT:
+        case mysqlx::Type::DOUBLE:
+            return ColumnKind::Real;
+        case mysqlx::Type::DECIMAL:
+            return ColumnKind::Decimal;
+        case mysqlx::Type::DATE:
+            return ColumnKind::Date;
+        case mysqlx::Type::TIME:
+            return ColumnKind::Time;
+        case mysqlx::Type::DATETIME:
+        case mysqlx::Type::TIMESTAMP:
+            return ColumnKind::DateTime;
+        case mysqlx::Type::BIT:
+            return ColumnKind::Bit;
+        case mysqlx::Type::JSON:
+            return ColumnKind::Json;
+        case mysqlx::Type::BYTES:
+        case mysqlx::Type::GEOMETRY:
+            return ColumnKind::Binary;
+        default:
+            return ColumnKind::String;
+    }
+}
+}  // namespace
+
+MySQLXResultImpl::MySQLXResultImpl(mysqlx::SqlResult &result)
+{
+    try
+    {
+        affectedRows_ = result.getAffectedItemsCount();
+        insertId_ = result.getAutoIncrementValue();
+    }
+    catch (const mysqlx::Error &)
+    {
+        // 查询语句没有这两项
+    }
+    if (!result.hasData())
+        return;
+
+    auto columnCount = result.getColumnCount();
+    std::vector<mysqlx::Type> types;
+    std::vector<unsigned> digits;
+    std::vector<std::string> names;
+    std::vector<ColumnKind> kinds;
+    names.reserve(columnCount);
+    for (mysqlx::col_count_t i = 0; i < columnCount; ++i)
+    {
+        auto const &column = result.getColumn(i);
+        names.emplace_back(column.getColumnLabel());
+        types.push_back(column.getType());
+        digits.push_back(column.getFractionalDigits());
+        kinds.push_back(columnKindOf(column));
+    }
+    std::vector<ColumnDesc> columns;
+    columns.reserve(columnCount);
+    for (mysqlx::col_count_t i = 0; i < columnCount; ++i)
+        columns.push_back({names[i], static_cast<int>(types[i]), 0, kinds[i]});
+    metadata_ = ColumnMetadata::get(columns.data(), columns.size());
+    columnsNumber_ = static_cast<RowSizeType>(columnCount);
+
+    for (auto row : result)
+    {
+        for (mysqlx::col_count_t i = 0; i < columnCount; ++i)
+        {
+            auto const &value = row[i];
+            auto offset = data_.size();
+            if (value.isNull())
+            {
+                cells_.push_back(Cell{offset, 0, true});
+                continue;
+            }
+            switch (types[i])
+            {
+                case mysqlx::Type::DATE:
+                case mysqlx::Type::DATETIME:
+                case mysqlx::Type::TIMESTAMP:
+                    decodeDateTime(row.getBytes(i),
+                                   types[i] == mysqlx::Type::DATE,
+                                   digits[i],
+                                   data_);
+                    break;
+                case mysqlx::Type::TIME:
+                    decodeTime(row.getBytes(i), digits[i], data_);
+                    break;
+                case mysqlx::Type::DECIMAL:
+                    if (value.getType() == mysqlx::Value::RAW)
+                        decodeDecimal(row.getBytes(i), data_);
+                    else
+                        appendValue(value, data_);
+                    break;
+                default:
+                    appendValue(value, data_);
+                    break;
+            }
+            cells_.push_back(Cell{offset, data_.size() - offset, false});
+            data_.push_back('\0');
+        }
+        ++rowsNumber_;
+    }
+}
+
+Result::SizeType MySQLXResultImpl::size() const noexcept
+{
+    return rowsNumber_;
+}
+
+Result::RowSizeType MySQLXResultImpl::columns() const noexcept
+{
+    return columnsNumber_;
+}
+
+const char *MySQLXResultImpl::columnName(RowSizeType number) const
+{
+    assert(number < columnsNumber_);
+    return metadata_->name(number);
+}
+
+ColumnKind MySQLXResultImpl::columnKind(RowSizeType number) const
+{
+    assert(number < columnsNumber_);
+    return metadata_->kind(number);
+}
+
+Result::SizeType MySQLXResultImpl::affectedRows() const noexcept
+{
+    return affectedRows_;
+}
+
+Result::RowSizeType MySQLXResultImpl::columnNumber(const char colName[]) const
+{
+    auto number = metadata_ ? metadata_->find(colName) : -1;
+    if (number >= 0)
+        return static_cast<RowSizeType>(number);
+    throw RangeError(std::string("no column named ") + colName);
+}
+
+const char *MySQLXResultImpl::getValue(SizeType row, RowSizeType column) const
+{
+    assert(row < rowsNumber_);
+    assert(column < columnsNumber_);
+    auto const &c = cell(row, column);
+    return c.isNull ? nullptr : data_.data() + c.offset;
+}
+
+bool MySQLXResultImpl::isNull(SizeType row, RowSizeType column) const
+{
+    return cell(row, column).isNull;
+}
+
+Result::FieldSizeType MySQLXResultImpl::getLength(SizeType row,
+                                                  RowSizeType column) const
+{
+    return cell(row, column).length;
+}
+
+unsigned long long MySQLXResultImpl::insertId() const noexcept
+{
+    return insertId_;
+}
+
+size_t MySQLXResultImpl::memoryBytes() const
+{
+    return data_.capacity() + cells_.capacity() * sizeof(Cell);
+}
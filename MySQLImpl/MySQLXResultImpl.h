@@ -0,0 +1,69 @@
+//
+// Created by cxk_zjq on 25-6-26.
+//
+
+#ifndef MYSQLXRESULTIMPL_H
+#define MYSQLXRESULTIMPL_H
+
+#include <db/ColumnMetadata.h>
+#include <db/ResultImpl.h>
+#include <mysqlx/xdevapi.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief X Protocol查询结果
+ *
+ * 构造时把SqlResult中的所有行读出并转换为与经典协议一致的文本形式
+ * （时间、DECIMAL等X Protocol编码的值会被解码），之后不再依赖Session。
+ */
+class MySQLXResultImpl : public ResultImpl
+{
+  public:
+    explicit MySQLXResultImpl(mysqlx::SqlResult &result);
+
+    SizeType size() const noexcept override;
+    RowSizeType columns() const noexcept override;
+    const char *columnName(RowSizeType number) const override;
+    ColumnKind columnKind(RowSizeType number) const override;
+    SizeType affectedRows() const noexcept override;
+    RowSizeType columnNumber(const char colName[]) const override;
+    const char *getValue(SizeType row, RowSizeType column) const override;
+    bool isNull(SizeType row, RowSizeType column) const override;
+    FieldSizeType getLength(SizeType row, RowSizeType column) const override;
+    unsigned long long insertId() const noexcept override;
+    size_t memoryBytes() const override;
+
+    ColumnMetadataPtr metadata() const override
+    {
+        return metadata_;
+    }
+
+  private:
+    struct Cell
+    {
+        size_t offset;
+        FieldSizeType length;
+        bool isNull;
+    };
+
+    const Cell &cell(SizeType row, RowSizeType column) const
+    {
+        return cells_[row * columnsNumber_ + column];
+    }
+
+    ColumnMetadataPtr metadata_;  ///< 列名和列名索引，与经典协议的结果共享同一套实现
+    RowSizeType columnsNumber_{0};
+    std::string data_;  ///< 所有单元格的文本，每个单元格以'\0'结尾
+    std::vector<Cell> cells_;
+    SizeType rowsNumber_{0};
+    SizeType affectedRows_{0};
+    unsigned long long insertId_{0};
+};
+
+}  // namespace cxk
+
+#endif  // MYSQLXRESULTIMPL_H
@@ -0,0 +1,158 @@
+/**
+*@ClassName bench_bind
+*@Author cxk
+*@Data 25-6-21 下午2:10
+*/
+//
+// 对比参数拼接的两种写法：
+//  - 旧写法：substr + std::to_string + 每个字符串参数一个临时std::string
+//  - 新写法：复用预留好的缓冲区 + std::to_chars + utils::escapeSqlString
+//
+#include "utils/utils.h"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+size_t scalarEscape(const char *from, size_t length, char *to)
+{
+    char *out = to;
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = from[i];
+        char esc = 0;
+        switch (c)
+        {
+            case '\0': esc = '0'; break;
+            case '\n': esc = 'n'; break;
+            case '\r': esc = 'r'; break;
+            case '\\': esc = '\\'; break;
+            case '\'': esc = '\''; break;
+            case '"': esc = '"'; break;
+            case '\032': esc = 'Z'; break;
+        }
+        if (esc)
+        {
+            *out++ = '\\';
+            *out++ = esc;
+        }
+        else
+        {
+            *out++ = c;
+        }
+    }
+    return static_cast<size_t>(out - to);
+}
+
+struct Params
+{
+    std::vector<int64_t> ints;
+    std::vector<std::string> strings;
+};
+
+void bindOld(std::string &out, std::string_view sql, const Params &params)
+{
+    out.clear();
+    size_t pos = 0, intIdx = 0, strIdx = 0;
+    for (size_t i = 0; i < params.ints.size() + params.strings.size(); ++i)
+    {
+        auto seekPos = sql.find('?', pos);
+        auto sub = sql.substr(pos, seekPos - pos);
+        out.append(sub.data(), sub.length());
+        pos = seekPos + 1;
+        if (i % 2 == 0)
+        {
+            out.append(std::to_string(params.ints[intIdx++]));
+        }
+        else
+        {
+            auto &s = params.strings[strIdx++];
+            out.append("'");
+            std::string to(s.length() * 2, '\0');
+            auto len = scalarEscape(s.data(), s.length(), (char *)to.c_str());
+            to.resize(len);
+            out.append(to);
+            out.append("'");
+        }
+    }
+    auto sub = sql.substr(pos);
+    out.append(sub.data(), sub.length());
+}
+
+void bindNew(std::string &out, std::string_view sql, const Params &params)
+{
+    out.clear();
+    size_t reserveSize = sql.size();
+    for (auto &s : params.strings)
+        reserveSize += s.size() * 2 + 2;
+    reserveSize += params.ints.size() * 20;
+    out.reserve(reserveSize);
+    size_t pos = 0, intIdx = 0, strIdx = 0;
+    for (size_t i = 0; i < params.ints.size() + params.strings.size(); ++i)
+    {
+        auto seekPos = sql.find('?', pos);
+        out.append(sql.data() + pos, seekPos - pos);
+        pos = seekPos + 1;
+        if (i % 2 == 0)
+        {
+            char tmp[24];
+            auto res =
+                std::to_chars(tmp, tmp + sizeof(tmp), params.ints[intIdx++]);
+            out.append(tmp, res.ptr - tmp);
+        }
+        else
+        {
+            auto &s = params.strings[strIdx++];
+            out.push_back('\'');
+            auto offset = out.size();
+            out.resize(offset + s.size() * 2 + 1);
+            auto len = utils::escapeSqlString(s.data(), s.size(), &out[offset]);
+            out.resize(offset + len);
+            out.push_back('\'');
+        }
+    }
+    out.append(sql.data() + pos, sql.size() - pos);
+}
+
+template <typename F>
+double run(const char *name, F &&f, size_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    printf("%-28s %10.1f ns/op\n", name, elapsed / iterations);
+    return elapsed;
+}
+}  // namespace
+
+int main()
+{
+    constexpr size_t kIterations = 1000000;
+    const std::string_view sql =
+        "insert into users (id,name,age,email,score,bio,level,note) values "
+        "(?,?,?,?,?,?,?,?)";
+    Params shortParams{{1234567, 42, 987654321, 7},
+                       {"alice", "alice@example.com", "hi", "it's ok"}};
+    Params longParams{{1234567, 42, 987654321, 7},
+                      {std::string(256, 'a'),
+                       std::string(512, 'b') + "'quoted'",
+                       std::string(1024, 'c'),
+                       std::string(128, 'd') + "\n"}};
+
+    std::string out;
+    size_t sink = 0;
+    run("short params / old", [&] { bindOld(out, sql, shortParams); sink += out.size(); }, kIterations);
+    run("short params / new", [&] { bindNew(out, sql, shortParams); sink += out.size(); }, kIterations);
+    run("long params / old", [&] { bindOld(out, sql, longParams); sink += out.size(); }, kIterations / 10);
+    run("long params / new", [&] { bindNew(out, sql, longParams); sink += out.size(); }, kIterations / 10);
+    printf("checksum %zu\n", sink);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+*@ClassName bench_decimal
+*@Author cxk
+*@Data 25-6-29 下午8:40
+*/
+//
+// 对比DECIMAL字段文本的几种解析方式：
+//  - std::stod：有损，且依赖locale
+//  - 逐字符累加：与Decimal结果相同的朴素写法
+//  - Decimal::parse：按8字节分块判断和合并数字
+//
+#include "db/Decimal.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+template <typename F>
+void run(const char *name, F &&f, const std::vector<std::string> &texts)
+{
+    constexpr int kRounds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round)
+        for (const auto &text : texts)
+            f(text);
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    printf("%-20s %8.1f ns/value\n",
+           name,
+           elapsed * 1e9 / (texts.size() * kRounds));
+}
+
+bool naiveParse(const std::string &text, __int128 &value, unsigned &scale)
+{
+    size_t i = 0;
+    bool negative = !text.empty() && text[0] == '-';
+    if (negative)
+        ++i;
+    __int128 acc = 0;
+    scale = 0;
+    bool fraction = false;
+    for (; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '.' && !fraction)
+        {
+            fraction = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            return false;
+        acc = acc * 10 + (c - '0');
+        scale += fraction;
+    }
+    value = negative ? -acc : acc;
+    return true;
+}
+}  // namespace
+
+int main()
+{
+    // 账单金额常见的DECIMAL(18,4)和较宽的DECIMAL(36,12)
+    std::mt19937_64 rng(42);
+    for (auto [precision, scale] : {std::pair{18, 4}, std::pair{36, 12}})
+    {
+        std::vector<std::string> texts(1000);
+        for (auto &text : texts)
+        {
+            auto digits = 1 + rng() % (precision - scale);
+            if (rng() % 4 == 0)
+                text += '-';
+            for (size_t i = 0; i < digits; ++i)
+                text += static_cast<char>('0' + (i == 0 ? 1 + rng() % 9
+                                                        : rng() % 10));
+            text += '.';
+            for (int i = 0; i < scale; ++i)
+                text += static_cast<char>('0' + rng() % 10);
+        }
+        printf("DECIMAL(%d,%d)\n", precision, scale);
+        double dsink = 0;
+        __int128 sink = 0;
+        run("std::stod", [&](const std::string &text) {
+            dsink += std::stod(text);
+        }, texts);
+        run("naive loop", [&](const std::string &text) {
+            __int128 value;
+            unsigned s;
+            naiveParse(text, value, s);
+            sink += value + s;
+        }, texts);
+        run("Decimal::parse", [&](const std::string &text) {
+            cxk::Decimal value;
+            cxk::Decimal::parse(text, value);
+            sink += value.unscaled() + value.scale();
+        }, texts);
+        printf("checksum %g %lld\n", dsink, static_cast<long long>(sink));
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+*@ClassName bench_field
+*@Author cxk
+*@Data 25-6-27 下午4:30
+*/
+//
+// 对比字段数值解析的两种写法：
+//  - 旧写法：std::stringstream（通用类型）和std::stoll/std::stod（整数、浮点特化）
+//  - 新写法：detail::parseNumber，直接对getValue/getLength给出的string_view调用from_chars
+//
+#include "db/Field.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+template <typename F>
+double run(const char *name, F &&f, size_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f(i);
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    printf("%-28s %10.1f ns/op\n", name, elapsed / iterations);
+    return elapsed;
+}
+}  // namespace
+
+int main()
+{
+    constexpr size_t kValues = 4096;
+    constexpr size_t kIterations = 2000000;
+    std::mt19937_64 rng(42);
+    std::vector<std::string> ints, doubles;
+    for (size_t i = 0; i < kValues; ++i)
+    {
+        ints.push_back(std::to_string(static_cast<int64_t>(rng() >> 20)));
+        doubles.push_back(std::to_string((rng() % 1000000) / 100.0));
+    }
+    std::vector<std::string_view> intViews(ints.begin(), ints.end());
+    std::vector<std::string_view> doubleViews(doubles.begin(), doubles.end());
+
+    int64_t isink = 0;
+    double dsink = 0;
+    run("int64 / stringstream", [&](size_t i) {
+        int64_t v = 0;
+        std::stringstream ss(ints[i % kValues].c_str());
+        ss >> v;
+        isink += v;
+    }, kIterations / 10);
+    run("int64 / stoll", [&](size_t i) {
+        isink += std::stoll(ints[i % kValues].c_str());
+    }, kIterations);
+    run("int64 / from_chars", [&](size_t i) {
+        int64_t v = 0;
+        cxk::detail::parseNumber(intViews[i % kValues], v);
+        isink += v;
+    }, kIterations);
+    run("double / stringstream", [&](size_t i) {
+        double v = 0;
+        std::stringstream ss(doubles[i % kValues].c_str());
+        ss >> v;
+        dsink += v;
+    }, kIterations / 10);
+    run("double / stod", [&](size_t i) {
+        dsink += std::stod(doubles[i % kValues].c_str());
+    }, kIterations);
+    run("double / from_chars", [&](size_t i) {
+        double v = 0;
+        cxk::detail::parseNumber(doubleViews[i % kValues], v);
+        dsink += v;
+    }, kIterations);
+    printf("checksum %lld %f\n", static_cast<long long>(isink), dsink);
+    return 0;
+}
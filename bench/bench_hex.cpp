@@ -0,0 +1,149 @@
+/**
+*@ClassName bench_hex
+*@Author cxk
+*@Data 25-6-29 下午6:00
+*/
+//
+// 对比大块十六进制解码和二进制字段读取的写法：
+//  - 十六进制：旧的逐字符分支解码 vs utils::hexToBinary（SSE2/AVX2）
+//  - 二进制字段：Field::as<std::vector<char>>()的拷贝 vs Field::asBytes()的视图
+//
+#include "db/Field.h"
+#include "db/ResultImpl.h"
+#include "utils/utils.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+template <typename F>
+double run(const char *name, F &&f, size_t iterations, size_t bytes)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f(i);
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    printf("%-28s %10.1f MB/s\n",
+           name,
+           bytes * iterations / elapsed / (1024 * 1024));
+    return elapsed;
+}
+
+// 改动前utils::hexToBinaryString的写法
+int branchyNibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool branchyDecode(const char *ptr, size_t length, char *out)
+{
+    for (size_t i = 0; i < length / 2; ++i)
+    {
+        auto high = branchyNibble(ptr[i * 2]);
+        auto low = branchyNibble(ptr[i * 2 + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        out[i] = static_cast<char>(high * 16 + low);
+    }
+    return true;
+}
+
+// 只有一个二进制字段的结果集
+class BlobResultImpl : public cxk::ResultImpl
+{
+  public:
+    explicit BlobResultImpl(std::string blob) : blob_(std::move(blob))
+    {
+    }
+
+    SizeType size() const noexcept override
+    {
+        return 1;
+    }
+
+    RowSizeType columns() const noexcept override
+    {
+        return 1;
+    }
+
+    const char *columnName(RowSizeType) const override
+    {
+        return "data";
+    }
+
+    SizeType affectedRows() const noexcept override
+    {
+        return 0;
+    }
+
+    RowSizeType columnNumber(const char[]) const override
+    {
+        return 0;
+    }
+
+    const char *getValue(SizeType, RowSizeType) const override
+    {
+        return blob_.data();
+    }
+
+    bool isNull(SizeType, RowSizeType) const override
+    {
+        return false;
+    }
+
+    FieldSizeType getLength(SizeType, RowSizeType) const override
+    {
+        return blob_.size();
+    }
+
+  private:
+    std::string blob_;
+};
+}  // namespace
+
+int main()
+{
+    constexpr size_t kBlobBytes = 4 * 1024 * 1024;
+    constexpr size_t kIterations = 50;
+    static const char kDigits[] = "0123456789abcdefABCDEF";
+    std::mt19937_64 rng(42);
+    std::string hex(kBlobBytes * 2, '0');
+    for (auto &c : hex)
+        c = kDigits[rng() % 22];
+    std::vector<char> out(kBlobBytes);
+
+    size_t sink = 0;
+    run("hex / branchy", [&](size_t) {
+        sink += branchyDecode(hex.data(), hex.size(), out.data());
+        sink += static_cast<unsigned char>(out[sink % kBlobBytes]);
+    }, kIterations, hex.size());
+    run("hex / hexToBinary", [&](size_t) {
+        sink += utils::hexToBinary(hex.data(), hex.size(), out.data());
+        sink += static_cast<unsigned char>(out[sink % kBlobBytes]);
+    }, kIterations, hex.size());
+
+    cxk::Result result(std::make_shared<BlobResultImpl>(
+        std::string(out.begin(), out.end())));
+    auto field = result[0][0];
+    run("blob / as<vector<char>>", [&](size_t) {
+        auto bytes = field.as<std::vector<char>>();
+        sink += bytes.size();
+    }, kIterations, kBlobBytes);
+    run("blob / asBytes", [&](size_t) {
+        auto bytes = field.asBytes();
+        sink += bytes.size();
+    }, kIterations * 1000, kBlobBytes);
+    printf("checksum %zu\n", sink);
+    return 0;
+}
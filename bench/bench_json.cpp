@@ -0,0 +1,167 @@
+/**
+*@ClassName bench_json
+*@Author cxk
+*@Data 25-6-28 下午6:10
+*/
+//
+// 对比结果集转JSON的两种写法：
+//  - 旧写法：逐个字段构造Json::Value树，再用Json::StreamWriter输出
+//  - 新写法：ResultJsonWriter直接写入复用的std::string
+//
+#include "db/Field.h"
+#include "db/ResultIterator.h"
+#include "db/ResultImpl.h"
+#include "db/ResultJsonWriter.h"
+#include <json/json.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+// 按行优先存放的内存结果集：id、name、score、comment四列
+class BenchResultImpl : public ResultImpl
+{
+  public:
+    explicit BenchResultImpl(size_t rows)
+    {
+        std::mt19937_64 rng(42);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            storage_.push_back(std::to_string(rng() >> 24));
+            storage_.push_back("user_" + std::to_string(i));
+            storage_.push_back(std::to_string((rng() % 100000) / 100.0));
+            storage_.push_back(
+                "a fairly ordinary comment with \"quotes\" in row " +
+                std::to_string(i));
+        }
+        for (auto &value : storage_)
+        {
+            values_.push_back(value.c_str());
+            lengths_.push_back(value.size());
+        }
+    }
+
+    SizeType size() const noexcept override
+    {
+        return values_.size() / kColumns;
+    }
+
+    RowSizeType columns() const noexcept override
+    {
+        return kColumns;
+    }
+
+    const char *columnName(RowSizeType number) const override
+    {
+        static const char *names[] = {"id", "name", "score", "comment"};
+        return names[number];
+    }
+
+    ColumnKind columnKind(RowSizeType number) const override
+    {
+        static const ColumnKind kinds[] = {ColumnKind::Integer,
+                                           ColumnKind::String,
+                                           ColumnKind::Real,
+                                           ColumnKind::String};
+        return kinds[number];
+    }
+
+    SizeType affectedRows() const noexcept override
+    {
+        return 0;
+    }
+
+    RowSizeType columnNumber(const char colName[]) const override
+    {
+        for (RowSizeType i = 0; i < kColumns; ++i)
+        {
+            if (strcmp(columnName(i), colName) == 0)
+                return i;
+        }
+        return 0;
+    }
+
+    const char *getValue(SizeType row, RowSizeType column) const override
+    {
+        return values_[row * kColumns + column];
+    }
+
+    bool isNull(SizeType row, RowSizeType column) const override
+    {
+        return getValue(row, column) == nullptr;
+    }
+
+    FieldSizeType getLength(SizeType row, RowSizeType column) const override
+    {
+        return lengths_[row * kColumns + column];
+    }
+
+    bool columnCells(RowSizeType column, ColumnCells &cells) const override
+    {
+        cells.values = values_.data() + column;
+        cells.lengths = lengths_.data() + column;
+        cells.stride = kColumns;
+        return true;
+    }
+
+  private:
+    static constexpr RowSizeType kColumns = 4;
+    std::vector<std::string> storage_;
+    std::vector<const char *> values_;
+    std::vector<unsigned long> lengths_;
+};
+
+template <typename F>
+void run(const char *name, F &&f, size_t iterations, size_t rows)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    printf("%-28s %10.1f ns/row\n", name, elapsed / iterations / rows);
+}
+}  // namespace
+
+int main()
+{
+    constexpr size_t kRows = 1000;
+    constexpr size_t kIterations = 200;
+    Result result(std::make_shared<BenchResultImpl>(kRows));
+    size_t sink = 0;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    run("Json::Value tree", [&]() {
+        Json::Value array(Json::arrayValue);
+        for (auto const &row : result)
+        {
+            Json::Value object;
+            object["id"] = row["id"].as<int64_t>();
+            object["name"] = row["name"].as<std::string>();
+            object["score"] = row["score"].as<double>();
+            object["comment"] = row["comment"].as<std::string>();
+            array.append(std::move(object));
+        }
+        sink += Json::writeString(builder, array).size();
+    }, kIterations, kRows);
+
+    std::string buffer;
+    ResultJsonWriter writer;
+    run("ResultJsonWriter", [&]() {
+        buffer.clear();
+        writer.write(result, buffer);
+        sink += buffer.size();
+    }, kIterations, kRows);
+
+    printf("checksum %zu\n", sink);
+    return 0;
+}
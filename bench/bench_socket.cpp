@@ -0,0 +1,85 @@
+/**
+*@ClassName bench_socket
+*@Author cxk
+*@Data 25-6-27 上午11:20
+*/
+//
+// 对比同一台机器上TCP回环与unix socket的单次查询延迟和吞吐
+// 用法：bench_socket "user=root password=xxx dbname=test" [次数]
+// 需要本机运行MySQL服务端，TCP使用host=127.0.0.1，socket使用自动探测的路径
+//
+#include "MySQLImpl/MySQLConnector.h"
+#include "MySQLImpl/MySQLSyncConnector.h"
+#include "Exception.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+void run(const char *name, const std::string &connInfo, size_t iterations)
+{
+    MySQLSyncConnector conn(connInfo);
+    conn.connect();
+    VectorSqlBinder noParams({}, {}, {});
+    // 预热
+    for (size_t i = 0; i < 100; ++i)
+        conn.execSql("select 1", noParams);
+
+    std::vector<double> latencies;
+    latencies.reserve(iterations);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        conn.execSql("select 1", noParams);
+        latencies.push_back(std::chrono::duration<double, std::micro>(
+                                std::chrono::steady_clock::now() - begin)
+                                .count());
+    }
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-8s p50 %8.1f us  p99 %8.1f us  %10.0f qps\n",
+           name,
+           latencies[latencies.size() / 2],
+           latencies[latencies.size() * 99 / 100],
+           iterations / elapsed);
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s \"user=... password=... dbname=...\" [n]\n",
+                argv[0]);
+        return 1;
+    }
+    std::string connInfo = argv[1];
+    size_t iterations = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20000;
+    if (iterations == 0)
+        iterations = 1;
+
+    auto socket = MySQLConnector::localUnixSocket();
+    try
+    {
+        run("tcp", connInfo + " host=127.0.0.1", iterations);
+        if (socket.empty())
+            printf("socket   no local MySQL socket found\n");
+        else
+            run("socket", connInfo + " host=localhost", iterations);
+    }
+    catch (const DrogonDbException &e)
+    {
+        fprintf(stderr, "%s\n", e.base().what());
+        return 1;
+    }
+    return 0;
+}
@@ -7,216 +7,241 @@
 #include <cstring>
 #include <utility>
 #include "Exception.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 using namespace cxk;
 
 namespace
 {
-/// Find the end of a single-quoted SQL string in an SQL array.
-/** Assumes UTF-8 or an ASCII-superset single-byte encoding.
- * This is used for array parsing, where the database may send us strings
- * stored in the array, in a quoted and escaped format.
- *
- * Returns the address of the first character after the closing quote.
+/// Find the first of the characters a, b and c in [begin, end).
+/** Returns end if none of them is found.  The input is scanned in blocks of
+ * 32 (AVX2) or 16 (SSE2) bytes, only the tail is checked byte by byte.
  */
-const char *scan_single_quoted_string(const char begin[])
+const char *find_any_of(const char *begin,
+                        const char *end,
+                        char a,
+                        char b,
+                        char c)
 {
     const char *here = begin;
-    assert(*here == '\'');
-    for (here++; *here; here++)
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    for (; end - here >= 32; here += 32)
     {
-        switch (*here)
-        {
-            case '\'':
-                // Escaped quote, or closing quote.
-                here++;
-                // If the next character is a quote, we've got a double single
-                // quote. That's how SQL escapes embedded quotes in a string.
-                // Terrible idea, but it's what we have.
-                if (*here != '\'')
-                    return here;
-                // Otherwise, we've found the end of the string.  Return the
-                // address of the very next byte.
-                break;
-            case '\\':
-                // Backslash escape.  Skip ahead by one more character.
-                here++;
-                if (!*here)
-                    throw ArgumentError("SQL string ends in escape: " +
-                                        std::string(begin));
-                break;
-        }
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(here));
+        __m256i hit = _mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, va),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vb),
+                            _mm256_cmpeq_epi8(chunk, vc)));
+        auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(hit));
+        if (mask != 0)
+            return here + __builtin_ctz(mask);
     }
-    throw ArgumentError("Null byte in SQL string: " + std::string(begin));
-}
-
-/// Parse a single-quoted SQL string: un-quote it and un-escape it.
-/** Assumes UTF-8 or an ASCII-superset single-byte encoding.
- */
-std::string parse_single_quoted_string(const char begin[], const char end[])
-{
-    // There have to be at least 2 characters: the opening and closing quotes.
-    assert(begin + 1 < end);
-    assert(*begin == '\'');
-    assert(*(end - 1) == '\'');
-
-    std::string output;
-    // Maximum output size is same as the input size, minus the opening and
-    // closing quotes.  In the worst case, the real number could be half that.
-    // Usually it'll be a pretty close estimate.
-    output.reserve(std::size_t(end - begin - 2));
-    for (const char *here = begin + 1; here < end - 1; here++)
+#elif defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    for (; end - here >= 16; here += 16)
     {
-        auto c = *here;
-        // Skip escapes.
-        if (c == '\'' || c == '\\')
-            here++;
-        output.push_back(c);
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(here));
+        __m128i hit =
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                         _mm_or_si128(_mm_cmpeq_epi8(chunk, vb),
+                                      _mm_cmpeq_epi8(chunk, vc)));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hit));
+        if (mask != 0)
+            return here + __builtin_ctz(mask);
     }
-
-    return output;
+#endif
+    for (; here < end; ++here)
+    {
+        if (*here == a || *here == b || *here == c)
+            return here;
+    }
+    return end;
 }
 
-/// Find the end of a double-quoted SQL string in an SQL array.
+/// Find the end of a single-quoted SQL string in an SQL array.
 /** Assumes UTF-8 or an ASCII-superset single-byte encoding.
+ * This is used for array parsing, where the database may send us strings
+ * stored in the array, in a quoted and escaped format.
+ *
+ * Returns the address of the first character after the closing quote, and
+ * sets escaped if the string contains any escape.
  */
-const char *scan_double_quoted_string(const char begin[])
+const char *scan_single_quoted_string(const char begin[],
+                                      const char end[],
+                                      bool &escaped)
 {
     const char *here = begin;
-    assert(*here == '"');
-    for (here++; *here; here++)
+    assert(*here == '\'');
+    for (here++;;)
     {
-        switch (*here)
+        here = find_any_of(here, end, '\'', '\\', '\\');
+        if (here == end)
+            break;
+        if (*here == '\\')
         {
-            case '\\':
-                // Backslash escape.  Skip ahead by one more character.
-                here++;
-                if (!*here)
-                    throw ArgumentError("SQL string ends in escape: " +
-                                        std::string(begin));
-                break;
-            case '"':
-                return here + 1;
+            // Backslash escape.  Skip ahead by one more character.
+            escaped = true;
+            if (++here == end)
+                throw ArgumentError("SQL string ends in escape: " +
+                                    std::string(begin, end));
+            ++here;
+            continue;
         }
+        // Escaped quote, or closing quote.
+        here++;
+        // If the next character is a quote, we've got a double single
+        // quote. That's how SQL escapes embedded quotes in a string.
+        // Terrible idea, but it's what we have.
+        if (here == end || *here != '\'')
+            return here;
+        escaped = true;
+        here++;
     }
-    throw ArgumentError("Null byte in SQL string: " + std::string(begin));
+    throw ArgumentError("Unterminated SQL string: " + std::string(begin, end));
 }
 
-/// Parse a double-quoted SQL string: un-quote it and un-escape it.
+/// Find the end of a double-quoted SQL string in an SQL array.
 /** Assumes UTF-8 or an ASCII-superset single-byte encoding.
  */
-std::string parse_double_quoted_string(const char begin[], const char end[])
+const char *scan_double_quoted_string(const char begin[],
+                                      const char end[],
+                                      bool &escaped)
 {
-    // There have to be at least 2 characters: the opening and closing quotes.
-    assert(begin + 1 < end);
-    assert(*begin == '"');
-    assert(*(end - 1) == '"');
-
-    std::string output;
-    // Maximum output size is same as the input size, minus the opening and
-    // closing quotes.  In the worst case, the real number could be half that.
-    // Usually it'll be a pretty close estimate.
-    output.reserve(std::size_t(end - begin - 2));
-    for (const char *here = begin + 1; here < end - 1; here++)
+    const char *here = begin;
+    assert(*here == '"');
+    for (here++;;)
     {
-        auto c = *here;
-        // Skip escapes.
-        if (c == '\\')
-            here++;
-        output.push_back(c);
+        here = find_any_of(here, end, '"', '\\', '\\');
+        if (here == end)
+            break;
+        if (*here == '"')
+            return here + 1;
+        // Backslash escape.  Skip ahead by one more character.
+        escaped = true;
+        if (++here == end)
+            throw ArgumentError("SQL string ends in escape: " +
+                                std::string(begin, end));
+        ++here;
     }
-
-    return output;
+    throw ArgumentError("Unterminated SQL string: " + std::string(begin, end));
 }
 
 /// Find the end of an unquoted string in an SQL array.
 /** Assumes UTF-8 or an ASCII-superset single-byte encoding.
  */
-const char *scan_unquoted_string(const char begin[])
+const char *scan_unquoted_string(const char begin[], const char end[])
 {
     assert(*begin != '\'');
     assert(*begin != '"');
-
-    const char *p;
-    for (p = begin; *p != ',' && *p != ';' && *p != '}'; p++)
-        ;
-    return p;
+    return find_any_of(begin, end, ',', ';', '}');
 }
 
-/// Parse an unquoted SQL string.
-/** Here, the special unquoted value NULL means a null value, not a string
- * that happens to spell "NULL".
- */
-std::string parse_unquoted_string(const char begin[], const char end[])
+}  // namespace
+
+ArrayParser::ArrayParser(const char input[])
+    : pos_(input), end_(input ? input + strlen(input) : nullptr)
 {
-    return std::string(begin, end);
 }
 
-}  // namespace
-
-ArrayParser::ArrayParser(const char input[]) : pos_(input)
+ArrayParser::ArrayParser(const char input[], size_t length)
+    : pos_(input), end_(input ? input + length : nullptr)
 {
 }
 
-std::pair<ArrayParser::juncture, std::string> ArrayParser::getNext()
+ArrayParser::Token ArrayParser::nextToken()
 {
-    ArrayParser::juncture found;
-    std::string value;
+    Token token{juncture::done};
     const char *end;
 
-    if (pos_ == nullptr)
+    if (pos_ == nullptr || pos_ == end_ || *pos_ == '\0')
+        return token;
+    switch (*pos_)
     {
-        found = juncture::done;
-        end = nullptr;
+        case '{':
+            token.type = juncture::row_start;
+            end = pos_ + 1;
+            break;
+        case '}':
+            token.type = juncture::row_end;
+            end = pos_ + 1;
+            break;
+        case '\'':
+            token.type = juncture::string_value;
+            end = scan_single_quoted_string(pos_, end_, token.escaped);
+            token.quote = '\'';
+            token.text = std::string_view(pos_ + 1, end - pos_ - 2);
+            break;
+        case '"':
+            token.type = juncture::string_value;
+            end = scan_double_quoted_string(pos_, end_, token.escaped);
+            token.quote = '"';
+            token.text = std::string_view(pos_ + 1, end - pos_ - 2);
+            break;
+        default:
+            end = scan_unquoted_string(pos_, end_);
+            token.text = std::string_view(pos_, end - pos_);
+            if (token.text == "NULL")
+            {
+                // In this one situation, as a special case, NULL means a
+                // null field, not a string that happens to spell "NULL".
+                token.type = juncture::null_value;
+                token.text = std::string_view();
+            }
+            else
+            {
+                token.type = juncture::string_value;
+            }
+            break;
     }
-    else
-        switch (*pos_)
-        {
-            case '\0':
-                found = juncture::done;
-                end = pos_;
-                break;
-            case '{':
-                found = juncture::row_start;
-                end = pos_ + 1;
-                break;
-            case '}':
-                found = juncture::row_end;
-                end = pos_ + 1;
-                break;
-            case '\'':
-                found = juncture::string_value;
-                end = scan_single_quoted_string(pos_);
-                value = parse_single_quoted_string(pos_, end);
-                break;
-            case '"':
-                found = juncture::string_value;
-                end = scan_double_quoted_string(pos_);
-                value = parse_double_quoted_string(pos_, end);
-                break;
-            default:
-                end = scan_unquoted_string(pos_);
-                value = parse_unquoted_string(pos_, end);
-                if (value == "NULL")
-                {
-                    // In this one situation, as a special case, NULL means a
-                    // null field, not a string that happens to spell "NULL".
-                    value.clear();
-                    found = juncture::null_value;
-                }
-                else
-                {
-                    // The normal case: we just parsed an unquoted string.  The
-                    // value is what we need.
-                    found = juncture::string_value;
-                }
-                break;
-        }
 
     // Skip a field separator following a string (or null).
-    if (end != nullptr && (*end == ',' || *end == ';'))
+    if (end != end_ && (*end == ',' || *end == ';'))
         end++;
 
     pos_ = end;
-    return std::make_pair(found, value);
+    return token;
+}
+
+void ArrayParser::unescape(const Token &token, std::string &out)
+{
+    if (!token.escaped)
+    {
+        out.append(token.text);
+        return;
+    }
+    out.reserve(out.size() + token.text.size());
+    auto here = token.text.data();
+    auto end = here + token.text.size();
+    while (here < end)
+    {
+        auto next = find_any_of(here, end, '\\', token.quote, token.quote);
+        out.append(here, next);
+        if (next == end)
+            break;
+        // The character after an escape (a backslash, or the first quote of
+        // a doubled single quote) is taken literally.  The scanner has made
+        // sure it exists.
+        out.push_back(next[1]);
+        here = next + 2;
+    }
+}
+
+std::pair<ArrayParser::juncture, std::string> ArrayParser::getNext()
+{
+    auto token = nextToken();
+    std::string value;
+    if (token.type == juncture::string_value)
+        unescape(token, value);
+    return std::make_pair(token.type, std::move(value));
 }
@@ -5,8 +5,10 @@
 #ifndef ARRAYPARSER_H
 #define ARRAYPARSER_H
 
+#include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace cxk
@@ -21,6 +23,10 @@ namespace cxk
      *
      * 通过调用@c getNext解析数组，直到返回@c juncture为"done"。
      * @c juncture指示解析器在该步骤中找到的内容：数组是“嵌套”到更深层次，还是“取消嵌套”回退。
+     *
+     * nextToken()不分配内存，值以指向输入的string_view返回，
+     * 只有带转义的引号字符串需要再经unescape()得到真正的值。
+     * 引号和分隔符用SSE2/AVX2按块查找。
      */
     class ArrayParser
     {
@@ -40,9 +46,24 @@ namespace cxk
             done,
         };
 
-        /// 构造函数。无需直接使用此构造函数，应使用@c field::as_array代替。
+        /// nextToken()的一步解析结果
+        struct Token
+        {
+            juncture type;
+            /// string_value时为值的文本（不含两侧引号），其余情况为空
+            std::string_view text;
+            /// 值所在的引号（'\''或'"'），没有引号时为0
+            char quote{0};
+            /// text中含有转义，需要经unescape()才能得到值
+            bool escaped{false};
+        };
+
+        /// 构造函数。无需直接使用此构造函数，应使用@c Field::asArray代替。
         explicit ArrayParser(const char input[]);
 
+        /// 输入长度已知时使用，input[length]之后的内容不会被读取
+        ArrayParser(const char input[], size_t length);
+
         /// 解析数组中的下一步内容
         /** 返回解析到的内容。如果@c juncture为@c string_value，字符串将包含对应值；
          * 否则，字符串为空。
@@ -51,9 +72,20 @@ namespace cxk
          */
         std::pair<juncture, std::string> getNext();
 
+        /// 解析数组中的下一步内容，不拷贝值
+        /** 返回的text指向构造时的输入，输入需要保持有效。
+         * 持续调用直至返回的type为@c done。
+         */
+        Token nextToken();
+
+        /// 把带转义的token的值追加到out末尾，没有转义时直接追加text
+        static void unescape(const Token &token, std::string &out);
+
     private:
         /// 输入字符串中的当前解析位置
         const char *pos_;
+        /// 输入的结尾
+        const char *end_;
     };
 
 }  // namespace orm
@@ -0,0 +1,508 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#include "ArrowBatch.h"
+#include "Exception.h"
+#include "NumberParser.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+using namespace cxk;
+
+namespace
+{
+ArrowColumn::Type arrowTypeOf(ColumnKind kind)
+{
+    switch (kind)
+    {
+        case ColumnKind::Integer:
+            return ArrowColumn::Type::Int64;
+        case ColumnKind::UnsignedInteger:
+            return ArrowColumn::Type::UInt64;
+        case ColumnKind::Real:
+            return ArrowColumn::Type::Float64;
+        case ColumnKind::Binary:
+        case ColumnKind::Bit:
+            return ArrowColumn::Type::Binary;
+        default:
+            return ArrowColumn::Type::Utf8;
+    }
+}
+
+template <typename T>
+void appendValue(std::vector<uint8_t> &values, T value)
+{
+    auto pos = values.size();
+    values.resize(pos + sizeof(T));
+    memcpy(values.data() + pos, &value, sizeof(T));
+}
+
+/**
+ * 只够写Arrow IPC元数据的FlatBuffers编码器
+ *
+ * 与官方实现从后往前构建不同，这里从前往后写：先写父对象并留出偏移，
+ * 子对象写在后面再回填。FlatBuffers的uoffset只要求被引用的对象位于引用处之后，
+ * 两种顺序都合法。每个表的vtable紧挨在表之前。
+ */
+class FlatBufferWriter
+{
+  public:
+    struct Table
+    {
+        size_t start;                ///< 表在缓冲区中的位置，引用表的偏移指向这里
+        std::vector<size_t> fields;  ///< 每个字段的绝对位置，不存在的字段为0
+    };
+
+    /**
+     * @brief 写一个表，sizes[i]为第i个字段的字节数，0表示字段不存在
+     */
+    Table table(const std::vector<uint8_t> &sizes)
+    {
+        std::vector<size_t> order(sizes.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        // 大字段在前，减少对齐填充
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return sizes[a] > sizes[b];
+        });
+        std::vector<uint16_t> fieldOffsets(sizes.size(), 0);
+        size_t inlineSize = 4;
+        size_t tableAlign = 4;
+        for (auto i : order)
+        {
+            if (sizes[i] == 0)
+                continue;
+            inlineSize = alignUp(inlineSize, sizes[i]);
+            fieldOffsets[i] = static_cast<uint16_t>(inlineSize);
+            inlineSize += sizes[i];
+            tableAlign = std::max<size_t>(tableAlign, sizes[i]);
+        }
+
+        pad(2);
+        auto vtable = buf_.size();
+        append<uint16_t>(static_cast<uint16_t>(4 + 2 * sizes.size()));
+        append<uint16_t>(static_cast<uint16_t>(inlineSize));
+        for (auto offset : fieldOffsets)
+            append<uint16_t>(offset);
+        pad(tableAlign);
+        auto start = buf_.size();
+        append<int32_t>(static_cast<int32_t>(start - vtable));
+        buf_.resize(start + inlineSize, '\0');
+
+        Table result{start, std::vector<size_t>(sizes.size(), 0)};
+        for (size_t i = 0; i < sizes.size(); ++i)
+        {
+            if (fieldOffsets[i])
+                result.fields[i] = start + fieldOffsets[i];
+        }
+        return result;
+    }
+
+    template <typename T>
+    void set(size_t pos, T value)
+    {
+        memcpy(&buf_[pos], &value, sizeof(T));
+    }
+
+    // 让pos处的uoffset指向target，target必须位于pos之后
+    void link(size_t pos, size_t target)
+    {
+        set<uint32_t>(pos, static_cast<uint32_t>(target - pos));
+    }
+
+    size_t string(std::string_view text)
+    {
+        pad(4);
+        auto start = buf_.size();
+        append<uint32_t>(static_cast<uint32_t>(text.size()));
+        buf_.append(text.data(), text.size());
+        buf_.push_back('\0');
+        return start;
+    }
+
+    /**
+     * @brief 写一个元素为elementSize字节结构体的向量，返回向量位置
+     */
+    size_t structVector(const void *data, size_t count, size_t elementSize)
+    {
+        // 长度字段之后的元素需要按8字节对齐
+        pad(8);
+        buf_.append(4, '\0');
+        auto start = buf_.size();
+        append<uint32_t>(static_cast<uint32_t>(count));
+        buf_.append(static_cast<const char *>(data), count * elementSize);
+        return start;
+    }
+
+    /**
+     * @brief 写一个偏移向量，元素i位于返回值 + 4 + 4 * i，由调用者回填
+     */
+    size_t offsetVector(size_t count)
+    {
+        pad(4);
+        auto start = buf_.size();
+        append<uint32_t>(static_cast<uint32_t>(count));
+        buf_.append(count * 4, '\0');
+        return start;
+    }
+
+    size_t size() const noexcept
+    {
+        return buf_.size();
+    }
+
+    std::string &buffer() noexcept
+    {
+        return buf_;
+    }
+
+    void pad(size_t alignment)
+    {
+        buf_.resize(alignUp(buf_.size(), alignment), '\0');
+    }
+
+  private:
+    static size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    template <typename T>
+    void append(T value)
+    {
+        buf_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    std::string buf_;
+};
+
+// Arrow IPC格式中的枚举值，见format/Message.fbs和format/Schema.fbs
+constexpr int16_t kMetadataV5 = 4;
+constexpr uint8_t kHeaderSchema = 1;
+constexpr uint8_t kHeaderRecordBatch = 3;
+constexpr uint8_t kTypeInt = 2;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint8_t kTypeBinary = 4;
+constexpr uint8_t kTypeUtf8 = 5;
+constexpr int16_t kPrecisionDouble = 2;
+constexpr uint32_t kContinuation = 0xFFFFFFFF;
+
+// 写根偏移和Message表（version、header_type、header、bodyLength），
+// 返回header偏移的位置，由调用者指向随后写入的Schema或RecordBatch
+size_t beginMessage(FlatBufferWriter &fb, uint8_t headerType, int64_t bodyLength)
+{
+    fb.buffer().append(4, '\0');
+    auto message = fb.table({2, 1, 4, 8});
+    fb.link(0, message.start);
+    fb.set<int16_t>(message.fields[0], kMetadataV5);
+    fb.set<uint8_t>(message.fields[1], headerType);
+    fb.set<int64_t>(message.fields[3], bodyLength);
+    return message.fields[2];
+}
+
+void writeFieldType(FlatBufferWriter &fb,
+                    ArrowColumn::Type type,
+                    size_t typeTypePos,
+                    size_t typePos)
+{
+    size_t table;
+    switch (type)
+    {
+        case ArrowColumn::Type::Int64:
+        case ArrowColumn::Type::UInt64:
+        {
+            auto intType = fb.table({4, 1});
+            table = intType.start;
+            fb.set<int32_t>(intType.fields[0], 64);
+            fb.set<uint8_t>(intType.fields[1], type == ArrowColumn::Type::Int64);
+            fb.set<uint8_t>(typeTypePos, kTypeInt);
+            break;
+        }
+        case ArrowColumn::Type::Float64:
+        {
+            auto floatType = fb.table({2});
+            table = floatType.start;
+            fb.set<int16_t>(floatType.fields[0], kPrecisionDouble);
+            fb.set<uint8_t>(typeTypePos, kTypeFloatingPoint);
+            break;
+        }
+        case ArrowColumn::Type::Binary:
+        case ArrowColumn::Type::Utf8:
+        default:
+        {
+            table = fb.table({}).start;
+            fb.set<uint8_t>(typeTypePos,
+                            type == ArrowColumn::Type::Binary ? kTypeBinary
+                                                              : kTypeUtf8);
+            break;
+        }
+    }
+    fb.link(typePos, table);
+}
+
+// 加上连续标记和长度前缀，元数据按8字节对齐
+void appendMessage(std::string &out, FlatBufferWriter &fb)
+{
+    fb.pad(8);
+    auto length = static_cast<int32_t>(fb.size());
+    out.append(reinterpret_cast<const char *>(&kContinuation), 4);
+    out.append(reinterpret_cast<const char *>(&length), 4);
+    out.append(fb.buffer());
+}
+
+struct BodyBuffer
+{
+    const void *data;
+    int64_t length;
+};
+
+size_t padded(size_t length)
+{
+    return (length + 7) / 8 * 8;
+}
+}  // namespace
+
+void ArrowBatch::exportColumn(const Result &result,
+                              Result::RowSizeType column,
+                              ArrowColumn &out)
+{
+    out.name = result.columnName(column);
+    out.type = arrowTypeOf(result.columnKind(column));
+    auto rows = result.size();
+    ColumnCells cells;
+    bool contiguous = result.columnCells(column, cells);
+    bool variable = out.type == ArrowColumn::Type::Utf8 ||
+                    out.type == ArrowColumn::Type::Binary;
+    if (variable)
+    {
+        out.offsets.reserve(rows + 1);
+        out.offsets.push_back(0);
+    }
+    else
+    {
+        out.values.reserve(rows * 8);
+    }
+    for (Result::SizeType row = 0; row < rows; ++row)
+    {
+        const char *value;
+        unsigned long length;
+        if (contiguous)
+        {
+            value = cells.values[row * cells.stride];
+            length = value ? cells.lengths[row * cells.stride] : 0;
+        }
+        else
+        {
+            value = result.getValue(row, column);
+            length = value ? result.getLength(row, column) : 0;
+        }
+        if (!value)
+        {
+            if (out.nullCount++ == 0)
+            {
+                // 第一次遇到NULL时才分配位图，之前的行都有效
+                out.validity.assign((rows + 7) / 8, 0);
+                for (Result::SizeType i = 0; i < row; ++i)
+                    out.validity[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+            }
+            if (variable)
+                out.offsets.push_back(out.offsets.back());
+            else
+                appendValue<uint64_t>(out.values, 0);
+            continue;
+        }
+        if (!out.validity.empty())
+            out.validity[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+        std::string_view text(value, length);
+        bool ok = true;
+        switch (out.type)
+        {
+            case ArrowColumn::Type::Int64:
+            {
+                int64_t v;
+                ok = detail::parseNumber(text, v);
+                appendValue(out.values, v);
+                break;
+            }
+            case ArrowColumn::Type::UInt64:
+            {
+                uint64_t v;
+                ok = detail::parseNumber(text, v);
+                appendValue(out.values, v);
+                break;
+            }
+            case ArrowColumn::Type::Float64:
+            {
+                double v;
+                ok = detail::parseNumber(text, v);
+                appendValue(out.values, v);
+                break;
+            }
+            default:
+                if (out.values.size() + length >
+                    static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                    throw RangeError(std::string("Column ") + out.name +
+                                     " is too large for 32-bit offsets");
+                out.values.insert(out.values.end(), value, value + length);
+                out.offsets.push_back(static_cast<int32_t>(out.values.size()));
+                break;
+        }
+        if (!ok)
+            throw ConversionError(std::string("Cannot convert the value \"") +
+                                  std::string(text) + "\" of column " +
+                                  out.name + " to a number");
+    }
+}
+
+ArrowBatch ArrowBatch::fromResult(const Result &result, unsigned threads)
+{
+    ArrowBatch batch;
+    batch.rows_ = static_cast<int64_t>(result.size());
+    auto columnCount = result.columns();
+    batch.columns_.resize(columnCount);
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(
+        std::min<size_t>(threads, columnCount));
+
+    // 各线程按列号依次领取，第一个异常在所有线程结束后重新抛出
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> errors(columnCount);
+    auto work = [&]() {
+        for (size_t column = next++; column < columnCount; column = next++)
+        {
+            try
+            {
+                exportColumn(result, column, batch.columns_[column]);
+            }
+            catch (...)
+            {
+                errors[column] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker : workers)
+        worker.join();
+    for (auto &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+    return batch;
+}
+
+void ArrowBatch::writeIpcStream(std::string &out) const
+{
+    // Schema消息
+    {
+        FlatBufferWriter fb;
+        auto header = beginMessage(fb, kHeaderSchema, 0);
+        // Schema表：endianness（默认Little）、fields
+        auto schema = fb.table({0, 4});
+        fb.link(header, schema.start);
+        auto fieldVector = fb.offsetVector(columns_.size());
+        fb.link(schema.fields[1], fieldVector);
+        for (size_t i = 0; i < columns_.size(); ++i)
+        {
+            auto &column = columns_[i];
+            // Field表：name、nullable、type_type、type、dictionary、children
+            auto field = fb.table({4, 1, 1, 4, 0, 4});
+            fb.link(fieldVector + 4 + 4 * i, field.start);
+            fb.set<uint8_t>(field.fields[1], 1);
+            fb.link(field.fields[0], fb.string(column.name));
+            writeFieldType(fb, column.type, field.fields[2], field.fields[3]);
+            fb.link(field.fields[5], fb.offsetVector(0));
+        }
+        appendMessage(out, fb);
+    }
+
+    // RecordBatch消息，所有缓冲区按8字节对齐依次放在消息体中
+    struct FieldNode
+    {
+        int64_t length;
+        int64_t nullCount;
+    };
+    struct Buffer
+    {
+        int64_t offset;
+        int64_t length;
+    };
+    std::vector<FieldNode> nodes;
+    std::vector<Buffer> buffers;
+    std::vector<BodyBuffer> bodies;
+    int64_t bodyLength = 0;
+    auto addBuffer = [&](const void *data, size_t length) {
+        buffers.push_back({bodyLength, static_cast<int64_t>(length)});
+        bodies.push_back({data, static_cast<int64_t>(length)});
+        bodyLength += padded(length);
+    };
+    for (auto &column : columns_)
+    {
+        nodes.push_back({rows_, column.nullCount});
+        addBuffer(column.validity.data(),
+                  column.nullCount ? column.validity.size() : 0);
+        if (column.type == ArrowColumn::Type::Utf8 ||
+            column.type == ArrowColumn::Type::Binary)
+            addBuffer(column.offsets.data(),
+                      column.offsets.size() * sizeof(int32_t));
+        addBuffer(column.values.data(), column.values.size());
+    }
+    {
+        FlatBufferWriter fb;
+        auto header = beginMessage(fb, kHeaderRecordBatch, bodyLength);
+        // RecordBatch表：length、nodes、buffers
+        auto batch = fb.table({8, 4, 4});
+        fb.link(header, batch.start);
+        fb.set<int64_t>(batch.fields[0], rows_);
+        fb.link(batch.fields[1],
+                fb.structVector(nodes.data(), nodes.size(), sizeof(FieldNode)));
+        fb.link(batch.fields[2],
+                fb.structVector(buffers.data(),
+                                buffers.size(),
+                                sizeof(Buffer)));
+        appendMessage(out, fb);
+    }
+    out.reserve(out.size() + bodyLength + 8);
+    for (auto &body : bodies)
+    {
+        out.append(static_cast<const char *>(body.data), body.length);
+        out.append(padded(body.length) - body.length, '\0');
+    }
+
+    // 结束标记
+    out.append(reinterpret_cast<const char *>(&kContinuation), 4);
+    out.append(4, '\0');
+}
+
+void ArrowBatch::writeIpcStream(int fd) const
+{
+    std::string stream;
+    writeIpcStream(stream);
+    size_t written = 0;
+    while (written < stream.size())
+    {
+        auto n = ::write(fd, stream.data() + written, stream.size() - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno,
+                                    std::generic_category(),
+                                    "write arrow stream");
+        }
+        written += static_cast<size_t>(n);
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef ARROWBATCH_H
+#define ARROWBATCH_H
+
+#include "Result.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 按Apache Arrow列式内存布局保存的一列
+ *
+ * - validity：有效位图，第i行对应validity[i / 8]的第i % 8位，1表示非NULL；
+ *   没有NULL时为空
+ * - 定长类型（Int64、UInt64、Float64）：values按小端保存length个值，NULL处为0
+ * - 变长类型（Utf8、Binary）：offsets保存length + 1个int32偏移，
+ *   第i个值为values[offsets[i], offsets[i + 1])
+ */
+struct ArrowColumn
+{
+    enum class Type
+    {
+        Int64,
+        UInt64,
+        Float64,
+        Utf8,
+        Binary,
+    };
+
+    std::string name;
+    Type type;
+    int64_t nullCount{0};
+    std::vector<uint8_t> validity;
+    std::vector<int32_t> offsets;
+    std::vector<uint8_t> values;
+};
+
+/**
+ * @brief 结果集的Arrow列式导出
+ *
+ * 列类型由Result::columnKind()决定：整数导出为Int64/UInt64，FLOAT、DOUBLE
+ * 导出为Float64，二进制列导出为Binary，其余（包括DECIMAL和时间类型）
+ * 按文本导出为Utf8。各列相互独立，导出时按列并行。
+ *
+ * writeIpcStream()按Arrow IPC流格式（Schema消息、一个RecordBatch消息和
+ * 结束标记）输出，可以直接被pyarrow.ipc.open_stream等读取。
+ */
+class ArrowBatch
+{
+  public:
+    /**
+     * @brief 把result导出为列式批
+     * @param threads 并行的线程数，0表示按硬件线程数，不超过列数
+     * @throw ConversionError 数值列中存在无法解析的字段
+     */
+    static ArrowBatch fromResult(const Result &result, unsigned threads = 0);
+
+    int64_t rows() const noexcept
+    {
+        return rows_;
+    }
+
+    const std::vector<ArrowColumn> &columns() const noexcept
+    {
+        return columns_;
+    }
+
+    /**
+     * @brief 把IPC流追加到out末尾
+     */
+    void writeIpcStream(std::string &out) const;
+
+    /**
+     * @brief 把IPC流写入文件描述符fd，写入失败时抛出std::system_error
+     */
+    void writeIpcStream(int fd) const;
+
+  private:
+    static void exportColumn(const Result &result,
+                             Result::RowSizeType column,
+                             ArrowColumn &out);
+
+    int64_t rows_{0};
+    std::vector<ArrowColumn> columns_;
+};
+
+}  // namespace cxk
+
+#endif  // ARROWBATCH_H
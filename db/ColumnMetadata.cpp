@@ -0,0 +1,171 @@
+//
+// Created by cxk_zjq on 25-6-28.
+//
+
+#include "ColumnMetadata.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace cxk;
+
+namespace
+{
+constexpr size_t kMaxCachedShapes = 4096;
+
+inline unsigned char foldCase(unsigned char c) noexcept
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + 32) : c;
+}
+
+// 忽略ASCII大小写的FNV-1a
+inline uint64_t hashName(std::string_view name) noexcept
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : name)
+    {
+        hash ^= foldCase(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (foldCase(a[i]) != foldCase(b[i]))
+            return false;
+    }
+    return true;
+}
+}  // namespace
+
+namespace cxk
+{
+struct ColumnMetadataCache
+{
+    std::shared_mutex mutex;
+    std::unordered_multimap<uint64_t, ColumnMetadataPtr> shapes;
+
+    static ColumnMetadataCache &instance()
+    {
+        static ColumnMetadataCache cache;
+        return cache;
+    }
+
+    ColumnMetadataPtr find(uint64_t hash,
+                           const ColumnDesc *columns,
+                           size_t count) const
+    {
+        auto range = shapes.equal_range(hash);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (iter->second->matches(columns, count))
+                return iter->second;
+        }
+        return nullptr;
+    }
+};
+}  // namespace cxk
+
+ColumnMetadata::ColumnMetadata(const ColumnDesc *columns, size_t count)
+{
+    names_.reserve(count);
+    types_.reserve(count);
+    flags_.reserve(count);
+    kinds_.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        names_.emplace_back(columns[i].name);
+        types_.push_back(columns[i].type);
+        flags_.push_back(columns[i].flags);
+        kinds_.push_back(columns[i].kind);
+    }
+    // 装载因子不超过1/2
+    size_t capacity = 2;
+    while (capacity < count * 2)
+        capacity <<= 1;
+    slots_.assign(capacity, -1);
+    mask_ = capacity - 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (auto pos = hashName(names_[i]) & mask_;; pos = (pos + 1) & mask_)
+        {
+            auto &slot = slots_[pos];
+            if (slot < 0 || equalsIgnoreCase(names_[slot], names_[i]))
+            {
+                slot = static_cast<int32_t>(i);
+                break;
+            }
+        }
+    }
+}
+
+long ColumnMetadata::find(std::string_view name) const noexcept
+{
+    for (auto pos = hashName(name) & mask_;; pos = (pos + 1) & mask_)
+    {
+        auto slot = slots_[pos];
+        if (slot < 0)
+            return -1;
+        if (equalsIgnoreCase(names_[slot], name))
+            return slot;
+    }
+}
+
+bool ColumnMetadata::matches(const ColumnDesc *columns,
+                             size_t count) const noexcept
+{
+    if (count != names_.size())
+        return false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (columns[i].name != names_[i] || columns[i].type != types_[i] ||
+            columns[i].flags != flags_[i] || columns[i].kind != kinds_[i])
+            return false;
+    }
+    return true;
+}
+
+uint64_t ColumnMetadata::shapeHash(const ColumnDesc *columns,
+                                   size_t count) noexcept
+{
+    uint64_t hash = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        // 形状区分大小写，这里只用于分桶，大小写不同的列名由matches()区分
+        hash = hash * 31 + hashName(columns[i].name);
+        hash = hash * 31 + static_cast<uint64_t>(columns[i].type);
+        hash = hash * 31 + columns[i].flags;
+        hash = hash * 31 + static_cast<uint64_t>(columns[i].kind);
+    }
+    return hash;
+}
+
+ColumnMetadataPtr ColumnMetadata::get(const ColumnDesc *columns, size_t count)
+{
+    auto &cache = ColumnMetadataCache::instance();
+    auto hash = shapeHash(columns, count);
+    {
+        std::shared_lock<std::shared_mutex> lock(cache.mutex);
+        if (auto metadata = cache.find(hash, columns, count))
+            return metadata;
+    }
+    auto metadata = std::make_shared<const ColumnMetadata>(columns, count);
+    std::unique_lock<std::shared_mutex> lock(cache.mutex);
+    if (auto existing = cache.find(hash, columns, count))
+        return existing;
+    if (cache.shapes.size() < kMaxCachedShapes)
+        cache.shapes.emplace(hash, metadata);
+    return metadata;
+}
+
+size_t ColumnMetadata::cachedShapes()
+{
+    auto &cache = ColumnMetadataCache::instance();
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+    return cache.shapes.size();
+}
@@ -0,0 +1,108 @@
+//
+// Created by cxk_zjq on 25-6-28.
+//
+
+#ifndef COLUMNMETADATA_H
+#define COLUMNMETADATA_H
+
+#include <db/DbTypes.h>
+#include <NonCopyable.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cxk
+{
+class ColumnMetadata;
+using ColumnMetadataPtr = std::shared_ptr<const ColumnMetadata>;
+
+/**
+ * @brief 构造ColumnMetadata时对一列的描述，type和flags的含义由具体驱动决定，
+ * kind是驱动换算出的通用分类
+ */
+struct ColumnDesc
+{
+    std::string_view name;
+    int type;
+    unsigned int flags;
+    ColumnKind kind{ColumnKind::Unknown};
+};
+
+/**
+ * @brief 结果集的列信息：列名、类型以及按列名查找列号的索引
+ *
+ * 列名索引是开放寻址的扁平哈希表，按ASCII忽略大小写，查找不分配内存。
+ * 同名的列以最后一列为准。
+ *
+ * 通过get()获取的对象按列的“形状”（列名、类型、标志）缓存在进程级的表中，
+ * 同一条语句的所有结果共享一份。
+ */
+class ColumnMetadata : public NonCopyable
+{
+  public:
+    /**
+     * @brief 获取（必要时创建并缓存）与columns形状相同的列信息，线程安全
+     *
+     * 缓存达到上限后新的形状只创建不缓存。
+     */
+    static ColumnMetadataPtr get(const ColumnDesc *columns, size_t count);
+
+    /**
+     * @brief 直接创建，不经过缓存
+     */
+    ColumnMetadata(const ColumnDesc *columns, size_t count);
+
+    size_t size() const noexcept
+    {
+        return names_.size();
+    }
+
+    const char *name(size_t column) const noexcept
+    {
+        return names_[column].c_str();
+    }
+
+    int type(size_t column) const noexcept
+    {
+        return types_[column];
+    }
+
+    unsigned int flags(size_t column) const noexcept
+    {
+        return flags_[column];
+    }
+
+    ColumnKind kind(size_t column) const noexcept
+    {
+        return kinds_[column];
+    }
+
+    /**
+     * @brief 按列名（忽略ASCII大小写）查找列号，不存在时返回-1
+     */
+    long find(std::string_view name) const noexcept;
+
+    /**
+     * @brief 当前缓存的列信息数量
+     */
+    static size_t cachedShapes();
+
+  private:
+    friend struct ColumnMetadataCache;
+
+    bool matches(const ColumnDesc *columns, size_t count) const noexcept;
+    static uint64_t shapeHash(const ColumnDesc *columns, size_t count) noexcept;
+
+    std::vector<std::string> names_;
+    std::vector<int> types_;
+    std::vector<unsigned int> flags_;
+    std::vector<ColumnKind> kinds_;
+    std::vector<int32_t> slots_;  ///< 哈希槽，保存列号，-1表示空槽
+    size_t mask_{0};
+};
+
+}  // namespace cxk
+
+#endif  // COLUMNMETADATA_H
@@ -1,3 +1,771 @@
 //
 // Created by cxk_zjq on 25-5-27.
 //
+
+#include "DatabaseManager.h"
+#include "MySQLImpl/MySQLConnector.h"
+#include "MySQLImpl/MySQLQueryKiller.h"
+#include "MySQLImpl/MySQLSyncConnector.h"
+#include "MySQLImpl/MySQLXConnector.h"
+#include "DbTypes.h"
+#include "Exception.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace cxk;
+
+std::shared_ptr<DatabaseManager> DatabaseManager::newMySQLPool(
+    const std::string &connInfo,
+    size_t connNum,
+    size_t threadNum)
+{
+    auto pool =
+        std::make_shared<DatabaseManager>(connInfo, connNum, threadNum);
+    pool->init();
+    return pool;
+}
+
+DatabaseManager::DatabaseManager(const std::string &connInfo,
+                                 size_t connNum,
+                                 size_t threadNum)
+    : connInfo_(connInfo),
+      numberOfConnections_(connNum),
+      loops_(threadNum < 1 ? 1 : threadNum, "DbConnectionLoop")
+{
+    assert(connNum > 0);
+    for (auto const &kv : DbConnection::parseConnString(connInfo))
+    {
+        auto key = kv.first;
+        std::transform(key.begin(),
+                       key.end(),
+                       key.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (key == "protocol")
+            xProtocol_ = kv.second == "x" || kv.second == "X";
+    }
+    if (!xProtocol_)
+        killer_ = std::make_shared<MySQLQueryKiller>(connInfo_);
+}
+
+DatabaseManager::~DatabaseManager()
+{
+    closeAll();
+}
+
+void DatabaseManager::init()
+{
+    loops_.start();
+    std::weak_ptr<DatabaseManager> weakPtr = shared_from_this();
+    for (size_t i = 0; i < numberOfConnections_; ++i)
+    {
+        auto loop = loops_.getNextLoop();
+        // 在连接所属的线程中创建，保证MysqlThreadEnv在该线程初始化
+        loop->queueInLoop([weakPtr, loop]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+            thisPtr->connections_.insert(thisPtr->newConnection(loop));
+        });
+    }
+}
+
+void DatabaseManager::closeAll()
+{
+    std::unordered_set<DbConnectionPtr> connections;
+    std::vector<std::shared_ptr<Transaction>> transactions;
+    std::deque<TransactionWaiter> transWaiters;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        connections.swap(connections_);
+        readyConnections_.clear();
+        busyConnections_.clear();
+        for (auto const &item : transConnections_)
+        {
+            if (auto trans = item.second.lock())
+                transactions.push_back(std::move(trans));
+        }
+        transConnections_.clear();
+        transWaiters.swap(transWaiters_);
+    }
+    // 断开后不会再有空闲或关闭通知，排队的事务和事务中的语句在这里结束
+    for (auto const &trans : transactions)
+        trans->onClosed();
+    auto exceptPtr = std::make_exception_ptr(
+        BrokenConnection("The connection pool has been closed"));
+    for (auto &waiter : transWaiters)
+    {
+        if (waiter.second)
+            waiter.second(exceptPtr);
+    }
+    for (auto const &conn : connections)
+    {
+        conn->disconnect();
+    }
+}
+
+size_t DatabaseManager::connectionsNumber() const
+{
+    std::lock_guard<std::mutex> guard(connectionsMutex_);
+    return connections_.size();
+}
+
+bool DatabaseManager::hasAvailableConnections() const
+{
+    std::lock_guard<std::mutex> guard(connectionsMutex_);
+    return !readyConnections_.empty();
+}
+
+size_t DatabaseManager::inflightQueries() const
+{
+    std::lock_guard<std::mutex> guard(flightsMutex_);
+    return flights_.size();
+}
+
+void DatabaseManager::execSql(std::string_view &&sql,
+                              size_t paraNum,
+                              std::vector<const char *> &&parameters,
+                              std::vector<int> &&length,
+                              std::vector<int> &&format,
+                              ResultCallback &&rcb,
+                              ExceptPtrCallback &&exceptCallback)
+{
+    assert(paraNum == parameters.size());
+    assert(paraNum == length.size());
+    assert(paraNum == format.size());
+    (void)paraNum;
+    execSql(std::move(sql),
+            std::make_shared<VectorSqlBinder>(std::move(parameters),
+                                              std::move(length),
+                                              std::move(format)),
+            std::move(rcb),
+            std::move(exceptCallback));
+}
+
+void DatabaseManager::execSql(std::string_view &&sql,
+                              SqlBinderPtr &&binder,
+                              ResultCallback &&rcb,
+                              ExceptPtrCallback &&exceptCallback)
+{
+    assert(binder);
+    assert(rcb);
+    applyDefaults(*binder);
+    auto cache = cache_;
+    bool shareable = isShareable(sql, *binder);
+    ResultCallback store;
+    if (cache && shareable)
+    {
+        auto key = makeFlightKey(utils::normalizeSql(sql), *binder);
+        if (auto hit = cache->get(key))
+        {
+            if (hit->refresh)
+                refreshCacheEntry(cache, key, sql, *binder);
+            // 与未命中时一样在IO线程中回调，调用者不会在execSql()内部被重入
+            loops_.getNextLoop()->queueInLoop(
+                [rcb = std::move(rcb), result = std::move(hit->result)]() {
+                    rcb(result);
+                });
+            return;
+        }
+        auto epoch = cache->epoch();
+        store = [cache,
+                 key = std::move(key),
+                 tables = utils::extractTables(sql),
+                 epoch](const Result &r) { cache->put(key, r, tables, epoch); };
+    }
+    if (!shareable && (cache || coalescing_) && utils::mayModifyData(sql))
+    {
+        // 在此之后发出的查询不能再挂到之前在途的相同查询上，它可能读不到这次写入
+        auto tables = std::make_shared<std::vector<std::string>>(
+            utils::extractTables(sql));
+        closeFlights(*tables);
+        // 失败的写入也可能已经部分生效（多语句），同样做失效处理
+        std::weak_ptr<DatabaseManager> weakPtr = shared_from_this();
+        rcb = [weakPtr, tables, rcb = std::move(rcb)](const Result &r) {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->finishWrite(*tables);
+            rcb(r);
+        };
+        exceptCallback =
+            [weakPtr, tables, exceptCallback = std::move(exceptCallback)](
+                const std::exception_ptr &e) {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->finishWrite(*tables);
+                if (exceptCallback)
+                    exceptCallback(e);
+            };
+    }
+    runSql(std::move(sql),
+           std::move(binder),
+           std::move(rcb),
+           std::move(exceptCallback),
+           std::move(store));
+}
+
+namespace
+{
+// 每个线程按连接池保存的阻塞连接，连接池析构后在下次访问时清理
+struct ThreadConnection
+{
+    std::weak_ptr<DatabaseManager> pool;
+    std::unique_ptr<MySQLSyncConnector> conn;
+};
+thread_local std::vector<ThreadConnection> t_threadConnections;
+}  // namespace
+
+MySQLSyncConnector &DatabaseManager::threadConnection()
+{
+    auto self = shared_from_this();
+    auto &conns = t_threadConnections;
+    conns.erase(std::remove_if(conns.begin(),
+                               conns.end(),
+                               [](const ThreadConnection &c) {
+                                   return c.pool.expired();
+                               }),
+                conns.end());
+    auto iter = std::find_if(conns.begin(),
+                             conns.end(),
+                             [&self](const ThreadConnection &c) {
+                                 return !c.pool.owner_before(self) &&
+                                        !self.owner_before(c.pool);
+                             });
+    if (iter != conns.end() && iter->conn->connected())
+        return *iter->conn;
+    // 首次使用或连接已断开时重新建立，失败时异常直接抛给调用者
+    auto conn = std::make_unique<MySQLSyncConnector>(connInfo_);
+    conn->setQueryKiller(killer_);
+    conn->connect();
+    if (iter != conns.end())
+    {
+        iter->conn = std::move(conn);
+        return *iter->conn;
+    }
+    conns.push_back(ThreadConnection{self, std::move(conn)});
+    return *conns.back().conn;
+}
+
+Result DatabaseManager::execSqlSync(std::string_view sql,
+                                    const SqlBinder &binder)
+{
+    if (EventLoop::getEventLoopOfCurrentThread())
+    {
+        ABSL_LOG(ERROR) << "execSqlSync() is called in an EventLoop thread: "
+                        << sql;
+        throw UsageError(
+            "execSqlSync() must not be called in an EventLoop thread");
+    }
+    // binder不可修改，与execSql()相同的默认值在这里代为生效
+    auto timeout = binder.timeout() > 0 ? binder.timeout() : timeout_;
+    auto maxResultBytes = binder.maxResultBytes() > 0 ? binder.maxResultBytes()
+                                                      : maxResultBytes_;
+    auto run = [&]() {
+        return threadConnection().execSql(sql, binder, timeout, maxResultBytes);
+    };
+    auto cache = cache_;
+    bool shareable = isShareable(sql, binder);
+    if (cache && shareable)
+    {
+        auto key = makeFlightKey(utils::normalizeSql(sql), binder);
+        auto hit = cache->get(key);
+        // 需要刷新的过期结果直接在当前线程中重新查询
+        if (hit && !hit->refresh)
+            return hit->result;
+        auto epoch = cache->epoch();
+        try
+        {
+            auto result = run();
+            cache->put(key, result, utils::extractTables(sql), epoch);
+            return result;
+        }
+        catch (...)
+        {
+            if (hit)
+                cache->finishRefresh(key);
+            throw;
+        }
+    }
+    if (shareable || !(cache || coalescing_) || !utils::mayModifyData(sql))
+        return run();
+    auto tables = utils::extractTables(sql);
+    closeFlights(tables);
+    try
+    {
+        auto result = run();
+        finishWrite(tables);
+        return result;
+    }
+    catch (...)
+    {
+        finishWrite(tables);
+        throw;
+    }
+}
+
+void DatabaseManager::applyDefaults(SqlBinder &binder) const
+{
+    if (timeout_ > 0 && binder.timeout() <= 0)
+        binder.setTimeout(timeout_);
+    if (maxResultBytes_ > 0 && binder.maxResultBytes() == 0)
+        binder.setMaxResultBytes(maxResultBytes_);
+}
+
+void DatabaseManager::closeFlights(const std::vector<std::string> &tables)
+{
+    std::lock_guard<std::mutex> guard(flightsMutex_);
+    for (auto iter = flights_.begin(); iter != flights_.end();)
+    {
+        auto const &flightTables = iter->second->tables;
+        // 提取不到表名的写入无法判断影响了哪些查询，全部关闭
+        bool affected =
+            tables.empty() ||
+            std::any_of(flightTables.begin(),
+                        flightTables.end(),
+                        [&tables](const std::string &table) {
+                            return std::find(tables.begin(),
+                                             tables.end(),
+                                             table) != tables.end();
+                        });
+        if (affected)
+            iter = flights_.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+void DatabaseManager::finishWrite(const std::vector<std::string> &tables)
+{
+    if (auto cache = cache_)
+        invalidateCache(*cache, tables);
+    // 写入完成之前下发的查询可能读到的是写入之前的数据
+    closeFlights(tables);
+}
+
+void DatabaseManager::invalidateCache(QueryCache &cache,
+                                      const std::vector<std::string> &tables)
+{
+    // 提取不到表名的写入（如CALL）无法定位条目，只能全部失效
+    if (tables.empty())
+        cache.invalidateAll();
+    else
+        cache.invalidateTables(tables);
+}
+
+namespace
+{
+// 刷新缓存时调用者已经拿到结果，不能再引用它的内存，SQL和参数都拷贝一份
+class OwnedSqlBinder : public SqlBinder
+{
+  public:
+    OwnedSqlBinder(std::string_view sql,
+                   const SqlBinder &binder,
+                   size_t (*parameterSize)(int, int))
+        : sql_(sql),
+          values_(binder.size()),
+          parameterVector_(binder.size()),
+          lengthVector_(binder.lengths(), binder.lengths() + binder.size()),
+          formatVector_(binder.formats(), binder.formats() + binder.size())
+    {
+        for (size_t i = 0; i < binder.size(); ++i)
+        {
+            auto param = binder.parameters()[i];
+            if (!param)
+                continue;
+            values_[i].assign(param,
+                              parameterSize(formatVector_[i], lengthVector_[i]));
+            parameterVector_[i] = values_[i].data();
+        }
+        size_ = binder.size();
+        timeout_ = binder.timeout();
+        maxResultBytes_ = binder.maxResultBytes();
+        parameters_ = parameterVector_.data();
+        lengths_ = lengthVector_.data();
+        formats_ = formatVector_.data();
+    }
+
+    const std::string &sql() const
+    {
+        return sql_;
+    }
+
+  private:
+    std::string sql_;
+    std::vector<std::string> values_;
+    std::vector<const char *> parameterVector_;
+    std::vector<int> lengthVector_;
+    std::vector<int> formatVector_;
+};
+}  // namespace
+
+void DatabaseManager::refreshCacheEntry(
+    const std::shared_ptr<QueryCache> &cache,
+    const std::string &key,
+    std::string_view sql,
+    const SqlBinder &binder)
+{
+    auto storage =
+        std::make_shared<OwnedSqlBinder>(sql, binder, &parameterSize);
+    auto epoch = cache->epoch();
+    std::string_view storedSql(storage->sql());
+    runSql(std::move(storedSql),
+           storage,
+           [storage](const Result &) {},
+           [cache, key, storage](const std::exception_ptr &) {
+               cache->finishRefresh(key);
+           },
+           [cache, key, storage, epoch](const Result &r) {
+               // storage同时保证了SQL文本在回调之前有效
+               cache->put(key, r, utils::extractTables(storage->sql()), epoch);
+           });
+}
+
+void DatabaseManager::runSql(std::string_view &&sql,
+                             SqlBinderPtr &&binder,
+                             ResultCallback &&rcb,
+                             ExceptPtrCallback &&exceptCallback,
+                             ResultCallback &&store)
+{
+    if (!coalescing_ || !isShareable(sql, *binder))
+    {
+        if (store)
+            rcb = [store = std::move(store), rcb = std::move(rcb)](
+                      const Result &r) {
+                store(r);
+                rcb(r);
+            };
+        dispatchSql(std::move(sql),
+                    std::move(binder),
+                    std::move(rcb),
+                    std::move(exceptCallback));
+        return;
+    }
+
+    auto key = makeFlightKey(sql, *binder);
+    std::shared_ptr<Flight> flight;
+    {
+        std::lock_guard<std::mutex> guard(flightsMutex_);
+        auto iter = flights_.find(key);
+        if (iter != flights_.end())
+        {
+            // 相同的查询已经在途，挂在它上面等待结果即可，结果由它写入缓存
+            iter->second->waiters.emplace_back(std::move(rcb),
+                                               std::move(exceptCallback));
+            return;
+        }
+        flight = std::make_shared<Flight>();
+        flight->tables = utils::extractTables(sql);
+        flights_.emplace(key, flight);
+    }
+
+    std::weak_ptr<DatabaseManager> weakPtr = shared_from_this();
+    auto leaderCallback = [weakPtr,
+                           key,
+                           flight,
+                           rcb = std::move(rcb),
+                           store = std::move(store)](const Result &r) {
+        std::vector<Waiter> waiters;
+        if (auto thisPtr = weakPtr.lock())
+            waiters = thisPtr->takeWaiters(key, flight);
+        if (store)
+            store(r);
+        rcb(r);
+        for (auto &waiter : waiters)
+        {
+            waiter.first(r);
+        }
+    };
+    auto leaderExceptCallback =
+        [weakPtr, key, flight, exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &e) {
+            std::vector<Waiter> waiters;
+            if (auto thisPtr = weakPtr.lock())
+                waiters = thisPtr->takeWaiters(key, flight);
+            if (exceptCallback)
+                exceptCallback(e);
+            for (auto &waiter : waiters)
+            {
+                if (waiter.second)
+                    waiter.second(e);
+            }
+        };
+    dispatchSql(std::move(sql),
+                std::move(binder),
+                std::move(leaderCallback),
+                std::move(leaderExceptCallback));
+}
+
+void DatabaseManager::dispatchSql(std::string_view &&sql,
+                                  SqlBinderPtr &&binder,
+                                  ResultCallback &&rcb,
+                                  ExceptPtrCallback &&exceptCallback)
+{
+    DbConnectionPtr conn;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        if (!readyConnections_.empty())
+        {
+            auto iter = readyConnections_.begin();
+            conn = *iter;
+            busyConnections_.insert(conn);
+            readyConnections_.erase(iter);
+        }
+        else
+        {
+            sqlCmdBuffer_.push_back(
+                std::make_shared<SqlCmd>(std::move(sql),
+                                         std::move(binder),
+                                         std::move(rcb),
+                                         std::move(exceptCallback)));
+            return;
+        }
+    }
+    conn->execSql(std::move(sql),
+                  std::move(binder),
+                  std::move(rcb),
+                  std::move(exceptCallback));
+}
+
+std::vector<DatabaseManager::Waiter> DatabaseManager::takeWaiters(
+    const std::string &key,
+    const std::shared_ptr<Flight> &flight)
+{
+    std::vector<Waiter> waiters;
+    std::lock_guard<std::mutex> guard(flightsMutex_);
+    waiters.swap(flight->waiters);
+    // 已经关闭的查询，键可能已经属于之后重新下发的相同查询
+    auto iter = flights_.find(key);
+    if (iter != flights_.end() && iter->second == flight)
+        flights_.erase(iter);
+    return waiters;
+}
+
+void DatabaseManager::handleNewTask(const DbConnectionPtr &conn)
+{
+    std::shared_ptr<SqlCmd> cmd;
+    TransactionWaiter transWaiter;
+    bool inTransaction = false;
+    std::shared_ptr<Transaction> trans;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        auto iter = transConnections_.find(conn);
+        if (iter != transConnections_.end())
+        {
+            inTransaction = true;
+            trans = iter->second.lock();
+        }
+        else if (!sqlCmdBuffer_.empty())
+        {
+            cmd = std::move(sqlCmdBuffer_.front());
+            sqlCmdBuffer_.pop_front();
+        }
+        else if (busyConnections_.erase(conn) > 0)
+        {
+            if (!transWaiters_.empty())
+            {
+                transWaiter = std::move(transWaiters_.front());
+                transWaiters_.pop_front();
+                transConnections_.emplace(conn, std::weak_ptr<Transaction>());
+            }
+            else
+            {
+                // 已经被关闭回调移除的连接不再放回空闲集合
+                readyConnections_.insert(conn);
+            }
+        }
+    }
+    if (inTransaction)
+    {
+        // 事务对象已经析构时，连接等待析构函数下发的回滚完成后再归还
+        if (trans)
+            trans->onIdle();
+    }
+    else if (cmd)
+    {
+        conn->execSql(std::move(cmd->sql_),
+                      std::move(cmd->binder_),
+                      std::move(cmd->callback_),
+                      std::move(cmd->exceptionCallback_));
+    }
+    else if (transWaiter.first)
+    {
+        startTransaction(conn,
+                         std::move(transWaiter.first),
+                         std::move(transWaiter.second));
+    }
+}
+
+void DatabaseManager::newTransaction(
+    std::function<void(const TransactionPtr &)> &&callback,
+    ExceptPtrCallback &&exceptCallback)
+{
+    assert(callback);
+    DbConnectionPtr conn;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        if (readyConnections_.empty())
+        {
+            transWaiters_.emplace_back(std::move(callback),
+                                       std::move(exceptCallback));
+            return;
+        }
+        auto iter = readyConnections_.begin();
+        conn = *iter;
+        readyConnections_.erase(iter);
+        transConnections_.emplace(conn, std::weak_ptr<Transaction>());
+    }
+    startTransaction(conn, std::move(callback), std::move(exceptCallback));
+}
+
+void DatabaseManager::startTransaction(
+    const DbConnectionPtr &conn,
+    std::function<void(const TransactionPtr &)> &&callback,
+    ExceptPtrCallback &&exceptCallback)
+{
+    auto trans = std::make_shared<Transaction>(shared_from_this(), conn);
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        auto iter = transConnections_.find(conn);
+        if (iter != transConnections_.end())
+            iter->second = trans;
+    }
+    conn->execSql(
+        "begin",
+        makeSqlBinder(),
+        [trans, callback = std::move(callback)](const Result &) {
+            callback(trans);
+        },
+        [trans, exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &e) {
+            {
+                std::lock_guard<std::mutex> guard(trans->mutex_);
+                trans->finished_ = true;
+            }
+            trans->releaseConnection();
+            if (exceptCallback)
+                exceptCallback(e);
+        });
+}
+
+void DatabaseManager::releaseTransactionConnection(const DbConnectionPtr &conn)
+{
+    // 随后的空闲回调会把连接放回空闲集合或派发等待中的SQL
+    std::lock_guard<std::mutex> guard(connectionsMutex_);
+    if (transConnections_.erase(conn) > 0 && connections_.count(conn) > 0)
+        busyConnections_.insert(conn);
+}
+
+DbConnectionPtr DatabaseManager::newConnection(EventLoop *loop)
+{
+    DbConnectionPtr connPtr;
+    if (connectionFactory_)
+        connPtr = connectionFactory_(loop, connInfo_);
+    else if (xProtocol_)
+        connPtr = std::make_shared<MySQLXConnector>(loop, connInfo_);
+    else
+    {
+        auto mysqlConn = std::make_shared<MySQLConnector>(loop, connInfo_);
+        mysqlConn->setQueryKiller(killer_);
+        mysqlConn->setResultBudget(resultBudget_);
+        connPtr = std::move(mysqlConn);
+    }
+    std::weak_ptr<DatabaseManager> weakPtr = shared_from_this();
+    connPtr->setCloseCallback(
+        [weakPtr, loop](const DbConnectionPtr &closeConnPtr) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            std::shared_ptr<Transaction> trans;
+            {
+                std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+                thisPtr->readyConnections_.erase(closeConnPtr);
+                thisPtr->busyConnections_.erase(closeConnPtr);
+                thisPtr->connections_.erase(closeConnPtr);
+                auto iter = thisPtr->transConnections_.find(closeConnPtr);
+                if (iter != thisPtr->transConnections_.end())
+                {
+                    trans = iter->second.lock();
+                    thisPtr->transConnections_.erase(iter);
+                }
+            }
+            if (trans)
+                trans->onClosed();
+            // 1秒后重连；closeConnPtr一直持有到定时器触发，避免在自身回调中析构
+            loop->runAfter(1.0, [weakPtr, loop, closeConnPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr)
+                    return;
+                std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+                thisPtr->connections_.insert(thisPtr->newConnection(loop));
+            });
+        });
+    connPtr->setOkCallback([weakPtr](const DbConnectionPtr &okConnPtr) {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        {
+            std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+            thisPtr->busyConnections_.insert(okConnPtr);
+        }
+        thisPtr->handleNewTask(okConnPtr);
+    });
+    std::weak_ptr<DbConnection> weakConn = connPtr;
+    connPtr->setIdleCallback([weakPtr, weakConn]() {
+        auto thisPtr = weakPtr.lock();
+        auto connPtr = weakConn.lock();
+        if (!thisPtr || !connPtr)
+            return;
+        thisPtr->handleNewTask(connPtr);
+    });
+    connPtr->init();
+    return connPtr;
+}
+
+bool DatabaseManager::isShareable(std::string_view sql,
+                                  const SqlBinder &binder)
+{
+    // 放在调用者内存资源中的结果只属于该调用者，生命周期也由调用者决定
+    return !binder.resultResource() && utils::isSelectStatement(sql) &&
+           utils::isSingleStatement(sql) && utils::isShareableQuery(sql);
+}
+
+size_t DatabaseManager::parameterSize(int format, int length)
+{
+    switch (format)
+    {
+        case cxk::type::MySqlTiny:
+            return sizeof(char);
+        case cxk::type::MySqlShort:
+            return sizeof(short);
+        case cxk::type::MySqlLong:
+            return sizeof(int32_t);
+        case cxk::type::MySqlLongLong:
+            return sizeof(int64_t);
+        case cxk::type::MySqlString:
+            return static_cast<size_t>(length);
+        default:
+            return 0;
+    }
+}
+
+std::string DatabaseManager::makeFlightKey(std::string_view sql,
+                                           const SqlBinder &binder)
+{
+    auto paraNum = binder.size();
+    auto parameters = binder.parameters();
+    auto length = binder.lengths();
+    auto format = binder.formats();
+    std::string key;
+    key.reserve(sql.size() + paraNum * 16);
+    key.append(sql.data(), sql.size());
+    for (size_t i = 0; i < paraNum; ++i)
+    {
+        auto size = parameterSize(format[i], length[i]);
+        // 参数类型和长度作为分隔，避免不同参数拼接后出现相同的键
+        key.push_back('\0');
+        key.push_back(static_cast<char>(format[i]));
+        key.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        if (size > 0 && parameters[i])
+            key.append(parameters[i], size);
+    }
+    return key;
+}
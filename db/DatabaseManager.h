@@ -5,12 +5,406 @@
 #ifndef DATABASEMANAGER_H
 #define DATABASEMANAGER_H
 
+#include <db/DbConnection.h>
+#include <db/QueryCache.h>
+#include <db/ResultMemoryBudget.h>
+#include <db/SqlBinder.h>
+#include <db/Transaction.h>
+#include <event/EventLoopThreadPool.h>
+#include <NonCopyable.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+namespace cxk
+{
+class MySQLQueryKiller;
+class MySQLSyncConnector;
 
-class DatabaseManager {
+/**
+ * @brief 数据库连接池
+ *
+ * 在内部的EventLoopThreadPool上维护固定数量的连接。有空闲连接时SQL直接派发，
+ * 否则进入等待队列，由连接空闲回调依次取出执行；连接断开后1秒自动重连。
+ *
+ * 通过setQueryCoalescing()开启后，连接池会合并同时在途的相同只读查询（single-flight）：
+ * 以SQL文本加绑定参数为键，只有第一个请求真正下发到数据库，
+ * 其余请求挂在它上面，结果返回后共享同一个Result（Result本身是ResultImpl的浅拷贝）。
+ * 可能修改数据的语句下发和完成时，涉及相同表的在途查询不再接受新的请求，
+ * 之后的相同查询重新下发，保证调用者能读到自己的写入。
+ *
+ * 连接串中指定protocol=x时，连接改用X Protocol（MySQLXConnector），
+ * 每个连接可以预先接受多条语句（数量由pipeline=N指定），这些语句在连接的
+ * 工作线程中排队，仍然一次只向服务端发送一条，其余行为不变。
+ * execSqlSync()始终使用经典协议，不受protocol影响。
+ *
+ * 设置了QueryCache后，只读语句先查缓存；命中时回调同样投递到IO线程中执行，
+ * 与未命中时一致，不会在execSql()返回之前被调用。
+ * 可能修改数据的语句执行完成后，按语句涉及的表使缓存失效，提取不到表名时（如CALL）
+ * 全部失效；SET、COMMIT等语句不影响缓存。
+ *
+ * @note 必须通过newMySQLPool()创建，连接的回调依赖shared_from_this()
+ */
+class DatabaseManager : public NonCopyable,
+                        public std::enable_shared_from_this<DatabaseManager>
+{
+  public:
+    /**
+     * @brief 创建并初始化一个MySQL连接池
+     * @param connInfo 连接串，格式同MySQLConnector，如"host=127.0.0.1 user=test"
+     * @param connNum 连接数量
+     * @param threadNum IO线程数量，连接按轮询方式分布在这些线程上
+     * @return 已开始建立连接的连接池
+     */
+    static std::shared_ptr<DatabaseManager> newMySQLPool(
+        const std::string &connInfo,
+        size_t connNum,
+        size_t threadNum = 1);
 
+    DatabaseManager(const std::string &connInfo,
+                    size_t connNum,
+                    size_t threadNum = 1);
+    ~DatabaseManager();
+
+    /**
+     * @brief 启动IO线程并建立所有连接
+     */
+    void init();
+
+    /**
+     * @brief 通过连接池执行SQL语句
+     *
+     * 参数含义与DbConnection::execSql相同。sql和parameters指向的内存需要
+     * 保持有效直到回调被调用。
+     */
+    void execSql(std::string_view &&sql,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback);
+
+    /**
+     * @brief 通过连接池执行SQL语句，参数由binder持有
+     *
+     * sql指向的内存需要保持有效直到回调被调用。
+     */
+    void execSql(std::string_view &&sql,
+                 SqlBinderPtr &&binder,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback);
+
+    /**
+     * @brief 以类型安全的方式执行SQL语句，用法同DbConnection::execSql
+     *
+     * 参数按值保存在一个绑定对象中，在等待队列中排队时也不需要调用者保持实参有效。
+     */
+    template <typename... Arguments>
+    void execSql(std::string_view sql,
+                 ResultCallback rcb,
+                 ExceptPtrCallback exceptCallback,
+                 Arguments &&...args)
+    {
+        execSql(std::move(sql),
+                makeSqlBinder(std::forward<Arguments>(args)...),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    /**
+     * @brief 同上，语句超过timeout秒未完成时以TimeoutError回调并中断服务端的执行
+     */
+    template <typename... Arguments>
+    void execSqlWithTimeout(double timeout,
+                            std::string_view sql,
+                            ResultCallback rcb,
+                            ExceptPtrCallback exceptCallback,
+                            Arguments &&...args)
+    {
+        auto binder = makeSqlBinder(std::forward<Arguments>(args)...);
+        binder->setTimeout(timeout);
+        execSql(std::move(sql),
+                std::move(binder),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    /**
+     * @brief 同上，SQL由CXK_SQL宏给出时在编译期检查占位符数量
+     */
+    template <size_t N, typename... Arguments>
+    void execSql(const SqlLiteral<N> &sql,
+                 ResultCallback rcb,
+                 ExceptPtrCallback exceptCallback,
+                 Arguments &&...args)
+    {
+        static_assert(N == sizeof...(Arguments),
+                      "The number of placeholders does not match the number "
+                      "of arguments");
+        execSql(std::string_view(sql.sql),
+                makeSqlBinder(std::forward<Arguments>(args)...),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    /**
+     * @brief 在当前线程中同步执行SQL语句，返回结果，出错时抛出对应异常
+     *
+     * 供不运行EventLoop的工作线程使用。每个调用线程持有一个自己的阻塞连接
+     * （保存在线程局部存储中，不计入connectionsNumber()），
+     * 执行过程不经过IO线程，也没有跨线程的唤醒。
+     * 在EventLoop线程中调用会阻塞事件循环甚至死锁，此时抛出UsageError。
+     * binder没有单独指定时，setTimeout()和setMaxResultBytes()的默认值同样生效。
+     */
+    Result execSqlSync(std::string_view sql, const SqlBinder &binder);
+
+    /**
+     * @brief 以类型安全的方式同步执行SQL语句，参数用法同变参execSql
+     */
+    template <typename... Arguments,
+              std::enable_if_t<!(std::is_base_of_v<SqlBinder,
+                                                   std::decay_t<Arguments>> ||
+                                 ...),
+                               int> = 0>
+    Result execSqlSync(std::string_view sql, Arguments &&...args)
+    {
+        BoundSqlBinder<SqlParamType<Arguments>...> binder(
+            std::forward<Arguments>(args)...);
+        return execSqlSync(sql, static_cast<const SqlBinder &>(binder));
+    }
+
+    /**
+     * @brief 从连接池中取出一个连接开启事务
+     *
+     * 没有空闲连接时排队等待。BEGIN执行成功后以事务对象回调，
+     * 事务结束前该连接不再执行其他SQL。
+     */
+    void newTransaction(
+        std::function<void(const TransactionPtr &)> &&callback,
+        ExceptPtrCallback &&exceptCallback = nullptr);
+
+#ifdef CXK_HAS_COROUTINE
+    /**
+     * @brief 协程版本的execSql，co_await的结果为Result，出错时抛出对应异常
+     *
+     * 协程在连接池的EventLoop线程中恢复。
+     */
+    template <typename... Arguments>
+    SqlAwaiter<DatabaseManager> execSqlCoro(std::string_view sql,
+                                            Arguments &&...args)
+    {
+        return SqlAwaiter<DatabaseManager>(
+            shared_from_this(),
+            sql,
+            makeSqlBinder(std::forward<Arguments>(args)...));
+    }
+
+    /**
+     * @brief 协程版本的newTransaction，co_await的结果为TransactionPtr
+     */
+    TransactionAwaiter<DatabaseManager> newTransactionCoro()
+    {
+        return TransactionAwaiter<DatabaseManager>(shared_from_this());
+    }
+#endif
+
+    /**
+     * @brief 创建连接的工厂，参数为连接所属的EventLoop和连接串
+     */
+    using ConnectionFactory =
+        std::function<DbConnectionPtr(EventLoop *, const std::string &)>;
+
+    /**
+     * @brief 替换创建连接的方式，默认按protocol创建MySQLConnector或MySQLXConnector
+     *
+     * 工厂只负责构造，连接池照常设置连接的回调并调用init()。
+     * 主要用于在测试中注入不访问数据库的连接。
+     * @note 应在init()之前设置
+     */
+    void setConnectionFactory(ConnectionFactory factory)
+    {
+        connectionFactory_ = std::move(factory);
+    }
+
+    /**
+     * @brief 开启或关闭相同只读查询的合并，默认关闭
+     *
+     * 含FOR UPDATE、@变量、LAST_INSERT_ID()等结果与连接相关的语句不参与合并和缓存，
+     * 规则见utils::isShareableQuery()。指定了SqlBinder::resultResource()的语句
+     * 同样单独执行，结果只放在调用者的内存资源中。
+     */
+    void setQueryCoalescing(bool enable)
+    {
+        coalescing_ = enable;
+    }
+
+    /**
+     * @brief 设置查询结果缓存，传入nullptr关闭缓存
+     * @note 应在开始执行SQL之前设置
+     */
+    void setQueryCache(std::shared_ptr<QueryCache> cache)
+    {
+        cache_ = std::move(cache);
+    }
+
+    const std::shared_ptr<QueryCache> &queryCache() const
+    {
+        return cache_;
+    }
+
+    /**
+     * @brief 设置默认的语句超时时间（秒），对没有单独指定超时的语句生效，
+     * 不大于0表示不限制
+     * @note 只对经典协议的连接生效，应在开始执行SQL之前设置
+     */
+    void setTimeout(double timeout)
+    {
+        timeout_ = timeout;
+    }
+
+    /**
+     * @brief 设置默认的单条语句结果内存上限（字节），对没有单独指定上限的
+     * 语句生效，0表示不限制
+     * @note 只对经典协议的连接生效，应在开始执行SQL之前设置
+     */
+    void setMaxResultBytes(size_t bytes)
+    {
+        maxResultBytes_ = bytes;
+    }
+
+    /**
+     * @brief 设置连接池内所有存活结果合计的内存上限（字节），0表示不限制
+     *
+     * 有上限时结果改为逐行读取，读取中的结果使合计超出上限时，
+     * 语句被中断并以ResultTooLarge回调。已经返回的结果析构后才归还额度。
+     * @note 只对经典协议的连接生效
+     */
+    void setResultMemoryLimit(size_t bytes)
+    {
+        resultBudget_->setLimit(bytes);
+    }
+
+    /**
+     * @brief 连接池的连接返回的、仍然存活的结果占用的字节数
+     */
+    size_t resultMemoryBytes() const
+    {
+        return resultBudget_->usedBytes();
+    }
+
+    /**
+     * @brief 当前在途（已下发、尚未返回）的合并查询数量
+     */
+    size_t inflightQueries() const;
+
+    /**
+     * @brief 当前已建立的连接数量
+     */
+    size_t connectionsNumber() const;
+
+    /**
+     * @brief 是否存在空闲连接
+     */
+    bool hasAvailableConnections() const;
+
+    /**
+     * @brief 断开所有连接
+     *
+     * 等待连接的newTransaction()和事务中尚未执行的语句以BrokenConnection回调。
+     */
+    void closeAll();
+
+  private:
+    friend class Transaction;
+    using Waiter = std::pair<ResultCallback, ExceptPtrCallback>;
+    /// 在途的合并查询，关闭后从flights_中摘下，已经挂上的请求仍由它回调
+    struct Flight
+    {
+        std::vector<std::string> tables;
+        std::vector<Waiter> waiters;
+    };
+    using TransactionWaiter =
+        std::pair<std::function<void(const TransactionPtr &)>,
+                  ExceptPtrCallback>;
+
+    DbConnectionPtr newConnection(EventLoop *loop);
+    void handleNewTask(const DbConnectionPtr &conn);
+    /// store在结果返回时调用一次（用于写入缓存），合并到在途查询上时由该查询调用
+    void runSql(std::string_view &&sql,
+                SqlBinderPtr &&binder,
+                ResultCallback &&rcb,
+                ExceptPtrCallback &&exceptCallback,
+                ResultCallback &&store = nullptr);
+    void refreshCacheEntry(const std::shared_ptr<QueryCache> &cache,
+                           const std::string &key,
+                           std::string_view sql,
+                           const SqlBinder &binder);
+    void dispatchSql(std::string_view &&sql,
+                     SqlBinderPtr &&binder,
+                     ResultCallback &&rcb,
+                     ExceptPtrCallback &&exceptCallback);
+    std::vector<Waiter> takeWaiters(const std::string &key,
+                                    const std::shared_ptr<Flight> &flight);
+    /// 涉及tables中的表的在途查询不再接受新的请求，tables为空时全部不再接受
+    void closeFlights(const std::vector<std::string> &tables);
+    /// 写入tables后使缓存失效并关闭相关的在途查询，在写入完成时调用
+    void finishWrite(const std::vector<std::string> &tables);
+    void startTransaction(const DbConnectionPtr &conn,
+                          std::function<void(const TransactionPtr &)> &&callback,
+                          ExceptPtrCallback &&exceptCallback);
+    void releaseTransactionConnection(const DbConnectionPtr &conn);
+
+    MySQLSyncConnector &threadConnection();
+    /// 语句没有单独指定时使用默认的超时和结果内存上限
+    void applyDefaults(SqlBinder &binder) const;
+
+    /// 单条、结果与连接无关、且没有指定结果内存资源的只读语句才会被合并或缓存
+    static bool isShareable(std::string_view sql, const SqlBinder &binder);
+    static void invalidateCache(QueryCache &cache,
+                                const std::vector<std::string> &tables);
+    static size_t parameterSize(int format, int length);
+    static std::string makeFlightKey(std::string_view sql,
+                                     const SqlBinder &binder);
+
+    std::string connInfo_;
+    bool xProtocol_{false};
+    size_t numberOfConnections_;
+    EventLoopThreadPool loops_;
+
+    mutable std::mutex connectionsMutex_;
+    std::unordered_set<DbConnectionPtr> connections_;
+    std::unordered_set<DbConnectionPtr> readyConnections_;
+    std::unordered_set<DbConnectionPtr> busyConnections_;
+    std::deque<std::shared_ptr<SqlCmd>> sqlCmdBuffer_;
+    /// 被事务占用的连接，空闲和断开通知转交给对应的事务
+    std::unordered_map<DbConnectionPtr, std::weak_ptr<Transaction>>
+        transConnections_;
+    std::deque<TransactionWaiter> transWaiters_;
+
+    ConnectionFactory connectionFactory_;
+    std::shared_ptr<QueryCache> cache_;
+    bool coalescing_{false};
+    double timeout_{0.0};
+    size_t maxResultBytes_{0};
+    /// 经典协议连接的结果共用的内存预算
+    ResultMemoryBudgetPtr resultBudget_{std::make_shared<ResultMemoryBudget>()};
+    /// 超时语句通过它中断，所有经典协议的连接共用一个控制连接
+    std::shared_ptr<MySQLQueryKiller> killer_;
+    mutable std::mutex flightsMutex_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
 };
 
+using DatabaseManagerPtr = std::shared_ptr<DatabaseManager>;
 
+}  // namespace cxk
 
-#endif //DATABASEMANAGER_H
+#endif  // DATABASEMANAGER_H
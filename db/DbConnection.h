@@ -19,6 +19,7 @@
 #include <event/EventLoop.h>
 #include <Result.h>
 #include <NonCopyable.h>
+#include <db/SqlBinder.h>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -56,6 +57,7 @@ struct SqlCmd
     std::vector<const char *> parameters_;
     std::vector<int> lengths_;
     std::vector<int> formats_;
+    SqlBinderPtr binder_;  ///< 非空时参数以binder_为准
     QueryCallback callback_;
     ExceptPtrCallback exceptionCallback_;
     std::string preparingStatement_;
@@ -76,6 +78,17 @@ struct SqlCmd
           exceptionCallback_(std::move(exceptCb))
     {
     }
+    SqlCmd(std::string_view &&sql,
+           SqlBinderPtr &&binder,
+           QueryCallback &&cb,
+           ExceptPtrCallback &&exceptCb)
+        : sql_(std::move(sql)),
+          parametersNumber_(binder->size()),
+          binder_(std::move(binder)),
+          callback_(std::move(cb)),
+          exceptionCallback_(std::move(exceptCb))
+    {
+    }
 };
 
 class DbConnection;
@@ -173,6 +186,56 @@ class DbConnection : public NonCopyable
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
 
+    /**
+     * @brief 执行SQL语句，参数由binder持有
+     *
+     * binder会保持到SQL拼接完成，sql指向的内存需要保持有效直到回调被调用。
+     */
+    virtual void execSql(std::string_view &&sql,
+                         SqlBinderPtr &&binder,
+                         ResultCallback &&rcb,
+                         ExceptPtrCallback &&exceptCallback) = 0;
+
+    /**
+     * @brief 以类型安全的方式执行SQL语句
+     *
+     * 参数类型由SqlParamTraits在编译期确定，参数按值保存，
+     * 调用返回后即可释放实参。例如：
+     * @code
+     * conn->execSql("select * from users where id=? and name=?",
+     *               rcb, ecb, 42, name);
+     * @endcode
+     */
+    template <typename... Arguments>
+    void execSql(std::string_view sql,
+                 ResultCallback rcb,
+                 ExceptPtrCallback exceptCallback,
+                 Arguments &&...args)
+    {
+        execSql(std::move(sql),
+                makeSqlBinder(std::forward<Arguments>(args)...),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    /**
+     * @brief 同上，SQL由CXK_SQL宏给出时在编译期检查占位符数量
+     */
+    template <size_t N, typename... Arguments>
+    void execSql(const SqlLiteral<N> &sql,
+                 ResultCallback rcb,
+                 ExceptPtrCallback exceptCallback,
+                 Arguments &&...args)
+    {
+        static_assert(N == sizeof...(Arguments),
+                      "The number of placeholders does not match the number "
+                      "of arguments");
+        execSql(std::string_view(sql.sql),
+                makeSqlBinder(std::forward<Arguments>(args)...),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
     /**
      * @brief 批量执行SQL命令
      *
@@ -205,6 +268,12 @@ class DbConnection : public NonCopyable
         return isWorking_;
     }
 
+    /**
+     * @brief 解析"key=value key2='value 2'"形式的连接串
+     */
+    static std::map<std::string, std::string> parseConnString(
+        const std::string &);
+
   protected:
     QueryCallback callback_;
     EventLoop *loop_;
@@ -215,9 +284,6 @@ class DbConnection : public NonCopyable
     std::function<void(const std::exception_ptr &)> exceptionCallback_;
     bool isWorking_{false};
 
-    static std::map<std::string, std::string> parseConnString(
-        const std::string &);
-
 };
 
 }  // namespace cxk
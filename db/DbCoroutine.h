@@ -0,0 +1,372 @@
+//
+// Created by cxk_zjq on 25-6-24.
+//
+
+#ifndef DBCOROUTINE_H
+#define DBCOROUTINE_H
+
+/**
+ * 协程接口需要C++20，工程以C++17编译时本文件不提供任何内容，
+ * 以C++20及以上标准编译时定义CXK_HAS_COROUTINE。
+ */
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define CXK_HAS_COROUTINE 1
+#endif
+
+#ifdef CXK_HAS_COROUTINE
+
+#include <db/DbConnection.h>
+#include <db/SqlBinder.h>
+#include <absl/log/absl_log.h>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace cxk
+{
+class Transaction;
+
+/**
+ * @brief 把一次回调式的异步操作包装为可co_await的对象
+ *
+ * 派生类在await_suspend中调用suspendWith()发起操作，并在回调中调用
+ * setValue()/setException()。回调在哪个线程触发，协程就在哪个线程恢复，
+ * 中间不再经过queueInLoop。连接池的查询总是在其EventLoop线程中回调，
+ * 缓存命中也一样；回调在发起操作的过程中同步触发时（如事务已经结束），
+ * 协程在发起操作的调用中直接恢复。
+ */
+template <typename T>
+class CallbackAwaiter
+{
+  public:
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    T await_resume()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+        return std::move(*value_);
+    }
+
+  protected:
+    /**
+     * @note 回调可能在start()返回之前就在其他线程中恢复并结束协程，
+     * start()需要把用到的成员先拷贝到局部变量，发起操作之后不能再访问本对象
+     */
+    template <typename Start>
+    void suspendWith(std::coroutine_handle<> handle, Start &&start)
+    {
+        handle_ = handle;
+        start();
+    }
+
+    void setValue(T value)
+    {
+        value_.emplace(std::move(value));
+        complete();
+    }
+
+    void setException(const std::exception_ptr &e)
+    {
+        exception_ = e;
+        complete();
+    }
+
+  private:
+    void complete()
+    {
+        handle_.resume();
+    }
+
+    std::coroutine_handle<> handle_;
+    std::optional<T> value_;
+    std::exception_ptr exception_;
+};
+
+/**
+ * @brief execSqlCoro()返回的等待对象，Executor为DatabaseManager或Transaction
+ * @note sql需要在co_await完成前保持有效，对字面量和调用表达式中的临时对象总是成立
+ */
+template <typename Executor>
+class SqlAwaiter : public CallbackAwaiter<Result>
+{
+  public:
+    SqlAwaiter(std::shared_ptr<Executor> executor,
+               std::string_view sql,
+               SqlBinderPtr binder)
+        : executor_(std::move(executor)), sql_(sql), binder_(std::move(binder))
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        suspendWith(handle, [this]() {
+            auto executor = executor_;
+            auto sql = sql_;
+            auto binder = std::move(binder_);
+            executor->execSql(
+                std::move(sql),
+                std::move(binder),
+                [this](const Result &r) { setValue(r); },
+                [this](const std::exception_ptr &e) { setException(e); });
+        });
+    }
+
+  private:
+    std::shared_ptr<Executor> executor_;
+    std::string_view sql_;
+    SqlBinderPtr binder_;
+};
+
+/**
+ * @brief newTransactionCoro()返回的等待对象
+ */
+template <typename Pool>
+class TransactionAwaiter
+    : public CallbackAwaiter<std::shared_ptr<Transaction>>
+{
+  public:
+    explicit TransactionAwaiter(std::shared_ptr<Pool> pool)
+        : pool_(std::move(pool))
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        suspendWith(handle, [this]() {
+            auto pool = pool_;
+            pool->newTransaction(
+                [this](const std::shared_ptr<Transaction> &trans) {
+                    setValue(trans);
+                },
+                [this](const std::exception_ptr &e) { setException(e); });
+        });
+    }
+
+  private:
+    std::shared_ptr<Pool> pool_;
+};
+
+/**
+ * @brief commitCoro()返回的等待对象
+ */
+template <typename Trans>
+class CommitAwaiter : public CallbackAwaiter<Result>
+{
+  public:
+    explicit CommitAwaiter(std::shared_ptr<Trans> trans)
+        : trans_(std::move(trans))
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        suspendWith(handle, [this]() {
+            auto trans = trans_;
+            trans->commit(
+                [this](const Result &r) { setValue(r); },
+                [this](const std::exception_ptr &e) { setException(e); });
+        });
+    }
+
+  private:
+    std::shared_ptr<Trans> trans_;
+};
+
+namespace detail
+{
+struct TaskFinalAwaiter
+{
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept
+    {
+        auto continuation = handle.promise().continuation_;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+};
+
+struct TaskPromiseBase
+{
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    TaskFinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        exception_ = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase
+{
+    template <typename U>
+    void return_value(U &&value)
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+        return std::move(*value_);
+    }
+
+    std::optional<T> value_;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    void return_void() noexcept
+    {
+    }
+
+    void result()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+};
+}  // namespace detail
+
+/**
+ * @brief 惰性执行的协程，被co_await时才开始运行，结束后恢复等待者
+ */
+template <typename T = void>
+class [[nodiscard]] Task
+{
+  public:
+    struct promise_type : detail::TaskPromise<T>
+    {
+        Task get_return_object() noexcept
+        {
+            return Task(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {}))
+    {
+    }
+
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !handle_ || handle_.done();
+    }
+
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> continuation) noexcept
+    {
+        handle_.promise().continuation_ = continuation;
+        return handle_;
+    }
+
+    T await_resume()
+    {
+        return handle_.promise().result();
+    }
+
+  private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * @brief 立即开始执行、不需要等待的协程，用作回调世界与协程世界的入口
+ *
+ * 协程内未捕获的异常只记录日志。
+ */
+struct AsyncTask
+{
+    struct promise_type
+    {
+        AsyncTask get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            try
+            {
+                std::rethrow_exception(std::current_exception());
+            }
+            catch (const std::exception &e)
+            {
+                ABSL_LOG(ERROR) << "Unhandled exception in AsyncTask: "
+                                << e.what();
+            }
+            catch (...)
+            {
+                ABSL_LOG(ERROR) << "Unhandled exception in AsyncTask";
+            }
+        }
+    };
+};
+
+}  // namespace cxk
+
+#endif  // CXK_HAS_COROUTINE
+
+#endif  // DBCOROUTINE_H
@@ -8,6 +8,8 @@
 #ifndef DBTYPES_H
 #define DBTYPES_H
 
+#include <cstdint>
+
 namespace cxk
 {
 namespace type
@@ -23,6 +25,25 @@ namespace type
         DrogonDefaultValue,
     };
 }
+
+/**
+ * @brief 与驱动无关的列类型分类，序列化和导出结果时据此决定值的表示方式
+ */
+enum class ColumnKind : uint8_t
+{
+    Unknown,          ///< 驱动没有提供类型信息，按字符串处理
+    Integer,
+    UnsignedInteger,
+    Real,             ///< FLOAT、DOUBLE
+    Decimal,
+    String,
+    Binary,           ///< BLOB、BINARY等二进制串
+    Bit,
+    Date,
+    Time,
+    DateTime,         ///< DATETIME、TIMESTAMP
+    Json,
+};
 }
 
 #endif //DBTYPES_H
@@ -0,0 +1,422 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#include "Decimal.h"
+#include "Exception.h"
+#include <cstring>
+#include <ostream>
+
+using namespace cxk;
+
+namespace
+{
+using Int128 = Decimal::Int128;
+using UInt128 = unsigned __int128;
+
+struct Pow10Table
+{
+    UInt128 values[Decimal::kMaxDigits + 1];
+
+    constexpr Pow10Table() : values()
+    {
+        values[0] = 1;
+        for (unsigned i = 1; i <= Decimal::kMaxDigits; ++i)
+            values[i] = values[i - 1] * 10;
+    }
+};
+
+constexpr Pow10Table kPow10;
+constexpr Int128 kMinInt128 = static_cast<Int128>(UInt128(1) << 127);
+
+UInt128 magnitude(Int128 value) noexcept
+{
+    return value < 0 ? UInt128(0) - UInt128(value) : UInt128(value);
+}
+
+// 按小端读取p开始的最多8个字节，超出end的部分补0（0不是数字，扫描会在此停下）。
+// 文本不短于8字节时从末尾对齐读取再移位，避免按变长拷贝后整体读取引起的转发停顿
+uint64_t load8(const char *p, const char *begin, const char *end) noexcept
+{
+    uint64_t chunk = 0;
+    if (end - p >= 8)
+    {
+        memcpy(&chunk, p, 8);
+    }
+    else if (end - begin >= 8)
+    {
+        memcpy(&chunk, end - 8, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        chunk = __builtin_bswap64(chunk);
+#endif
+        // p == end时移位量为64，单独处理
+        return p == end ? 0 : chunk >> (8 * (8 - (end - p)));
+    }
+    else
+    {
+        for (auto q = end; q != p;)
+            chunk = (chunk << 8) | static_cast<unsigned char>(*--q);
+        return chunk;
+    }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+    return chunk;
+}
+
+/**
+ * 从p开始读取连续的数字累加到acc，p移动到第一个非数字字符。
+ * 每次读取8个字节：与'0'异或后数字字节为0..9，据此得到非数字字节的位图，
+ * 其最低位给出本次的数字个数；数字右对齐后按 2 -> 4 -> 8 位逐级合并。
+ * 累加结果达到10^kMaxDigits时返回false，前导0不计入位数。
+ */
+inline bool scanDigits(const char *&p,
+                       const char *begin,
+                       const char *end,
+                       UInt128 &acc) noexcept
+{
+    for (;;)
+    {
+        uint64_t x = load8(p, begin, end) ^ 0x3030303030303030ULL;
+        uint64_t nonDigit =
+            (((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7676767676767676ULL) | x) &
+            0x8080808080808080ULL;
+        unsigned n = nonDigit ? __builtin_ctzll(nonDigit) >> 3 : 8;
+        if (n == 0)
+            return true;
+        // acc < 10^(38 - n)时acc * 10^n + v一定小于10^38，反之一定不小于
+        if (acc >= kPow10.values[Decimal::kMaxDigits - n])
+            return false;
+        // 左移丢弃数字之后的字节，同时在低位（高位数字处）补0
+        uint64_t v = x << (8 * (8 - n));
+        v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+        v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+        v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+        acc = acc * static_cast<uint64_t>(kPow10.values[n]) + v;
+        p += n;
+        if (n < 8)
+            return true;
+    }
+}
+
+bool mulPow10(Int128 value, unsigned n, Int128 &out) noexcept
+{
+    return !__builtin_mul_overflow(value, Int128(kPow10.values[n]), &out);
+}
+
+Int128 scaleUp(Int128 value, unsigned n)
+{
+    Int128 result;
+    if (!mulPow10(value, n, result))
+        throw RangeError("Decimal overflow");
+    return result;
+}
+
+// 四舍五入（远离0）的整数除法，调用者保证divisor不为0且商不溢出
+Int128 divideRounded(Int128 dividend, Int128 divisor) noexcept
+{
+    Int128 quotient = dividend / divisor;
+    UInt128 remainder = magnitude(dividend % divisor);
+    if (remainder >= magnitude(divisor) - remainder)
+        quotient += ((dividend < 0) == (divisor < 0)) ? 1 : -1;
+    return quotient;
+}
+
+// x * y的256位乘积，高低各128位
+void multiply256(UInt128 x, UInt128 y, UInt128 &high, UInt128 &low) noexcept
+{
+    UInt128 x0 = static_cast<uint64_t>(x), x1 = x >> 64;
+    UInt128 y0 = static_cast<uint64_t>(y), y1 = y >> 64;
+    UInt128 p00 = x0 * y0, p01 = x0 * y1, p10 = x1 * y0, p11 = x1 * y1;
+    UInt128 middle = (p00 >> 64) + static_cast<uint64_t>(p01) +
+                     static_cast<uint64_t>(p10);
+    low = (middle << 64) | static_cast<uint64_t>(p00);
+    high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+}
+
+// (high * 2^128 + low) / divisor，要求high < divisor <= 2^127，商一定小于2^128；
+// 余数写回high
+UInt128 divide256(UInt128 &high, UInt128 low, UInt128 divisor) noexcept
+{
+    UInt128 quotient = 0;
+    for (int i = 127; i >= 0; --i)
+    {
+        // high < divisor <= 2^127，左移一位不会溢出
+        high = (high << 1) | ((low >> i) & 1);
+        quotient <<= 1;
+        if (high >= divisor)
+        {
+            high -= divisor;
+            quotient |= 1;
+        }
+    }
+    return quotient;
+}
+
+/**
+ * a * 10^exponent / b（exponent < 0时为a / (b * 10^-exponent)），结果四舍五入，
+ * 用于放大后超出128位的情况。exponent >= 0时先求a / b，再把余数分段乘以
+ * 不超过10^38并做长除法：余数小于b，每段的中间值不超过256位。
+ * exponent < 0时先除以b再除以10^k，总余数r2 * b + r1（r1 < b）是否达到
+ * b * 10^k的一半只取决于r2是否达到10^k的一半。商超出128位时返回false
+ */
+bool divideWide(UInt128 a, int exponent, UInt128 b, UInt128 &out) noexcept
+{
+    UInt128 quotient = a / b;
+    UInt128 remainder = a % b;
+    UInt128 roundDivisor = b;
+    if (exponent >= 0)
+    {
+        for (auto e = static_cast<unsigned>(exponent); e > 0;)
+        {
+            unsigned n = e < Decimal::kMaxDigits ? e : Decimal::kMaxDigits;
+            UInt128 high, low;
+            multiply256(remainder, kPow10.values[n], high, low);
+            UInt128 digits = divide256(high, low, b);
+            remainder = high;
+            if (quotient > (~UInt128(0) - digits) / kPow10.values[n])
+                return false;
+            quotient = quotient * kPow10.values[n] + digits;
+            e -= n;
+        }
+    }
+    else
+    {
+        roundDivisor = kPow10.values[-exponent];
+        remainder = quotient % roundDivisor;
+        quotient /= roundDivisor;
+    }
+    if (remainder >= roundDivisor - remainder)
+    {
+        if (quotient == ~UInt128(0))
+            return false;
+        ++quotient;
+    }
+    out = quotient;
+    return true;
+}
+
+// 把magnitude的十进制数字逆序写入rev，返回位数
+unsigned reverseDigits(UInt128 value, char *rev) noexcept
+{
+    constexpr uint64_t k1e19 = 10000000000000000000ULL;
+    unsigned n = 0;
+    while (value >= k1e19)
+    {
+        auto low = static_cast<uint64_t>(value % k1e19);
+        value /= k1e19;
+        for (int i = 0; i < 19; ++i, low /= 10)
+            rev[n++] = static_cast<char>('0' + low % 10);
+    }
+    auto rest = static_cast<uint64_t>(value);
+    do
+    {
+        rev[n++] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+    } while (rest != 0);
+    return n;
+}
+}  // namespace
+
+Decimal Decimal::fromUnscaled(Int128 unscaled, unsigned scale)
+{
+    if (scale > kMaxDigits)
+        throw ArgumentError("Decimal scale " + std::to_string(scale) +
+                            " exceeds " + std::to_string(kMaxDigits));
+    Decimal result;
+    result.value_ = unscaled;
+    result.scale_ = static_cast<uint8_t>(scale);
+    return result;
+}
+
+bool Decimal::parse(std::string_view text, Decimal &out) noexcept
+{
+    const char *p = text.data();
+    const char *end = p + text.size();
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    UInt128 acc = 0;
+    const char *integerBegin = p;
+    if (!scanDigits(p, text.data(), end, acc))
+        return false;
+    bool hasInteger = p != integerBegin;
+    unsigned scale = 0;
+    if (p != end && *p == '.')
+    {
+        const char *fractionBegin = ++p;
+        if (!scanDigits(p, text.data(), end, acc))
+            return false;
+        scale = static_cast<unsigned>(p - fractionBegin);
+        if (scale == 0 || scale > kMaxDigits)
+            return false;
+    }
+    else if (!hasInteger)
+    {
+        return false;
+    }
+    if (p != end)
+        return false;
+    // 不超过38位的数小于2^127，取负不会溢出
+    out.value_ =
+        negative ? -static_cast<Int128>(acc) : static_cast<Int128>(acc);
+    out.scale_ = static_cast<uint8_t>(scale);
+    return true;
+}
+
+Decimal Decimal::fromString(std::string_view text)
+{
+    Decimal result;
+    if (!parse(text, result))
+        throw ConversionError("Cannot convert \"" + std::string(text) +
+                              "\" to a Decimal");
+    return result;
+}
+
+Decimal Decimal::rescale(unsigned scale) const
+{
+    if (scale > kMaxDigits)
+        throw ArgumentError("Decimal scale " + std::to_string(scale) +
+                            " exceeds " + std::to_string(kMaxDigits));
+    Decimal result;
+    result.scale_ = static_cast<uint8_t>(scale);
+    if (scale >= scale_)
+        result.value_ = scaleUp(value_, scale - scale_);
+    else
+        result.value_ =
+            divideRounded(value_, Int128(kPow10.values[scale_ - scale]));
+    return result;
+}
+
+Decimal Decimal::divide(const Decimal &divisor, unsigned scale) const
+{
+    if (divisor.value_ == 0)
+        throw ArgumentError("Decimal division by zero");
+    if (scale > kMaxDigits)
+        throw ArgumentError("Decimal scale " + std::to_string(scale) +
+                            " exceeds " + std::to_string(kMaxDigits));
+    // (a / 10^sa) / (b / 10^sb) * 10^scale = a * 10^(scale + sb - sa) / b
+    int exponent = static_cast<int>(scale) + divisor.scale_ - scale_;
+    Decimal result;
+    result.scale_ = static_cast<uint8_t>(scale);
+    Int128 dividend = value_;
+    Int128 quotientDivisor = divisor.value_;
+    // 放大后仍在128位以内时直接相除
+    if (exponent >= 0 ? exponent <= static_cast<int>(kMaxDigits) &&
+                            mulPow10(value_,
+                                     static_cast<unsigned>(exponent),
+                                     dividend)
+                      : mulPow10(divisor.value_,
+                                 static_cast<unsigned>(-exponent),
+                                 quotientDivisor))
+    {
+        if (quotientDivisor == -1 && dividend == kMinInt128)
+            throw RangeError("Decimal overflow");
+        result.value_ = divideRounded(dividend, quotientDivisor);
+        return result;
+    }
+    UInt128 quotient;
+    bool negative = (value_ < 0) != (divisor.value_ < 0);
+    if (!divideWide(magnitude(value_),
+                    exponent,
+                    magnitude(divisor.value_),
+                    quotient) ||
+        quotient > (UInt128(1) << 127) - (negative ? 0 : 1))
+        throw RangeError("Decimal overflow");
+    result.value_ = static_cast<Int128>(negative ? UInt128(0) - quotient
+                                                 : quotient);
+    return result;
+}
+
+size_t Decimal::toChars(char *buf) const noexcept
+{
+    char rev[kMaxDigits + 2];
+    unsigned n = reverseDigits(magnitude(value_), rev);
+    // 整数部分至少保留一个0
+    while (n <= scale_)
+        rev[n++] = '0';
+    char *p = buf;
+    if (value_ < 0)
+        *p++ = '-';
+    for (unsigned i = n; i > scale_; --i)
+        *p++ = rev[i - 1];
+    if (scale_ > 0)
+    {
+        *p++ = '.';
+        for (unsigned i = scale_; i > 0; --i)
+            *p++ = rev[i - 1];
+    }
+    return static_cast<size_t>(p - buf);
+}
+
+std::string Decimal::toString() const
+{
+    char buf[kMaxStringLength];
+    return std::string(buf, toChars(buf));
+}
+
+double Decimal::toDouble() const noexcept
+{
+    return static_cast<double>(value_) /
+           static_cast<double>(kPow10.values[scale_]);
+}
+
+int Decimal::compare(const Decimal &other) const noexcept
+{
+    Int128 lhs = value_;
+    Int128 rhs = other.value_;
+    // 放大scale较小的一方，溢出说明它的绝对值更大，结果由其符号决定
+    if (scale_ < other.scale_ && !mulPow10(lhs, other.scale_ - scale_, lhs))
+        return sign();
+    if (other.scale_ < scale_ && !mulPow10(rhs, scale_ - other.scale_, rhs))
+        return -other.sign();
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+Decimal &Decimal::operator+=(const Decimal &other)
+{
+    auto scale = scale_ > other.scale_ ? scale_ : other.scale_;
+    Int128 lhs = scaleUp(value_, scale - scale_);
+    Int128 rhs = scaleUp(other.value_, scale - other.scale_);
+    if (__builtin_add_overflow(lhs, rhs, &value_))
+        throw RangeError("Decimal overflow");
+    scale_ = scale;
+    return *this;
+}
+
+Decimal &Decimal::operator-=(const Decimal &other)
+{
+    auto scale = scale_ > other.scale_ ? scale_ : other.scale_;
+    Int128 lhs = scaleUp(value_, scale - scale_);
+    Int128 rhs = scaleUp(other.value_, scale - other.scale_);
+    if (__builtin_sub_overflow(lhs, rhs, &value_))
+        throw RangeError("Decimal overflow");
+    scale_ = scale;
+    return *this;
+}
+
+Decimal &Decimal::operator*=(const Decimal &other)
+{
+    Int128 product;
+    if (__builtin_mul_overflow(value_, other.value_, &product))
+        throw RangeError("Decimal overflow");
+    unsigned scale = scale_ + other.scale_;
+    if (scale > kMaxDigits)
+    {
+        product = divideRounded(product,
+                                Int128(kPow10.values[scale - kMaxDigits]));
+        scale = kMaxDigits;
+    }
+    value_ = product;
+    scale_ = static_cast<uint8_t>(scale);
+    return *this;
+}
+
+std::ostream &cxk::operator<<(std::ostream &os, const Decimal &value)
+{
+    char buf[Decimal::kMaxStringLength];
+    return os.write(buf, static_cast<std::streamsize>(value.toChars(buf)));
+}
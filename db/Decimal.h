@@ -0,0 +1,178 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cxk
+{
+/**
+ * @brief 128位定点十进制数，对应MySQL的DECIMAL
+ *
+ * 值为unscaled() / 10^scale()，最多kMaxDigits位有效数字，scale不超过kMaxDigits。
+ * 比较按数值进行，1.5与1.50相等。
+ *
+ * 加减的结果取两者中较大的scale，乘法的scale为两者之和（超过kMaxDigits时舍入），
+ * 除法和rescale()由调用者指定结果的scale。舍入都按四舍五入（远离0），与MySQL的
+ * ROUND()一致。结果超出128位时抛出RangeError，除数为0时抛出ArgumentError。
+ */
+class Decimal
+{
+  public:
+    using Int128 = __int128;
+
+    /// 128位有符号整数能完整表示的十进制位数
+    static constexpr unsigned kMaxDigits = 38;
+
+    constexpr Decimal() noexcept = default;
+
+    /**
+     * @brief 整数值，scale为0
+     * @note 不提供浮点数的构造，浮点数无法精确表示十进制小数
+     */
+    template <typename T,
+              typename = std::enable_if_t<std::is_integral_v<T> &&
+                                          !std::is_same_v<T, bool>>>
+    constexpr Decimal(T value) noexcept : value_(value)
+    {
+    }
+
+    /**
+     * @brief 由未缩放的整数和scale构造，值为unscaled / 10^scale
+     * @throw ArgumentError scale超过kMaxDigits
+     */
+    static Decimal fromUnscaled(Int128 unscaled, unsigned scale);
+
+    /**
+     * @brief 解析[+-]digits[.digits]格式的文本，不分配内存、与locale无关
+     *
+     * 每次按8个字节判断和合并数字，只在数字段结束处分支。
+     * @return 格式不合法、有效数字或小数位数超过kMaxDigits位时返回false，
+     *         out不变
+     */
+    static bool parse(std::string_view text, Decimal &out) noexcept;
+
+    /**
+     * @throw ConversionError 格式不合法或超出范围
+     */
+    static Decimal fromString(std::string_view text);
+
+    Int128 unscaled() const noexcept
+    {
+        return value_;
+    }
+
+    unsigned scale() const noexcept
+    {
+        return scale_;
+    }
+
+    int sign() const noexcept
+    {
+        return (value_ > 0) - (value_ < 0);
+    }
+
+    /**
+     * @brief 转换为指定scale，位数减少时四舍五入
+     */
+    Decimal rescale(unsigned scale) const;
+
+    /**
+     * @brief 计算*this / divisor，结果保留scale位小数并四舍五入
+     *
+     * 放大后的被除数或除数超出128位时改用长除法，只有商本身超出范围才抛出RangeError
+     */
+    Decimal divide(const Decimal &divisor, unsigned scale) const;
+
+    /**
+     * @brief 按scale输出，不使用科学计数法，如"-0.050"
+     */
+    std::string toString() const;
+
+    /**
+     * @brief 写入buf并返回长度，buf至少需要kMaxStringLength字节
+     */
+    size_t toChars(char *buf) const noexcept;
+
+    static constexpr size_t kMaxStringLength = kMaxDigits + 3;
+
+    double toDouble() const noexcept;
+
+    /**
+     * @brief 比较数值大小，返回负数、0或正数
+     */
+    int compare(const Decimal &other) const noexcept;
+
+    Decimal operator-() const noexcept
+    {
+        Decimal result(*this);
+        result.value_ = -value_;
+        return result;
+    }
+
+    Decimal &operator+=(const Decimal &other);
+    Decimal &operator-=(const Decimal &other);
+    Decimal &operator*=(const Decimal &other);
+
+    friend Decimal operator+(Decimal lhs, const Decimal &rhs)
+    {
+        return lhs += rhs;
+    }
+
+    friend Decimal operator-(Decimal lhs, const Decimal &rhs)
+    {
+        return lhs -= rhs;
+    }
+
+    friend Decimal operator*(Decimal lhs, const Decimal &rhs)
+    {
+        return lhs *= rhs;
+    }
+
+    friend bool operator==(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    friend bool operator!=(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) != 0;
+    }
+
+    friend bool operator<(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    friend bool operator<=(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) <= 0;
+    }
+
+    friend bool operator>(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) > 0;
+    }
+
+    friend bool operator>=(const Decimal &lhs, const Decimal &rhs) noexcept
+    {
+        return lhs.compare(rhs) >= 0;
+    }
+
+  private:
+    Int128 value_{0};
+    uint8_t scale_{0};
+};
+
+std::ostream &operator<<(std::ostream &os, const Decimal &value);
+
+}  // namespace cxk
+
+#endif  // DECIMAL_H
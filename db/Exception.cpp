@@ -100,6 +100,10 @@ TimeoutError::TimeoutError(const std::string &whatarg) : logic_error(whatarg)
 {
 }
 
+ResultTooLarge::ResultTooLarge(const std::string &whatarg) : Failure(whatarg)
+{
+}
+
 UsageError::UsageError(const std::string &whatarg) : logic_error(whatarg)
 {
 }
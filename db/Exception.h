@@ -208,6 +208,14 @@ class TimeoutError : public DrogonDbException, public std::logic_error
     explicit TimeoutError(const std::string &);
 };
 
+/// The result of a statement exceeded its memory budget (the per-statement
+/// limit or the limit shared by the pool), the statement has been aborted.
+class ResultTooLarge : public Failure
+{
+  public:
+    explicit ResultTooLarge(const std::string &);
+};
+
 /// Error in usage of drogon orm library, similar to std::logic_error
 class UsageError : public DrogonDbException, public std::logic_error
 {
@@ -77,11 +77,63 @@ std::vector<char> Field::as<std::vector<char>>() const
     }
 }
 
+namespace
+{
+// MySQL的零值日期"0000-00-00"、"0000-00-00 00:00:00[.000000]"
+bool isZeroDate(std::string_view text)
+{
+    constexpr std::string_view zero = "0000-00-00";
+    if (text.substr(0, zero.size()) != zero)
+        return false;
+    return text.find_first_not_of(" :.0", zero.size()) == std::string_view::npos;
+}
+}  // namespace
+
+template <>
+DateTime Field::as<DateTime>() const
+{
+    DateTime date;
+    if (isNull() || isZeroDate(view()))
+        return date;
+    if (!DateTime::parseDbString(view(), date))
+        throw ConversionError(std::string("Cannot convert the value \"") +
+                              std::string(view()) + "\" of column " + name() +
+                              " to a DateTime");
+    return date;
+}
+
+template <>
+Decimal Field::as<Decimal>() const
+{
+    Decimal value;
+    if (isNull())
+        return value;
+    if (!Decimal::parse(view(), value))
+        throw ConversionError(std::string("Cannot convert the value \"") +
+                              std::string(view()) + "\" of column " + name() +
+                              " to a Decimal");
+    return value;
+}
+
 const char *Field::c_str() const
 {
     return as<const char *>();
 }
 
+void Field::throwConversionError() const
+{
+    throw ConversionError(std::string("Cannot convert the value \"") +
+                          std::string(view()) + "\" of column " + name() +
+                          " to a number");
+}
+
+void Field::throwElementConversionError(std::string_view text) const
+{
+    throw ConversionError(std::string("Cannot convert the array element \"") +
+                          std::string(text) + "\" of column " + name() +
+                          " to a number");
+}
+
 // template <>
 // std::vector<short> Field::as<std::vector<short>>() const
 // {
@@ -8,12 +8,18 @@
 
 #include <string_view>
 #include "ArrayParser.h"
+#include "Decimal.h"
+#include "Exception.h"
+#include "NumberParser.h"
 #include "Result.h"    // 假设Result和Row在当前命名空间或已正确引入
 #include "Row.h"
+#include "time/DateTime.h"
 #include <spdlog/spdlog.h>    // 引入spdlog头文件
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 #ifdef __linux__
 #include <arpa/inet.h>
@@ -59,8 +65,24 @@ public:
         return result_.getLength(row_, column_);
     }
 
+    /**
+     * @brief 字段的原始字节，不拷贝
+     *
+     * 二进制列（BLOB、BINARY等）的值就是字段内容本身。返回的视图指向结果集的内存，
+     * 只能在Result存活期间使用；NULL字段返回空视图。
+     */
+    std::string_view asBytes() const
+    {
+        if (isNull())
+            return std::string_view();
+        return view();
+    }
+
     /**
      * @brief 将字段值转换为指定类型T的值
+     *
+     * 整数和浮点数用std::from_chars解析，整个字段都必须是合法的数值，
+     * 否则（包括超出T的范围）抛出ConversionError。其他类型通过operator>>读取。
      * @tparam T 目标类型
      * @return 转换后的类型值，若值为NULL则返回默认构造值
      */
@@ -69,21 +91,59 @@ public:
     {
         if (isNull())
             return T();
-        auto data_ = result_.getValue(row_, column_);
-        T value = T();
-        if (data_)
+        if constexpr (detail::isNumericField<T>)
+        {
+            T value;
+            if (!detail::parseNumber(view(), value))
+                throwConversionError();
+            return value;
+        }
+        else
+        {
+            auto data_ = result_.getValue(row_, column_);
+            T value = T();
+            if (data_)
+            {
+                try
+                {
+                    std::stringstream ss(data_);
+                    ss >> value;
+                }
+                catch (...)
+                {
+                    spdlog::debug("类型转换错误");    // 使用spdlog输出调试日志
+                }
+            }
+            return value;
+        }
+    }
+
+    /**
+     * @brief 不抛出异常的as()，字段为NULL或无法转换时返回std::nullopt
+     */
+    template <typename T>
+    std::optional<T> tryAs() const noexcept
+    {
+        if (isNull())
+            return std::nullopt;
+        if constexpr (detail::isNumericField<T>)
+        {
+            T value;
+            if (!detail::parseNumber(view(), value))
+                return std::nullopt;
+            return value;
+        }
+        else
         {
             try
             {
-                std::stringstream ss(data_);
-                ss >> value;
+                return as<T>();
             }
             catch (...)
             {
-                spdlog::debug("类型转换错误");    // 使用spdlog输出调试日志
+                return std::nullopt;
             }
         }
-        return value;
     }
 
     /**
@@ -94,37 +154,45 @@ public:
      */
     ArrayParser getArrayParser() const
     {
-        return ArrayParser(result_.getValue(row_, column_));
+        return ArrayParser(result_.getValue(row_, column_),
+                           result_.getLength(row_, column_));
     }
 
     /**
-     * @brief 将字段值解析为指定类型的数组（智能指针版本）
+     * @brief 将字段值解析为指定类型的数组，嵌套的数组按顺序展开
+     *
+     * 元素直接从字段文本中解析，只有带转义的元素需要一次拷贝。
+     * 数值元素用std::from_chars解析，无法转换时抛出ConversionError。
      * @tparam T 数组元素类型
-     * @return 包含解析结果的shared_ptr数组
-     *          若为NULL值则对应元素为nullptr
+     * @return 解析结果，NULL元素为std::nullopt
      */
     template <typename T>
-    std::vector<std::shared_ptr<T>> asArray() const
+    std::vector<std::optional<T>> asArray() const
     {
-        std::vector<std::shared_ptr<T>> ret;
+        std::vector<std::optional<T>> ret;
         auto arrParser = getArrayParser();
+        std::string unescaped;
         while (1)
         {
-            auto arrVal = arrParser.getNext();
-            if (arrVal.first == ArrayParser::juncture::done)
+            auto token = arrParser.nextToken();
+            if (token.type == ArrayParser::juncture::done)
             {
                 break;
             }
-            if (arrVal.first == ArrayParser::juncture::string_value)
+            if (token.type == ArrayParser::juncture::string_value)
             {
-                T val;
-                std::stringstream ss(std::move(arrVal.second));
-                ss >> val;
-                ret.push_back(std::make_shared<T>(val));    // 使用make_shared优化
+                auto text = token.text;
+                if (token.escaped)
+                {
+                    unescaped.clear();
+                    ArrayParser::unescape(token, unescaped);
+                    text = unescaped;
+                }
+                ret.emplace_back(arrayElement<T>(text));
             }
-            else if (arrVal.first == ArrayParser::juncture::null_value)
+            else if (token.type == ArrayParser::juncture::null_value)
             {
-                ret.push_back(nullptr);
+                ret.emplace_back(std::nullopt);
             }
         }
         return ret;
@@ -143,6 +211,42 @@ protected:
     Field(const Row &row, Row::SizeType columnNum) noexcept;
 
 private:
+    std::string_view view() const
+    {
+        return std::string_view(result_.getValue(row_, column_),
+                                result_.getLength(row_, column_));
+    }
+
+    [[noreturn]] void throwConversionError() const;
+    [[noreturn]] void throwElementConversionError(std::string_view text) const;
+
+    template <typename T>
+    T arrayElement(std::string_view text) const
+    {
+        if constexpr (detail::isNumericField<T>)
+        {
+            T value;
+            if (!detail::parseNumber(text, value))
+                throwElementConversionError(text);
+            return value;
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            return std::string(text);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return text == "t" || text == "1" || text == "true";
+        }
+        else
+        {
+            T value = T();
+            std::stringstream ss{std::string(text)};
+            ss >> value;
+            return value;
+        }
+    }
+
     const Result result_;           ///< 所属的结果集对象
 };
 
@@ -155,6 +259,15 @@ template <>
 char *Field::as<char *>() const;
 template <>
 std::vector<char> Field::as<std::vector<char>>() const;
+/// 字段文本（DATE、DATETIME、TIMESTAMP）按UTC解释，与DateTime::toDbString()互逆，
+/// 不经过mktime；格式不合法时抛出ConversionError，NULL和零值日期
+/// （"0000-00-00 00:00:00"）返回DateTime()
+template <>
+DateTime Field::as<DateTime>() const;
+/// 字段文本（DECIMAL）直接解析为定点数，scale与文本中的小数位数相同；
+/// 格式不合法或超过38位有效数字时抛出ConversionError，NULL返回0
+template <>
+Decimal Field::as<Decimal>() const;
 
 // 具体类型的转换实现
 template <>
@@ -165,22 +278,6 @@ inline std::string_view Field::as<std::string_view>() const
     return {first, length};
 }
 
-template <>
-inline float Field::as<float>() const
-{
-    if (isNull())
-        return 0.0f;
-    return std::stof(result_.getValue(row_, column_));
-}
-
-template <>
-inline double Field::as<double>() const
-{
-    if (isNull())
-        return 0.0;
-    return std::stod(result_.getValue(row_, column_));
-}
-
 template <>
 inline bool Field::as<bool>() const
 {
@@ -192,70 +289,6 @@ inline bool Field::as<bool>() const
     return (*value == 't' || *value == '1');    // 简化条件判断
 }
 
-template <>
-inline int Field::as<int>() const
-{
-    if (isNull())
-        return 0;
-    return std::stoi(result_.getValue(row_, column_));
-}
-
-template <>
-inline long Field::as<long>() const
-{
-    if (isNull())
-        return 0L;
-    return std::stol(result_.getValue(row_, column_));
-}
-
-template <>
-inline int8_t Field::as<int8_t>() const
-{
-    if (isNull())
-        return 0;
-    return static_cast<int8_t>(atoi(result_.getValue(row_, column_)));
-}
-
-template <>
-inline long long Field::as<long long>() const
-{
-    if (isNull())
-        return 0LL;
-    return atoll(result_.getValue(row_, column_));
-}
-
-template <>
-inline unsigned int Field::as<unsigned int>() const
-{
-    if (isNull())
-        return 0u;
-    return static_cast<unsigned int>(std::stoul(result_.getValue(row_, column_)));
-}
-
-template <>
-inline unsigned long Field::as<unsigned long>() const
-{
-    if (isNull())
-        return 0ul;
-    return std::stoul(result_.getValue(row_, column_));
-}
-
-template <>
-inline uint8_t Field::as<uint8_t>() const
-{
-    if (isNull())
-        return 0;
-    return static_cast<uint8_t>(atoi(result_.getValue(row_, column_)));
-}
-
-template <>
-inline unsigned long long Field::as<unsigned long long>() const
-{
-    if (isNull())
-        return 0ull;
-    return std::stoull(result_.getValue(row_, column_));
-}
-
 }  // namespace cxk
 
 #endif //FIELD_H
\ No newline at end of file
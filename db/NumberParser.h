@@ -0,0 +1,72 @@
+//
+// Created by cxk_zjq on 25-6-27.
+//
+
+#ifndef NUMBERPARSER_H
+#define NUMBERPARSER_H
+
+#include "utils/utils.h"
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace cxk
+{
+namespace detail
+{
+// 按数值解析的类型，char按字符处理，bool有单独的特化
+template <typename T>
+constexpr bool isNumericField =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+    !std::is_same_v<T, char>;
+
+/**
+ * @brief 把整个字符串解析为数值，不分配内存、与locale无关
+ *
+ * 不超过16位的整数走utils::parseInt64的向量化路径，其余情况使用std::from_chars。
+ * @return 字符串为空、含有多余字符或超出T的范围时返回false
+ */
+template <typename T>
+bool parseNumber(std::string_view text, T &value) noexcept
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        int64_t v;
+        if (utils::parseInt64(text.data(), text.size(), v))
+        {
+            if constexpr (std::is_signed_v<T>)
+            {
+                if (v < std::numeric_limits<T>::min() ||
+                    v > std::numeric_limits<T>::max())
+                    return false;
+            }
+            else
+            {
+                if (v < 0 || static_cast<uint64_t>(v) >
+                                 std::numeric_limits<T>::max())
+                    return false;
+            }
+            value = static_cast<T>(v);
+            return true;
+        }
+    }
+    auto first = text.data();
+    auto last = first + text.size();
+    // from_chars不接受前导'+'，跳过后不能再跟符号（如"+-5"）
+    if (first != last && *first == '+')
+    {
+        ++first;
+        if (first != last && *first == '-')
+            return false;
+    }
+    if (first == last)
+        return false;
+    auto res = std::from_chars(first, last, value);
+    return res.ec == std::errc() && res.ptr == last;
+}
+}  // namespace detail
+}  // namespace cxk
+
+#endif  // NUMBERPARSER_H
@@ -0,0 +1,228 @@
+//
+// Created by cxk_zjq on 25-6-20.
+//
+
+#include "QueryCache.h"
+#include <algorithm>
+
+using namespace cxk;
+
+namespace
+{
+std::chrono::steady_clock::duration toDuration(double seconds)
+{
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+}
+}  // namespace
+
+QueryCache::QueryCache(size_t maxBytes, double defaultTtl, double staleTime)
+    : maxBytes_(maxBytes),
+      defaultTtl_(toDuration(defaultTtl)),
+      staleTime_(toDuration(staleTime))
+{
+}
+
+void QueryCache::setTableTtl(const std::string &table, double ttl)
+{
+    std::string name(table);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+        return tolower(c);
+    });
+    std::lock_guard<std::mutex> guard(mutex_);
+    tableTtl_[name] = toDuration(ttl);
+}
+
+QueryCache::Clock::duration QueryCache::ttlFor(
+    const std::vector<std::string> &tables) const
+{
+    auto ttl = defaultTtl_;
+    bool found = false;
+    for (auto const &table : tables)
+    {
+        auto iter = tableTtl_.find(table);
+        if (iter == tableTtl_.end())
+            continue;
+        ttl = found ? std::min(ttl, iter->second) : iter->second;
+        found = true;
+    }
+    return ttl;
+}
+
+std::optional<QueryCache::Hit> QueryCache::get(const std::string &key)
+{
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end())
+    {
+        ++misses_;
+        return std::nullopt;
+    }
+    auto &entry = iter->second;
+    if (now >= entry.staleUntil)
+    {
+        eraseEntry(iter);
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, entry.lruIter);
+    if (now < entry.expireAt)
+        return Hit{entry.result, false, false};
+    bool refresh = !entry.refreshing;
+    entry.refreshing = true;
+    return Hit{entry.result, true, refresh};
+}
+
+void QueryCache::put(const std::string &key,
+                     const Result &result,
+                     const std::vector<std::string> &tables,
+                     uint64_t epoch)
+{
+    auto bytes = estimateSize(result) + key.size();
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto iter = entries_.find(key);
+    // 已有的条目是失效之后写入的，仍然有效，保留
+    if (invalidatedSince(tables, epoch))
+        return;
+    if (iter != entries_.end())
+        eraseEntry(iter);
+    if (bytes > maxBytes_)
+        return;
+    while (bytes_ + bytes > maxBytes_ && !lru_.empty())
+    {
+        eraseEntry(entries_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    auto expireAt = now + ttlFor(tables);
+    Entry entry{result,
+                tables,
+                expireAt,
+                expireAt + staleTime_,
+                bytes,
+                lru_.begin()};
+    entries_.emplace(key, std::move(entry));
+    for (auto const &table : tables)
+    {
+        tableKeys_[table].insert(key);
+    }
+    bytes_ += bytes;
+}
+
+void QueryCache::finishRefresh(const std::string &key)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+        iter->second.refreshing = false;
+}
+
+bool QueryCache::invalidatedSince(const std::vector<std::string> &tables,
+                                  uint64_t epoch) const
+{
+    if (allEpoch_ > epoch)
+        return true;
+    for (auto const &table : tables)
+    {
+        auto iter = tableEpochs_.find(table);
+        if (iter != tableEpochs_.end() && iter->second > epoch)
+            return true;
+    }
+    return false;
+}
+
+void QueryCache::invalidateTables(const std::vector<std::string> &tables)
+{
+    if (tables.empty())
+        return;
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++epoch_;
+    for (auto const &table : tables)
+    {
+        tableEpochs_[table] = epoch_;
+        auto iter = tableKeys_.find(table);
+        if (iter == tableKeys_.end())
+            continue;
+        auto keys = std::move(iter->second);
+        tableKeys_.erase(iter);
+        for (auto const &key : keys)
+        {
+            auto entryIter = entries_.find(key);
+            if (entryIter != entries_.end())
+                eraseEntry(entryIter);
+        }
+    }
+}
+
+void QueryCache::invalidateAll()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    allEpoch_ = ++epoch_;
+    // 各表的记录都不晚于allEpoch_，不再需要
+    tableEpochs_.clear();
+    entries_.clear();
+    lru_.clear();
+    tableKeys_.clear();
+    bytes_ = 0;
+}
+
+void QueryCache::clear()
+{
+    invalidateAll();
+}
+
+void QueryCache::eraseEntry(
+    std::unordered_map<std::string, Entry>::iterator iter)
+{
+    auto &entry = iter->second;
+    for (auto const &table : entry.tables)
+    {
+        auto tableIter = tableKeys_.find(table);
+        if (tableIter == tableKeys_.end())
+            continue;
+        tableIter->second.erase(iter->first);
+        if (tableIter->second.empty())
+            tableKeys_.erase(tableIter);
+    }
+    lru_.erase(entry.lruIter);
+    bytes_ -= entry.bytes;
+    entries_.erase(iter);
+}
+
+uint64_t QueryCache::epoch() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return epoch_;
+}
+
+size_t QueryCache::size() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return entries_.size();
+}
+
+size_t QueryCache::memoryUsage() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return bytes_;
+}
+
+uint64_t QueryCache::hits() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return hits_;
+}
+
+uint64_t QueryCache::misses() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return misses_;
+}
+
+size_t QueryCache::estimateSize(const Result &result)
+{
+    // 结果自己统计的大小，put()在IO线程中调用，不能为此遍历全部字段
+    return sizeof(Entry) + 256 + result.memoryBytes();
+}
@@ -0,0 +1,151 @@
+//
+// Created by cxk_zjq on 25-6-20.
+//
+
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include "Result.h"
+#include <NonCopyable.h>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 只读查询结果的客户端缓存
+ *
+ * 以规范化后的SQL加绑定参数为键保存Result（ResultImpl不可变，可在多个调用者之间共享）。
+ * - 每个条目有独立的过期时间，可按表单独配置，未配置时使用默认TTL
+ * - 过期后在staleTime内仍可返回旧结果，并且只让第一个命中者去刷新（stale-while-revalidate）
+ * - 总内存超过预算时按LRU淘汰
+ * - 通过同一连接池写入某张表时，按表名使相关条目失效
+ *
+ * 每张表记录最近一次失效时的epoch。查询下发前取epoch()，结果返回后put()时
+ * 只要它涉及的表在此期间没有失效过就写入，写入其他表不影响在途的查询。
+ *
+ * 所有接口都是线程安全的。
+ */
+class QueryCache : public NonCopyable
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Hit
+    {
+        Result result;
+        /// 条目已过期，当前返回的是旧结果
+        bool stale;
+        /// 调用者需要负责刷新该条目，刷新结束后调用put()或finishRefresh()
+        bool refresh;
+    };
+
+    /**
+     * @param maxBytes 缓存结果占用内存的上限（估算值）
+     * @param defaultTtl 默认的过期时间，单位秒
+     * @param staleTime 过期后仍可返回旧结果的时间，单位秒，0表示不返回旧结果
+     */
+    QueryCache(size_t maxBytes, double defaultTtl, double staleTime = 0.0);
+
+    /**
+     * @brief 为涉及某张表的查询单独设置过期时间，多张表时取最小值
+     */
+    void setTableTtl(const std::string &table, double ttl);
+
+    /**
+     * @brief 查找缓存
+     * @return 未命中或条目已彻底过期时返回std::nullopt
+     */
+    std::optional<Hit> get(const std::string &key);
+
+    /**
+     * @brief 写入缓存
+     * @param tables 查询涉及的表，用于失效
+     * @param epoch 查询下发时的epoch()，期间tables中的表失效过或调用过invalidateAll()时
+     * 放弃写入（已有的条目保留），避免缓存旧数据
+     */
+    void put(const std::string &key,
+             const Result &result,
+             const std::vector<std::string> &tables,
+             uint64_t epoch);
+
+    /**
+     * @brief 刷新失败时清除条目的刷新标记，允许后续命中者重新刷新
+     */
+    void finishRefresh(const std::string &key);
+
+    /**
+     * @brief 使涉及这些表的条目失效，tables为空时什么也不做
+     */
+    void invalidateTables(const std::vector<std::string> &tables);
+
+    /**
+     * @brief 使全部条目失效，并放弃所有在途查询的写入
+     *
+     * 用于无法确定写入了哪些表的语句，如CALL。
+     */
+    void invalidateAll();
+
+    /**
+     * @brief 同invalidateAll()
+     */
+    void clear();
+
+    uint64_t epoch() const;
+    size_t size() const;
+    size_t memoryUsage() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+    /**
+     * @brief 估算一个Result占用的内存
+     */
+    static size_t estimateSize(const Result &result);
+
+  private:
+    struct Entry
+    {
+        Result result;
+        std::vector<std::string> tables;
+        Clock::time_point expireAt;
+        Clock::time_point staleUntil;
+        size_t bytes;
+        std::list<std::string>::iterator lruIter;
+        bool refreshing{false};
+    };
+
+    void eraseEntry(std::unordered_map<std::string, Entry>::iterator iter);
+    bool invalidatedSince(const std::vector<std::string> &tables,
+                          uint64_t epoch) const;
+    Clock::duration ttlFor(const std::vector<std::string> &tables) const;
+
+    const size_t maxBytes_;
+    const Clock::duration defaultTtl_;
+    const Clock::duration staleTime_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;  ///< 表头为最近使用
+    std::unordered_map<std::string, std::unordered_set<std::string>> tableKeys_;
+    std::unordered_map<std::string, Clock::duration> tableTtl_;
+    /// 每张表最近一次失效时的epoch_
+    std::unordered_map<std::string, uint64_t> tableEpochs_;
+    size_t bytes_{0};
+    /// 每次失效加1
+    uint64_t epoch_{0};
+    /// 最近一次invalidateAll()时的epoch_
+    uint64_t allEpoch_{0};
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+};
+
+}  // namespace cxk
+
+#endif  // QUERYCACHE_H
@@ -129,6 +129,11 @@ const char *Result::columnName(Result::RowSizeType number) const
     return resultPtr_->columnName(number);
 }
 
+ColumnKind Result::columnKind(Result::RowSizeType number) const
+{
+    return resultPtr_->columnKind(number);
+}
+
 Result::SizeType Result::affectedRows() const noexcept
 {
     return resultPtr_->affectedRows();
@@ -161,6 +166,11 @@ unsigned long long Result::insertId() const noexcept
     return resultPtr_->insertId();
 }
 
+size_t Result::memoryBytes() const
+{
+    return resultPtr_->memoryBytes();
+}
+
 int Result::oid(RowSizeType column) const noexcept
 {
     return resultPtr_->oid(column);
@@ -177,3 +187,15 @@ Result &Result::operator=(Result &&r) noexcept
     resultPtr_ = std::move(r.resultPtr_);
     return *this;
 }
+
+std::shared_ptr<const ColumnMetadata> Result::metadata() const
+{
+    return resultPtr_->metadata();
+}
+
+bool Result::columnCells(RowSizeType column, ColumnCells &cells) const
+{
+    if (column >= columns())
+        throw RangeError("Result column index is out of range");
+    return resultPtr_->columnCells(column, cells);
+}
@@ -10,6 +10,12 @@
 #include <string>
 #include <future>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "DbTypes.h"
+#include "Exception.h"
+#include "NumberParser.h"
 
 // 取自libpqxx并修改
 // libpqxx的许可证见COPYING文件
@@ -19,6 +25,12 @@ namespace cxk
     class ConstReverseResultIterator;   // 常量反向结果迭代器
     class Row;                          // 行数据类
     class ResultImpl;                   // 结果实现类（内部使用）
+    template <typename T>
+    class RowMapper;                    // 行到结构体的映射（内部使用）
+    class ResultJsonWriter;             // 结果集的JSON序列化
+    class ResultMessageFiller;          // 结果集填充protobuf消息
+    class ColumnMetadata;               // 按形状共享的列信息
+    class ArrowBatch;                   // 结果集的Arrow列式导出
     using ResultImplPtr = std::shared_ptr<ResultImpl>;  // 结果实现智能指针
 
 
@@ -27,6 +39,18 @@ enum class SqlStatus
     Ok,
     End
 };
+
+/**
+ * @brief 一列字段在结果集连续存储中的视图，第i行的值和长度分别为
+ * values[i * stride]和lengths[i * stride]，NULL值为nullptr
+ */
+struct ColumnCells
+{
+    const char *const *values;
+    const unsigned long *lengths;
+    size_t stride;
+};
+
 /**
  * @brief 数据库查询结果集类
  * 表示数据库查询返回的结果集，提供迭代器、行列访问等功能
@@ -182,6 +206,13 @@ class Result
      */
     const char *columnName(RowSizeType number) const;
 
+    /**
+     * @brief 获取指定列的通用类型分类
+     * @param number 列号（从0开始）
+     * @return 列的类型分类，驱动不提供类型信息时为ColumnKind::Unknown
+     */
+    ColumnKind columnKind(RowSizeType number) const;
+
     /**
      * @brief 获取受影响的行数（针对INSERT/UPDATE/DELETE操作）
      * @return 操作影响的行数，其他操作返回0
@@ -194,6 +225,77 @@ class Result
      */
     unsigned long long insertId() const noexcept;
 
+    /**
+     * @brief 估算结果集占用的内存
+     * @return 字节数，只用已经统计过的大小推算，不会为此读取全部字段
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief 把一整列解析为数值，写入out[0, size())
+     *
+     * 不经过Row和Field，结果集按连续数组存储时直接遍历字段指针；
+     * 整数使用向量化的十进制解析。NULL写入T()，并在nullBitmap中置位
+     * （第i行对应nullBitmap[i / 8]的第i % 8位，需要(size() + 7) / 8字节）。
+     * @throw RangeError 列号越界
+     * @throw ConversionError 某个字段不是合法的数值
+     */
+    template <typename T>
+    void column(RowSizeType column, T *out, uint8_t *nullBitmap = nullptr) const
+    {
+        static_assert(detail::isNumericField<T>,
+                      "column<T>() only supports integer and floating point "
+                      "types");
+        auto rows = size();
+        if (nullBitmap)
+            memset(nullBitmap, 0, (rows + 7) / 8);
+        ColumnCells cells;
+        bool contiguous = columnCells(column, cells);
+        for (SizeType i = 0; i < rows; ++i)
+        {
+            const char *value;
+            unsigned long length;
+            if (contiguous)
+            {
+                value = cells.values[i * cells.stride];
+                length = value ? cells.lengths[i * cells.stride] : 0;
+            }
+            else
+            {
+                value = getValue(i, column);
+                length = value ? getLength(i, column) : 0;
+            }
+            if (!value)
+            {
+                out[i] = T();
+                if (nullBitmap)
+                    nullBitmap[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                continue;
+            }
+            if (!detail::parseNumber(std::string_view(value, length), out[i]))
+                throw ConversionError(std::string("Cannot convert the value \"") +
+                                      std::string(value, length) +
+                                      "\" of column " + columnName(column) +
+                                      " to a number");
+        }
+    }
+
+    /**
+     * @brief 同上，返回新的vector，nullBitmap不为空时一并填充
+     */
+    template <typename T>
+    std::vector<T> column(RowSizeType column,
+                          std::vector<uint8_t> *nullBitmap = nullptr) const
+    {
+        std::vector<T> values(size());
+        if (nullBitmap)
+            nullBitmap->resize((size() + 7) / 8);
+        this->column(column,
+                     values.data(),
+                     nullBitmap ? nullBitmap->data() : nullptr);
+        return values;
+    }
+
 #ifdef _MSC_VER
     Result() noexcept = default; // MSVC兼容默认构造函数
 #endif
@@ -203,6 +305,11 @@ private:
 
     friend class Field;       // Field类可访问内部接口
     friend class Row;         // Row类可访问内部接口
+    template <typename T>
+    friend class RowMapper;   // RowMapper按列号直接读取字段
+    friend class ResultJsonWriter;
+    friend class ResultMessageFiller;
+    friend class ArrowBatch;
 
     /**
      * @brief 通过列名获取列号（内部使用）
@@ -252,6 +359,16 @@ private:
      * @return 字段值的字节长度（不包含NULL终止符）
      */
     FieldSizeType getLength(SizeType row, RowSizeType column) const;
+
+    /**
+     * @brief 按形状共享的列信息，实现不支持时为空
+     */
+    std::shared_ptr<const ColumnMetadata> metadata() const;
+
+    /**
+     * @brief 获取列的连续存储视图，检查列号；实现不支持时返回false
+     */
+    bool columnCells(RowSizeType column, ColumnCells &cells) const;
 };
 
 inline void swap(Result &one, Result &two) noexcept
@@ -5,6 +5,7 @@
 #ifndef RESULTIMPL_H
 #define RESULTIMPL_H
 
+#include "ColumnMetadata.h"
 #include "NonCopyable.h"
 #include "Result.h"
 
@@ -37,6 +38,42 @@ namespace cxk
             return 0;
         }
 
+        /**
+         * @brief 按形状共享的列信息，同一形状的结果返回同一个对象；不支持时返回空
+         */
+        virtual ColumnMetadataPtr metadata() const
+        {
+            return nullptr;
+        }
+
+        virtual ColumnKind columnKind(RowSizeType column) const
+        {
+            (void)column;
+            return ColumnKind::Unknown;
+        }
+
+        /**
+         * @brief 字段按行优先连续存储的实现可以返回列视图，供Result::column()批量读取
+         */
+        virtual bool columnCells(RowSizeType column, ColumnCells &cells) const
+        {
+            (void)column;
+            (void)cells;
+            return false;
+        }
+
+        /**
+         * @brief 结果占用内存的估算值（字节），供QueryCache记账
+         *
+         * 不应为了估算而读取全部字段。默认只按行列数计算索引的开销，
+         * 实现应当加上字段值占用的内存。
+         */
+        virtual size_t memoryBytes() const
+        {
+            return size() * columns() *
+                   (sizeof(const char *) + sizeof(FieldSizeType));
+        }
+
         virtual ~ResultImpl()
         {
         }
@@ -0,0 +1,260 @@
+//
+// Created by cxk_zjq on 25-6-28.
+//
+
+#include "ResultJsonWriter.h"
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace cxk;
+
+namespace
+{
+// JSON中必须转义的字符：'"'、'\\'和小于0x20的控制字符
+struct JsonEscapeTable
+{
+    char map[256]{};
+
+    constexpr JsonEscapeTable()
+    {
+        for (int c = 0; c < 0x20; ++c)
+            map[c] = 'u';
+        map['\b'] = 'b';
+        map['\f'] = 'f';
+        map['\n'] = 'n';
+        map['\r'] = 'r';
+        map['\t'] = 't';
+        map[static_cast<unsigned char>('"')] = '"';
+        map[static_cast<unsigned char>('\\')] = '\\';
+    }
+};
+constexpr JsonEscapeTable kJsonEscapeTable;
+
+// 返回第一个需要转义的字符的偏移，没有时返回length
+size_t findJsonEscapeChar(const char *data, size_t length)
+{
+    size_t pos = 0;
+#if defined(__AVX2__)
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i dquote = _mm256_set1_epi8('"');
+    const __m256i maxControl = _mm256_set1_epi8(0x1f);
+    for (; pos + 32 <= length; pos += 32)
+    {
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        // 无符号比较chunk <= 0x1f：min(chunk, 0x1f) == chunk
+        __m256i hit = _mm256_or_si256(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, maxControl), chunk),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, backslash),
+                            _mm256_cmpeq_epi8(chunk, dquote)));
+        auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(hit));
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i dquote = _mm_set1_epi8('"');
+    const __m128i maxControl = _mm_set1_epi8(0x1f);
+    for (; pos + 16 <= length; pos += 16)
+    {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        __m128i hit = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, maxControl), chunk),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, backslash),
+                         _mm_cmpeq_epi8(chunk, dquote)));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hit));
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+#endif
+    for (; pos < length; ++pos)
+    {
+        if (kJsonEscapeTable.map[static_cast<unsigned char>(data[pos])])
+            return pos;
+    }
+    return length;
+}
+
+void appendBase64(std::string &out, const unsigned char *data, size_t length)
+{
+    static constexpr char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.push_back('"');
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3)
+    {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        char quad[4] = {kAlphabet[v >> 18],
+                        kAlphabet[(v >> 12) & 0x3f],
+                        kAlphabet[(v >> 6) & 0x3f],
+                        kAlphabet[v & 0x3f]};
+        out.append(quad, 4);
+    }
+    if (i < length)
+    {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < length)
+            v |= data[i + 1] << 8;
+        char quad[4] = {kAlphabet[v >> 18],
+                        kAlphabet[(v >> 12) & 0x3f],
+                        i + 1 < length ? kAlphabet[(v >> 6) & 0x3f] : '=',
+                        '='};
+        out.append(quad, 4);
+    }
+    out.push_back('"');
+}
+
+enum class ValueStyle
+{
+    Number,
+    Raw,
+    Base64,
+    String,
+};
+
+ValueStyle valueStyleOf(ColumnKind kind)
+{
+    switch (kind)
+    {
+        case ColumnKind::Integer:
+        case ColumnKind::UnsignedInteger:
+        case ColumnKind::Real:
+        case ColumnKind::Decimal:
+            return ValueStyle::Number;
+        case ColumnKind::Json:
+            return ValueStyle::Raw;
+        case ColumnKind::Binary:
+        case ColumnKind::Bit:
+            return ValueStyle::Base64;
+        default:
+            return ValueStyle::String;
+    }
+}
+}  // namespace
+
+void ResultJsonWriter::appendString(std::string &out, std::string_view text)
+{
+    static constexpr char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    auto data = text.data();
+    auto length = text.size();
+    while (length > 0)
+    {
+        // 不需要转义的片段整段拷贝
+        auto pos = findJsonEscapeChar(data, length);
+        out.append(data, pos);
+        if (pos == length)
+            break;
+        auto c = static_cast<unsigned char>(data[pos]);
+        auto escaped = kJsonEscapeTable.map[c];
+        if (escaped == 'u')
+        {
+            char buf[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+            out.append(buf, 6);
+        }
+        else
+        {
+            char buf[2] = {'\\', escaped};
+            out.append(buf, 2);
+        }
+        data += pos + 1;
+        length -= pos + 1;
+    }
+    out.push_back('"');
+}
+
+void ResultJsonWriter::write(const Result &result, std::string &out) const
+{
+    struct Column
+    {
+        std::string prefix;  ///< 值之前的固定文本，如 {"id": 或 ,"name":
+        ValueStyle style;
+        ColumnCells cells;
+        bool contiguous;
+    };
+
+    auto columnCount = result.columns();
+    std::vector<Column> columns(columnCount);
+    size_t prefixBytes = 0;
+    for (Result::RowSizeType i = 0; i < columnCount; ++i)
+    {
+        auto &column = columns[i];
+        if (layout_ == Layout::Objects)
+        {
+            column.prefix = i == 0 ? "{" : ",";
+            appendString(column.prefix, result.columnName(i));
+            column.prefix.push_back(':');
+        }
+        else
+        {
+            column.prefix = i == 0 ? "[" : ",";
+        }
+        column.style = valueStyleOf(result.columnKind(i));
+        column.contiguous = result.columnCells(i, column.cells);
+        prefixBytes += column.prefix.size();
+    }
+    const char rowEnd = layout_ == Layout::Objects ? '}' : ']';
+    const char *emptyRow = layout_ == Layout::Objects ? "{}" : "[]";
+
+    auto rows = result.size();
+    out.reserve(out.size() + 2 + rows * (prefixBytes + columnCount * 4 + 2));
+    out.push_back('[');
+    for (Result::SizeType row = 0; row < rows; ++row)
+    {
+        if (row > 0)
+            out.push_back(',');
+        if (columnCount == 0)
+        {
+            out.append(emptyRow);
+            continue;
+        }
+        for (Result::RowSizeType i = 0; i < columnCount; ++i)
+        {
+            auto &column = columns[i];
+            out.append(column.prefix);
+            const char *value;
+            unsigned long length;
+            if (column.contiguous)
+            {
+                value = column.cells.values[row * column.cells.stride];
+                length =
+                    value ? column.cells.lengths[row * column.cells.stride] : 0;
+            }
+            else
+            {
+                value = result.getValue(row, i);
+                length = value ? result.getLength(row, i) : 0;
+            }
+            if (!value)
+            {
+                out.append("null", 4);
+                continue;
+            }
+            switch (column.style)
+            {
+                case ValueStyle::Number:
+                case ValueStyle::Raw:
+                    if (length > 0)
+                        out.append(value, length);
+                    else
+                        out.append("null", 4);
+                    break;
+                case ValueStyle::Base64:
+                    appendBase64(out,
+                                 reinterpret_cast<const unsigned char *>(value),
+                                 length);
+                    break;
+                case ValueStyle::String:
+                    appendString(out, std::string_view(value, length));
+                    break;
+            }
+        }
+        out.push_back(rowEnd);
+    }
+    out.push_back(']');
+}
@@ -0,0 +1,63 @@
+//
+// Created by cxk_zjq on 25-6-28.
+//
+
+#ifndef RESULTJSONWRITER_H
+#define RESULTJSONWRITER_H
+
+#include "Result.h"
+#include <string>
+#include <string_view>
+
+namespace cxk
+{
+/**
+ * @brief 把Result直接序列化为JSON文本，不经过Json::Value
+ *
+ * 结果输出为一个JSON数组，每行是一个对象（列名为键）或一个数组。
+ * 值的表示由Result::columnKind()决定：
+ * - 整数、浮点数和DECIMAL原样输出为数字
+ * - JSON列原样嵌入
+ * - 二进制列（BLOB、BIT等）输出为base64字符串
+ * - 其余按字符串转义输出，NULL输出为null
+ *
+ * 写入是追加到调用者的std::string中，处理多个结果时可以复用同一块缓冲区。
+ */
+class ResultJsonWriter
+{
+  public:
+    enum class Layout
+    {
+        Objects,  ///< [{"id":1,"name":"a"},...]
+        Arrays,   ///< [[1,"a"],...]
+    };
+
+    explicit ResultJsonWriter(Layout layout = Layout::Objects) noexcept
+        : layout_(layout)
+    {
+    }
+
+    /**
+     * @brief 把result序列化后追加到out末尾
+     */
+    void write(const Result &result, std::string &out) const;
+
+    std::string write(const Result &result) const
+    {
+        std::string out;
+        write(result, out);
+        return out;
+    }
+
+    /**
+     * @brief 把text作为JSON字符串（含两侧引号）追加到out末尾
+     */
+    static void appendString(std::string &out, std::string_view text);
+
+  private:
+    Layout layout_;
+};
+
+}  // namespace cxk
+
+#endif  // RESULTJSONWRITER_H
@@ -0,0 +1,48 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#include "ResultMemoryBudget.h"
+
+using namespace cxk;
+
+std::atomic<size_t> ResultMemoryBudget::total_{0};
+
+bool ResultMemoryBudget::tryReserve(size_t bytes) noexcept
+{
+    auto limit = limit_.load(std::memory_order_relaxed);
+    if (limit == 0)
+    {
+        reserve(bytes);
+        return true;
+    }
+    auto used = used_.load(std::memory_order_relaxed);
+    do
+    {
+        if (bytes > limit || used > limit - bytes)
+            return false;
+    } while (!used_.compare_exchange_weak(used,
+                                          used + bytes,
+                                          std::memory_order_relaxed));
+    total_.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+}
+
+void ResultMemoryBudget::reserve(size_t bytes) noexcept
+{
+    used_.fetch_add(bytes, std::memory_order_relaxed);
+    total_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ResultMemoryBudget::release(size_t bytes) noexcept
+{
+    used_.fetch_sub(bytes, std::memory_order_relaxed);
+    total_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+const ResultMemoryBudgetPtr &ResultMemoryBudget::unbounded()
+{
+    static const ResultMemoryBudgetPtr budget =
+        std::make_shared<ResultMemoryBudget>();
+    return budget;
+}
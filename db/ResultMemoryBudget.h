@@ -0,0 +1,91 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef RESULTMEMORYBUDGET_H
+#define RESULTMEMORYBUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace cxk
+{
+class ResultMemoryBudget;
+using ResultMemoryBudgetPtr = std::shared_ptr<ResultMemoryBudget>;
+
+/**
+ * @brief 存活结果集占用内存的记账与上限
+ *
+ * 每个Result在构造时把自己占用的字节数（字段值长度之和加上行和字段的
+ * 索引开销）记到所属的预算上，析构时归还。连接池持有一个预算，
+ * 其下所有连接的结果共用；不属于任何连接池的结果记在unbounded()上。
+ * 所有预算的用量同时计入进程级的totalBytes()。
+ *
+ * 上限只约束tryReserve()，reserve()总是成功，用于记录已经在内存中的结果。
+ */
+class ResultMemoryBudget
+{
+  public:
+    /**
+     * @param limit 字节数上限，0表示不限制
+     */
+    explicit ResultMemoryBudget(size_t limit = 0) noexcept : limit_(limit)
+    {
+    }
+
+    ResultMemoryBudget(const ResultMemoryBudget &) = delete;
+    ResultMemoryBudget &operator=(const ResultMemoryBudget &) = delete;
+
+    size_t limit() const noexcept
+    {
+        return limit_.load(std::memory_order_relaxed);
+    }
+
+    void setLimit(size_t limit) noexcept
+    {
+        limit_.store(limit, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 当前记在本预算上的字节数
+     */
+    size_t usedBytes() const noexcept
+    {
+        return used_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 占用bytes字节，超出上限时不占用并返回false
+     */
+    bool tryReserve(size_t bytes) noexcept;
+
+    /**
+     * @brief 不检查上限地占用bytes字节
+     */
+    void reserve(size_t bytes) noexcept;
+
+    void release(size_t bytes) noexcept;
+
+    /**
+     * @brief 不限制上限的共享预算，用于不属于连接池的连接
+     */
+    static const ResultMemoryBudgetPtr &unbounded();
+
+    /**
+     * @brief 进程内所有存活结果占用的字节数
+     */
+    static size_t totalBytes() noexcept
+    {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<size_t> limit_;
+    std::atomic<size_t> used_{0};
+    static std::atomic<size_t> total_;
+};
+
+}  // namespace cxk
+
+#endif  // RESULTMEMORYBUDGET_H
@@ -0,0 +1,269 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#include "ResultMessageFiller.h"
+#include "ColumnMetadata.h"
+#include "Exception.h"
+#include "NumberParser.h"
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <strings.h>
+#include <unordered_map>
+#include <utility>
+
+using namespace cxk;
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+namespace
+{
+constexpr size_t kMaxCachedPlans = 4096;
+
+using PlanKey = std::pair<const Descriptor *, const ColumnMetadata *>;
+
+struct PlanKeyHash
+{
+    size_t operator()(const PlanKey &key) const noexcept
+    {
+        return std::hash<const void *>()(key.first) * 31 +
+               std::hash<const void *>()(key.second);
+    }
+};
+
+// 按数值解析并经反射写入，失败时抛出ConversionError
+template <typename T, typename Setter>
+void setNumber(std::string_view text,
+               Message &message,
+               const FieldDescriptor *field,
+               Setter setter)
+{
+    T value;
+    if (!detail::parseNumber(text, value))
+        throw ConversionError(std::string("Cannot convert the value \"") +
+                              std::string(text) + "\" to the field " +
+                              field->full_name());
+    (message.GetReflection()->*setter)(&message, field, value);
+}
+
+void setField(std::string_view text,
+              Message &message,
+              const FieldDescriptor *field)
+{
+    auto reflection = message.GetReflection();
+    switch (field->cpp_type())
+    {
+        case FieldDescriptor::CPPTYPE_INT32:
+            setNumber<int32_t>(text, message, field,
+                               &google::protobuf::Reflection::SetInt32);
+            break;
+        case FieldDescriptor::CPPTYPE_INT64:
+            setNumber<int64_t>(text, message, field,
+                               &google::protobuf::Reflection::SetInt64);
+            break;
+        case FieldDescriptor::CPPTYPE_UINT32:
+            setNumber<uint32_t>(text, message, field,
+                                &google::protobuf::Reflection::SetUInt32);
+            break;
+        case FieldDescriptor::CPPTYPE_UINT64:
+            setNumber<uint64_t>(text, message, field,
+                                &google::protobuf::Reflection::SetUInt64);
+            break;
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+            setNumber<double>(text, message, field,
+                              &google::protobuf::Reflection::SetDouble);
+            break;
+        case FieldDescriptor::CPPTYPE_FLOAT:
+            setNumber<float>(text, message, field,
+                             &google::protobuf::Reflection::SetFloat);
+            break;
+        case FieldDescriptor::CPPTYPE_BOOL:
+            // 与Field::as<bool>()一致
+            reflection->SetBool(&message,
+                                field,
+                                text.size() == 1 &&
+                                    (text[0] == 't' || text[0] == '1'));
+            break;
+        case FieldDescriptor::CPPTYPE_ENUM:
+        {
+            // 数值按编号，其余按枚举值的名字
+            int32_t number;
+            if (detail::parseNumber(text, number))
+            {
+                reflection->SetEnumValue(&message, field, number);
+                break;
+            }
+            auto value = field->enum_type()->FindValueByName(std::string(text));
+            if (!value)
+                throw ConversionError(std::string("Cannot convert the value \"") +
+                                      std::string(text) + "\" to the field " +
+                                      field->full_name());
+            reflection->SetEnum(&message, field, value);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_STRING:
+            reflection->SetString(&message,
+                                  field,
+                                  std::string(text.data(), text.size()));
+            break;
+        default:
+            break;
+    }
+}
+
+bool isFillable(const FieldDescriptor *field)
+{
+    return !field->is_repeated() &&
+           field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE;
+}
+}  // namespace
+
+std::shared_ptr<const ResultMessageFiller::Plan> ResultMessageFiller::buildPlan(
+    const Result &result,
+    const Descriptor *descriptor)
+{
+    auto plan = std::make_shared<Plan>();
+    plan->metadata = result.metadata();
+    auto columnCount = result.columns();
+    for (int i = 0; i < descriptor->field_count(); ++i)
+    {
+        auto field = descriptor->field(i);
+        if (!isFillable(field))
+            continue;
+        long column = -1;
+        if (plan->metadata)
+        {
+            column = plan->metadata->find(field->name());
+        }
+        else
+        {
+            for (Result::RowSizeType c = 0; c < columnCount; ++c)
+            {
+                if (strcasecmp(result.columnName(c), field->name().c_str()) ==
+                    0)
+                    column = static_cast<long>(c);
+            }
+        }
+        if (column >= 0)
+            plan->fields.push_back(
+                {static_cast<Result::RowSizeType>(column), field});
+    }
+    return plan;
+}
+
+struct ResultMessageFiller::PlanCache
+{
+    std::shared_mutex mutex;
+    std::unordered_map<PlanKey, std::shared_ptr<const Plan>, PlanKeyHash> plans;
+
+    static PlanCache &instance()
+    {
+        static PlanCache cache;
+        return cache;
+    }
+};
+
+std::shared_ptr<const ResultMessageFiller::Plan> ResultMessageFiller::planFor(
+    const Result &result,
+    const Descriptor *descriptor)
+{
+    auto metadata = result.metadata();
+    // 没有形状信息的结果无法确定缓存键，每次重新匹配
+    if (!metadata)
+        return buildPlan(result, descriptor);
+    auto &cache = PlanCache::instance();
+    PlanKey key(descriptor, metadata.get());
+    {
+        std::shared_lock<std::shared_mutex> lock(cache.mutex);
+        auto iter = cache.plans.find(key);
+        if (iter != cache.plans.end())
+            return iter->second;
+    }
+    auto plan = buildPlan(result, descriptor);
+    std::unique_lock<std::shared_mutex> lock(cache.mutex);
+    auto iter = cache.plans.find(key);
+    if (iter != cache.plans.end())
+        return iter->second;
+    if (cache.plans.size() < kMaxCachedPlans)
+        cache.plans.emplace(key, plan);
+    return plan;
+}
+
+size_t ResultMessageFiller::cachedPlans()
+{
+    auto &cache = PlanCache::instance();
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+    return cache.plans.size();
+}
+
+std::vector<ResultMessageFiller::Source> ResultMessageFiller::sources(
+    const Plan &plan,
+    const Result &result)
+{
+    std::vector<Source> columns(plan.fields.size());
+    for (size_t i = 0; i < plan.fields.size(); ++i)
+        columns[i].contiguous =
+            result.columnCells(plan.fields[i].column, columns[i].cells);
+    return columns;
+}
+
+void ResultMessageFiller::fillRow(const Plan &plan,
+                                  const std::vector<Source> &columns,
+                                  const Result &result,
+                                  Result::SizeType row,
+                                  Message &message)
+{
+    for (size_t i = 0; i < plan.fields.size(); ++i)
+    {
+        auto &source = columns[i];
+        auto column = plan.fields[i].column;
+        const char *value;
+        unsigned long length;
+        if (source.contiguous)
+        {
+            value = source.cells.values[row * source.cells.stride];
+            length = value ? source.cells.lengths[row * source.cells.stride] : 0;
+        }
+        else
+        {
+            value = result.getValue(row, column);
+            length = value ? result.getLength(row, column) : 0;
+        }
+        if (value)
+            setField(std::string_view(value, length),
+                     message,
+                     plan.fields[i].field);
+    }
+}
+
+void ResultMessageFiller::fill(const Result &result,
+                               Message &parent,
+                               const FieldDescriptor *field)
+{
+    if (!field || !field->is_repeated() ||
+        field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE ||
+        field->containing_type() != parent.GetDescriptor())
+        throw UsageError("ResultMessageFiller needs a repeated message field "
+                         "of the parent message");
+    auto plan = planFor(result, field->message_type());
+    auto columns = sources(*plan, result);
+    auto reflection = parent.GetReflection();
+    auto rows = result.size();
+    for (Result::SizeType row = 0; row < rows; ++row)
+        fillRow(*plan, columns, result, row,
+                *reflection->AddMessage(&parent, field));
+}
+
+void ResultMessageFiller::fill(const Result &result,
+                               Result::SizeType row,
+                               Message &message)
+{
+    if (row >= result.size())
+        throw RangeError("Result row index is out of range");
+    auto plan = planFor(result, message.GetDescriptor());
+    fillRow(*plan, sources(*plan, result), result, row, message);
+}
@@ -0,0 +1,104 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef RESULTMESSAGEFILLER_H
+#define RESULTMESSAGEFILLER_H
+
+#include "Result.h"
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/repeated_ptr_field.h>
+#include <memory>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 按消息描述符把结果集的行填入protobuf消息
+ *
+ * 消息字段与列按名字（忽略ASCII大小写）对应，没有对应列的字段保持不变，
+ * 没有对应字段的列被忽略。支持非repeated的数值、bool、枚举（按编号或名字）、
+ * string和bytes字段；NULL字段不设置。数值直接从字段文本解析后经反射写入，
+ * 不经过Field和中间的std::string。
+ *
+ * 列与字段的对应关系（填充计划）按(描述符, 结果形状)缓存，
+ * 同一条语句的后续结果不再按名字匹配。
+ * 字段值无法转换时抛出ConversionError。
+ */
+class ResultMessageFiller
+{
+  public:
+    /**
+     * @brief 把result的每一行追加为out中的一条消息
+     */
+    template <typename Message>
+    static void fill(const Result &result,
+                     google::protobuf::RepeatedPtrField<Message> &out)
+    {
+        auto plan = planFor(result, Message::descriptor());
+        auto columns = sources(*plan, result);
+        auto rows = result.size();
+        out.Reserve(out.size() + static_cast<int>(rows));
+        for (Result::SizeType row = 0; row < rows; ++row)
+            fillRow(*plan, columns, result, row, *out.Add());
+    }
+
+    /**
+     * @brief 把result的每一行追加到parent的repeated消息字段field中
+     */
+    static void fill(const Result &result,
+                     google::protobuf::Message &parent,
+                     const google::protobuf::FieldDescriptor *field);
+
+    /**
+     * @brief 用result的第row行填充message
+     */
+    static void fill(const Result &result,
+                     Result::SizeType row,
+                     google::protobuf::Message &message);
+
+    /**
+     * @brief 当前缓存的填充计划数量
+     */
+    static size_t cachedPlans();
+
+  private:
+    struct FieldPlan
+    {
+        Result::RowSizeType column;
+        const google::protobuf::FieldDescriptor *field;
+    };
+
+    struct Plan
+    {
+        std::shared_ptr<const ColumnMetadata> metadata;  ///< 保证缓存键中的形状不被释放
+        std::vector<FieldPlan> fields;
+    };
+
+    // 计划中每个字段对应列的连续存储视图，每次填充取一次
+    struct Source
+    {
+        ColumnCells cells;
+        bool contiguous;
+    };
+
+    struct PlanCache;
+
+    static std::shared_ptr<const Plan> planFor(
+        const Result &result,
+        const google::protobuf::Descriptor *descriptor);
+    static std::shared_ptr<const Plan> buildPlan(
+        const Result &result,
+        const google::protobuf::Descriptor *descriptor);
+    static std::vector<Source> sources(const Plan &plan, const Result &result);
+    static void fillRow(const Plan &plan,
+                        const std::vector<Source> &columns,
+                        const Result &result,
+                        Result::SizeType row,
+                        google::protobuf::Message &message);
+};
+
+}  // namespace cxk
+
+#endif  // RESULTMESSAGEFILLER_H
@@ -0,0 +1,235 @@
+//
+// Created by cxk_zjq on 25-6-28.
+//
+
+#ifndef ROWMAPPER_H
+#define ROWMAPPER_H
+
+#include "Exception.h"
+#include "NumberParser.h"
+#include "Result.h"
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 结构体成员与列名的对应关系，通过column()或CXK_COLUMN构造
+ */
+template <typename Class, typename Member>
+struct ColumnBinding
+{
+    using ClassType = Class;
+    using MemberType = Member;
+
+    const char *name;
+    Member Class::*member;
+};
+
+template <typename Class, typename Member>
+constexpr ColumnBinding<Class, Member> column(const char *name,
+                                              Member Class::*member) noexcept
+{
+    return {name, member};
+}
+
+/**
+ * @brief 结构体到列的映射，由CXK_ROW_MAPPING特化
+ *
+ * 特化需要提供constexpr的columns()，返回ColumnBinding组成的tuple。
+ */
+template <typename T>
+struct RowMapping;
+
+/**
+ * @brief 把一个非NULL字段解码为成员类型，与SqlParamTraits一样可以按类型特化
+ *
+ * decode()返回false表示字段无法转换。NULL字段不经过decode()，
+ * 成员被赋为默认构造的值（optional为std::nullopt），与Field::as()一致。
+ */
+template <typename T, typename = void>
+struct ColumnDecoder;
+
+template <typename T>
+struct ColumnDecoder<T, std::enable_if_t<detail::isNumericField<T>>>
+{
+    static bool decode(std::string_view text, T &value) noexcept
+    {
+        return detail::parseNumber(text, value);
+    }
+};
+
+template <>
+struct ColumnDecoder<bool>
+{
+    static bool decode(std::string_view text, bool &value) noexcept
+    {
+        value = text.size() == 1 && (text[0] == 't' || text[0] == '1');
+        return true;
+    }
+};
+
+template <>
+struct ColumnDecoder<std::string>
+{
+    static bool decode(std::string_view text, std::string &value)
+    {
+        value.assign(text.data(), text.size());
+        return true;
+    }
+};
+
+template <typename T>
+struct ColumnDecoder<std::optional<T>>
+{
+    static bool decode(std::string_view text, std::optional<T> &value)
+    {
+        return ColumnDecoder<T>::decode(text, value.emplace());
+    }
+};
+
+/**
+ * @brief 按RowMapping<T>把结果集的所有行解码为T
+ *
+ * 每个结果集只按列名查找一次列号，之后逐行按列号直接取字段指针，
+ * 不再经过Row::operator[](const char *)和Field临时对象。
+ * 映射中的列名不存在时抛出RangeError，字段无法转换时抛出ConversionError。
+ */
+template <typename T>
+class RowMapper
+{
+  public:
+    /**
+     * @brief 把结果集的行追加到out末尾
+     */
+    static void map(const Result &result, std::vector<T> &out)
+    {
+        mapColumns(result, out, std::make_index_sequence<kColumns>{});
+    }
+
+    static std::vector<T> map(const Result &result)
+    {
+        std::vector<T> out;
+        map(result, out);
+        return out;
+    }
+
+  private:
+    static constexpr auto kBindings = RowMapping<T>::columns();
+    static constexpr size_t kColumns =
+        std::tuple_size_v<std::remove_const_t<decltype(kBindings)>>;
+
+    struct Column
+    {
+        Result::RowSizeType number;
+        ColumnCells cells;
+        bool contiguous;
+    };
+
+    template <size_t... I>
+    static void mapColumns(const Result &result,
+                           std::vector<T> &out,
+                           std::index_sequence<I...>)
+    {
+        std::array<Column, kColumns> columns;
+        for (size_t i = 0; i < kColumns; ++i)
+        {
+            columns[i].number = result.columnNumber(name(i));
+            columns[i].contiguous =
+                result.columnCells(columns[i].number, columns[i].cells);
+        }
+        auto rows = result.size();
+        out.reserve(out.size() + rows);
+        for (Result::SizeType row = 0; row < rows; ++row)
+        {
+            auto &object = out.emplace_back();
+            (decodeColumn<I>(result, columns[I], row, object), ...);
+        }
+    }
+
+    template <size_t I>
+    static void decodeColumn(const Result &result,
+                             const Column &column,
+                             Result::SizeType row,
+                             T &object)
+    {
+        using Member = typename std::remove_const_t<
+            std::tuple_element_t<I, std::remove_const_t<decltype(kBindings)>>>::
+            MemberType;
+        auto &member = object.*(std::get<I>(kBindings).member);
+        const char *value;
+        unsigned long length;
+        if (column.contiguous)
+        {
+            value = column.cells.values[row * column.cells.stride];
+            length = value ? column.cells.lengths[row * column.cells.stride] : 0;
+        }
+        else
+        {
+            value = result.getValue(row, column.number);
+            length = value ? result.getLength(row, column.number) : 0;
+        }
+        if (!value)
+        {
+            member = Member();
+            return;
+        }
+        if (!ColumnDecoder<Member>::decode(std::string_view(value, length),
+                                           member))
+            throw ConversionError(std::string("Cannot convert the value \"") +
+                                  std::string(value, length) + "\" of column " +
+                                  result.columnName(column.number));
+    }
+
+    static const char *name(size_t index)
+    {
+        return names(std::make_index_sequence<kColumns>{})[index];
+    }
+
+    template <size_t... I>
+    static constexpr std::array<const char *, kColumns> names(
+        std::index_sequence<I...>)
+    {
+        return {std::get<I>(kBindings).name...};
+    }
+};
+
+/**
+ * @brief 把结果集的所有行解码为T，T需要通过CXK_ROW_MAPPING声明映射
+ */
+template <typename T>
+std::vector<T> mapRows(const Result &result)
+{
+    return RowMapper<T>::map(result);
+}
+
+}  // namespace cxk
+
+/**
+ * @brief 在全局命名空间中声明结构体Type与列的映射
+ *
+ * 用法：
+ * CXK_ROW_MAPPING(User, CXK_COLUMN(User, id), cxk::column("user_name", &User::name));
+ */
+#define CXK_ROW_MAPPING(Type, ...)                 \
+    template <>                                    \
+    struct cxk::RowMapping<Type>                   \
+    {                                              \
+        static constexpr auto columns()            \
+        {                                          \
+            return std::make_tuple(__VA_ARGS__);   \
+        }                                          \
+    }
+
+/**
+ * @brief 列名与成员名相同的映射项
+ */
+#define CXK_COLUMN(Type, member) ::cxk::column(#member, &Type::member)
+
+#endif  // ROWMAPPER_H
@@ -0,0 +1,434 @@
+//
+// Created by cxk_zjq on 25-6-23.
+//
+
+#ifndef SQLBINDER_H
+#define SQLBINDER_H
+
+#include <db/DbTypes.h>
+#include <db/Decimal.h>
+#include <db/SqlTemplate.h>
+#include <NonCopyable.h>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 一组绑定参数的类型擦除视图
+ *
+ * 参数的值、长度和类型以三个等长数组给出，含义与DbConnection::execSql相同。
+ * 派生类负责持有这些数组（以及必要时参数本身），
+ * 连接只在拼接SQL期间访问它们。
+ *
+ * 绑定对象随语句一起排队，因此也携带这条语句的超时时间和结果使用的内存资源。
+ */
+class SqlBinder : public NonCopyable
+{
+  public:
+    virtual ~SqlBinder() = default;
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    const char *const *parameters() const noexcept
+    {
+        return parameters_;
+    }
+
+    const int *lengths() const noexcept
+    {
+        return lengths_;
+    }
+
+    const int *formats() const noexcept
+    {
+        return formats_;
+    }
+
+    /**
+     * @brief 语句的超时时间（秒），不大于0表示不限制
+     */
+    double timeout() const noexcept
+    {
+        return timeout_;
+    }
+
+    void setTimeout(double timeout) noexcept
+    {
+        timeout_ = timeout;
+    }
+
+    /**
+     * @brief 结果集使用的内存资源，为空时结果直接引用驱动返回的内存
+     *
+     * 不为空时，结果在回调前整体拷贝到基于该资源的arena中，
+     * 驱动的结果集随即释放。调用者需保证资源比Result活得更久。
+     */
+    std::pmr::memory_resource *resultResource() const noexcept
+    {
+        return resultResource_;
+    }
+
+    void setResultResource(std::pmr::memory_resource *resource) noexcept
+    {
+        resultResource_ = resource;
+    }
+
+    /**
+     * @brief 结果集允许占用的最大字节数，0表示不单独限制
+     *
+     * 设置后结果改为逐行读取并记账，超出时语句被中断，以ResultTooLarge回调。
+     */
+    size_t maxResultBytes() const noexcept
+    {
+        return maxResultBytes_;
+    }
+
+    void setMaxResultBytes(size_t bytes) noexcept
+    {
+        maxResultBytes_ = bytes;
+    }
+
+  protected:
+    size_t size_{0};
+    const char *const *parameters_{nullptr};
+    const int *lengths_{nullptr};
+    const int *formats_{nullptr};
+    double timeout_{0.0};
+    std::pmr::memory_resource *resultResource_{nullptr};
+    size_t maxResultBytes_{0};
+};
+
+using SqlBinderPtr = std::shared_ptr<SqlBinder>;
+
+/**
+ * @brief 持有调用者传入的三个数组，兼容基于vector的execSql接口
+ * @note 参数指向的内存仍然由调用者保证有效
+ */
+class VectorSqlBinder : public SqlBinder
+{
+  public:
+    VectorSqlBinder(std::vector<const char *> &&parameters,
+                    std::vector<int> &&length,
+                    std::vector<int> &&format)
+        : parameterVector_(std::move(parameters)),
+          lengthVector_(std::move(length)),
+          formatVector_(std::move(format))
+    {
+        size_ = parameterVector_.size();
+        parameters_ = parameterVector_.data();
+        lengths_ = lengthVector_.data();
+        formats_ = formatVector_.data();
+    }
+
+  private:
+    std::vector<const char *> parameterVector_;
+    std::vector<int> lengthVector_;
+    std::vector<int> formatVector_;
+};
+
+/**
+ * @brief 参数类型萃取，决定C++类型如何保存以及以哪种类型下发
+ *
+ * 每个特化提供：
+ * - StorageType：参数在绑定对象中的保存形式
+ * - store()：把实参转换为StorageType
+ * - format()/data()/length()：对应execSql的format、parameters和length
+ *
+ * 未特化的类型在编译期报错。
+ */
+template <typename T, typename = void>
+struct SqlParamTraits;
+
+namespace detail
+{
+template <typename Int, int Format>
+struct IntegerParamTraits
+{
+    using StorageType = Int;
+
+    template <typename T>
+    static StorageType store(T value) noexcept
+    {
+        return static_cast<StorageType>(value);
+    }
+
+    static int format(const StorageType &) noexcept
+    {
+        return Format;
+    }
+
+    static const char *data(const StorageType &value) noexcept
+    {
+        return reinterpret_cast<const char *>(&value);
+    }
+
+    static int length(const StorageType &) noexcept
+    {
+        return 0;
+    }
+};
+
+// 以字符串下发的参数，MySQL会按上下文把它转换为数值
+struct StringParamTraits
+{
+    using StorageType = std::string;
+
+    static int format(const StorageType &) noexcept
+    {
+        return type::MySqlString;
+    }
+
+    static const char *data(const StorageType &value) noexcept
+    {
+        return value.data();
+    }
+
+    static int length(const StorageType &value) noexcept
+    {
+        return static_cast<int>(value.size());
+    }
+};
+
+template <typename T>
+std::string toChars(T value)
+{
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string(buf, res.ptr);
+}
+}  // namespace detail
+
+// 有符号整数按宽度选择类型，无符号整数换成更宽的有符号类型，避免高位被当作符号位
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                     std::is_signed_v<T> && sizeof(T) == 1>>
+    : detail::IntegerParamTraits<char, type::MySqlTiny>
+{
+};
+
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                     (std::is_signed_v<T> ? sizeof(T) == 2 : sizeof(T) == 1)>>
+    : detail::IntegerParamTraits<short, type::MySqlShort>
+{
+};
+
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                     (std::is_signed_v<T> ? sizeof(T) == 4 : sizeof(T) == 2)>>
+    : detail::IntegerParamTraits<int32_t, type::MySqlLong>
+{
+};
+
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                     (std::is_signed_v<T> ? sizeof(T) == 8 : sizeof(T) == 4)>>
+    : detail::IntegerParamTraits<int64_t, type::MySqlLongLong>
+{
+};
+
+// 64位无符号整数超出BIGINT范围时无法用int64_t表示，以十进制字符串下发
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> &&
+                     sizeof(T) == 8>> : detail::StringParamTraits
+{
+    static StorageType store(T value)
+    {
+        return detail::toChars(value);
+    }
+};
+
+template <>
+struct SqlParamTraits<bool> : detail::IntegerParamTraits<char, type::MySqlTiny>
+{
+};
+
+template <typename T>
+struct SqlParamTraits<T, std::enable_if_t<std::is_floating_point_v<T>>>
+    : detail::StringParamTraits
+{
+    static StorageType store(T value)
+    {
+        return detail::toChars(value);
+    }
+};
+
+// DECIMAL按字符串下发，保留全部小数位，避免经过浮点数
+template <>
+struct SqlParamTraits<Decimal> : detail::StringParamTraits
+{
+    static StorageType store(const Decimal &value)
+    {
+        return value.toString();
+    }
+};
+
+// 字符串参数总是拷贝一份，调用者的内存在回调之前可以释放
+template <typename T>
+struct SqlParamTraits<
+    T,
+    std::enable_if_t<std::is_same_v<T, std::string> ||
+                     std::is_same_v<T, std::string_view> ||
+                     std::is_same_v<T, const char *> ||
+                     std::is_same_v<T, char *>>> : detail::StringParamTraits
+{
+    template <typename U>
+    static StorageType store(U &&value)
+    {
+        return StorageType(std::forward<U>(value));
+    }
+};
+
+template <>
+struct SqlParamTraits<std::nullptr_t>
+{
+    using StorageType = std::nullptr_t;
+
+    static StorageType store(std::nullptr_t) noexcept
+    {
+        return nullptr;
+    }
+
+    static int format(const StorageType &) noexcept
+    {
+        return type::MySqlNull;
+    }
+
+    static const char *data(const StorageType &) noexcept
+    {
+        return nullptr;
+    }
+
+    static int length(const StorageType &) noexcept
+    {
+        return 0;
+    }
+};
+
+// 空的optional下发为NULL
+template <typename T>
+struct SqlParamTraits<std::optional<T>>
+{
+    using InnerTraits = SqlParamTraits<T>;
+    using StorageType = std::optional<typename InnerTraits::StorageType>;
+
+    template <typename U>
+    static StorageType store(U &&value)
+    {
+        if (!value)
+            return std::nullopt;
+        return InnerTraits::store(*std::forward<U>(value));
+    }
+
+    static int format(const StorageType &value) noexcept
+    {
+        return value ? InnerTraits::format(*value) : type::MySqlNull;
+    }
+
+    static const char *data(const StorageType &value) noexcept
+    {
+        return value ? InnerTraits::data(*value) : nullptr;
+    }
+
+    static int length(const StorageType &value) noexcept
+    {
+        return value ? InnerTraits::length(*value) : 0;
+    }
+};
+
+/**
+ * @brief 以值保存一组类型已知的参数
+ *
+ * 参数类型在编译期由SqlParamTraits确定，参数值和三个数组都内联在对象中，
+ * 一次分配即可交给连接池排队，调用者不再需要维护参数的生命周期。
+ */
+template <typename... Args>
+class BoundSqlBinder : public SqlBinder
+{
+  public:
+    template <typename... Ts>
+    explicit BoundSqlBinder(Ts &&...args)
+        : values_(SqlParamTraits<Args>::store(std::forward<Ts>(args))...)
+    {
+        bind(std::index_sequence_for<Args...>{});
+    }
+
+  private:
+    template <size_t... I>
+    void bind(std::index_sequence<I...>)
+    {
+        ((parameterArray_[I] =
+              SqlParamTraits<Args>::data(std::get<I>(values_)),
+          lengthArray_[I] = SqlParamTraits<Args>::length(std::get<I>(values_)),
+          formatArray_[I] = SqlParamTraits<Args>::format(std::get<I>(values_))),
+         ...);
+        size_ = sizeof...(Args);
+        parameters_ = parameterArray_.data();
+        lengths_ = lengthArray_.data();
+        formats_ = formatArray_.data();
+    }
+
+    std::tuple<typename SqlParamTraits<Args>::StorageType...> values_;
+    std::array<const char *, sizeof...(Args)> parameterArray_{};
+    std::array<int, sizeof...(Args)> lengthArray_{};
+    std::array<int, sizeof...(Args)> formatArray_{};
+};
+
+template <typename T>
+using SqlParamType = std::conditional_t<
+    std::is_array_v<std::remove_reference_t<T>>,
+    const char *,
+    std::remove_cv_t<std::remove_reference_t<T>>>;
+
+/**
+ * @brief 按实参类型创建绑定对象，字符数组（字符串字面量）按const char*处理
+ */
+template <typename... Args>
+SqlBinderPtr makeSqlBinder(Args &&...args)
+{
+    return std::make_shared<BoundSqlBinder<SqlParamType<Args>...>>(
+        std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 携带编译期占位符数量的SQL字面量，通过CXK_SQL宏构造
+ *
+ * 传给变参execSql时，占位符与参数数量不一致会直接编译失败。
+ */
+template <size_t N>
+struct SqlLiteral
+{
+    static constexpr size_t placeholders = N;
+    std::string_view sql;
+};
+
+}  // namespace cxk
+
+#define CXK_SQL(literal) \
+    ::cxk::SqlLiteral<::cxk::placeholderCount(literal)>{literal}
+
+#endif  // SQLBINDER_H
@@ -0,0 +1,65 @@
+//
+// Created by cxk_zjq on 25-6-22.
+//
+
+#include "SqlTemplate.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace cxk;
+
+namespace
+{
+constexpr size_t kMaxCachedTemplates = 4096;
+
+struct TemplateCache
+{
+    std::shared_mutex mutex;
+    std::unordered_map<std::string_view, SqlTemplatePtr> templates;
+};
+
+TemplateCache &templateCache()
+{
+    static TemplateCache cache;
+    return cache;
+}
+}  // namespace
+
+SqlTemplate::SqlTemplate(std::string_view sql) : sql_(sql)
+{
+    std::string_view text(sql_);
+    size_t begin = 0;
+    for (auto pos = nextPlaceholder(text); pos != std::string_view::npos;
+         pos = nextPlaceholder(text, begin))
+    {
+        fragments_.emplace_back(begin, pos - begin);
+        begin = pos + 1;
+    }
+    fragments_.emplace_back(begin, text.size() - begin);
+}
+
+SqlTemplatePtr SqlTemplate::get(std::string_view sql)
+{
+    auto &cache = templateCache();
+    {
+        std::shared_lock<std::shared_mutex> lock(cache.mutex);
+        auto iter = cache.templates.find(sql);
+        if (iter != cache.templates.end())
+            return iter->second;
+    }
+    auto tmpl = std::make_shared<const SqlTemplate>(sql);
+    std::unique_lock<std::shared_mutex> lock(cache.mutex);
+    if (cache.templates.size() >= kMaxCachedTemplates)
+        return tmpl;
+    // 键指向模板自己持有的SQL，调用者的内存释放后依然有效
+    auto res = cache.templates.emplace(std::string_view(tmpl->sql()), tmpl);
+    return res.first->second;
+}
+
+size_t SqlTemplate::cachedTemplates()
+{
+    auto &cache = templateCache();
+    std::shared_lock<std::shared_mutex> lock(cache.mutex);
+    return cache.templates.size();
+}
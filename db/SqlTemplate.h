@@ -0,0 +1,152 @@
+//
+// Created by cxk_zjq on 25-6-22.
+//
+
+#ifndef SQLTEMPLATE_H
+#define SQLTEMPLATE_H
+
+#include <NonCopyable.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cxk
+{
+class SqlTemplate;
+using SqlTemplatePtr = std::shared_ptr<const SqlTemplate>;
+
+namespace detail
+{
+// 跳过引号包围的内容，返回闭合引号之后的位置
+constexpr size_t skipQuoted(std::string_view sql, size_t pos)
+{
+    char quote = sql[pos];
+    for (++pos; pos < sql.size(); ++pos)
+    {
+        if (sql[pos] == '\\' && quote != '`')
+        {
+            ++pos;
+        }
+        else if (sql[pos] == quote)
+        {
+            // 连续两个引号表示引号本身
+            if (pos + 1 < sql.size() && sql[pos + 1] == quote)
+                ++pos;
+            else
+                return pos + 1;
+        }
+    }
+    return sql.size();
+}
+}  // namespace detail
+
+/**
+ * @brief 从pos开始查找下一个占位符'?'，找不到时返回std::string_view::npos
+ *
+ * 字符串常量、反引号标识符和注释中的'?'会被跳过。
+ */
+constexpr size_t nextPlaceholder(std::string_view sql, size_t pos = 0)
+{
+    while (pos < sql.size())
+    {
+        char c = sql[pos];
+        if (c == '\'' || c == '"' || c == '`')
+        {
+            pos = detail::skipQuoted(sql, pos);
+        }
+        else if (c == '#' ||
+                 (c == '-' && pos + 2 < sql.size() && sql[pos + 1] == '-' &&
+                  (sql[pos + 2] == ' ' || sql[pos + 2] == '\t')))
+        {
+            auto end = sql.find('\n', pos);
+            pos = end == std::string_view::npos ? sql.size() : end + 1;
+        }
+        else if (c == '/' && pos + 1 < sql.size() && sql[pos + 1] == '*')
+        {
+            auto end = sql.find("*/", pos + 2);
+            pos = end == std::string_view::npos ? sql.size() : end + 2;
+        }
+        else if (c == '?')
+        {
+            return pos;
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief SQL中占位符的数量，可以在编译期对字面量求值
+ */
+constexpr size_t placeholderCount(std::string_view sql)
+{
+    size_t count = 0;
+    for (auto pos = nextPlaceholder(sql); pos != std::string_view::npos;
+         pos = nextPlaceholder(sql, pos + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief 按占位符'?'切分好的SQL模板
+ *
+ * 字符串常量、反引号标识符和注释中的'?'不会被当作占位符。
+ * 切分结果是placeholders()+1段字面量，绑定参数时只需依次拷贝字面量和参数值。
+ *
+ * 通过get()获取的模板缓存在进程级的表中，同一条SQL只解析一次。
+ */
+class SqlTemplate : public NonCopyable
+{
+  public:
+    /**
+     * @brief 获取（必要时解析并缓存）SQL对应的模板，线程安全
+     *
+     * 缓存以SQL内容为键，容量达到上限后新的模板只解析不缓存，
+     * 避免动态拼接的SQL让缓存无限增长。
+     */
+    static SqlTemplatePtr get(std::string_view sql);
+
+    /**
+     * @brief 直接解析一条SQL，不经过缓存
+     */
+    explicit SqlTemplate(std::string_view sql);
+
+    size_t placeholders() const noexcept
+    {
+        return fragments_.size() - 1;
+    }
+
+    /**
+     * @brief 第index段字面量，位于第index个占位符之前
+     */
+    std::string_view fragment(size_t index) const noexcept
+    {
+        return std::string_view(sql_.data() + fragments_[index].first,
+                                fragments_[index].second);
+    }
+
+    const std::string &sql() const noexcept
+    {
+        return sql_;
+    }
+
+    /**
+     * @brief 当前缓存的模板数量
+     */
+    static size_t cachedTemplates();
+
+  private:
+    std::string sql_;
+    std::vector<std::pair<size_t, size_t>> fragments_;  ///< 每段在sql_中的偏移和长度
+};
+
+}  // namespace cxk
+
+#endif  // SQLTEMPLATE_H
@@ -0,0 +1,235 @@
+//
+// Created by cxk_zjq on 25-6-24.
+//
+
+#include "Transaction.h"
+#include "DatabaseManager.h"
+#include "Exception.h"
+#include "utils/utils.h"
+#include <iterator>
+
+using namespace cxk;
+
+Transaction::Transaction(std::weak_ptr<DatabaseManager> pool,
+                         DbConnectionPtr conn)
+    : pool_(std::move(pool)), conn_(std::move(conn))
+{
+}
+
+Transaction::~Transaction()
+{
+    if (finished_ || closed_)
+        return;
+    // 在途的语句都持有本对象，走到这里时连接上已经没有本事务的语句，
+    // 但可能仍处于最后一条语句的回调中，所以回滚放到下一轮事件循环
+    auto pool = pool_;
+    auto conn = conn_;
+    conn->loop()->queueInLoop([pool, conn]() {
+        auto release = [pool, conn]() {
+            if (auto poolPtr = pool.lock())
+                poolPtr->releaseTransactionConnection(conn);
+        };
+        conn->execSql(
+            "rollback",
+            makeSqlBinder(),
+            [release](const Result &) { release(); },
+            [release](const std::exception_ptr &) { release(); });
+    });
+}
+
+void Transaction::execSql(std::string_view &&sql,
+                          SqlBinderPtr &&binder,
+                          ResultCallback &&rcb,
+                          ExceptPtrCallback &&exceptCallback)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (auto exceptPtr = unusableError())
+        {
+            if (exceptCallback)
+                exceptCallback(exceptPtr);
+            return;
+        }
+        // 写入在提交之前对其他连接不可见，失效推迟到提交时进行
+        if (utils::mayModifyData(sql))
+        {
+            auto tables = utils::extractTables(sql);
+            modified_ = true;
+            unknownTables_ = unknownTables_ || tables.empty();
+            writtenTables_.insert(writtenTables_.end(),
+                                  std::make_move_iterator(tables.begin()),
+                                  std::make_move_iterator(tables.end()));
+        }
+    }
+    if (auto pool = pool_.lock())
+        pool->applyDefaults(*binder);
+    // 回调持有事务对象，保证语句执行期间事务不会被回滚
+    auto thisPtr = shared_from_this();
+    enqueue(std::make_shared<SqlCmd>(
+        std::move(sql),
+        std::move(binder),
+        [thisPtr, rcb = std::move(rcb)](const Result &r) { rcb(r); },
+        [thisPtr, exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &e) {
+            if (exceptCallback)
+                exceptCallback(e);
+        }));
+}
+
+void Transaction::commit(ResultCallback &&rcb, ExceptPtrCallback &&exceptCallback)
+{
+    if (auto exceptPtr = finish())
+    {
+        if (exceptCallback)
+            exceptCallback(exceptPtr);
+        return;
+    }
+    auto thisPtr = shared_from_this();
+    enqueue(std::make_shared<SqlCmd>(
+        "commit",
+        makeSqlBinder(),
+        [thisPtr, rcb = std::move(rcb)](const Result &r) {
+            thisPtr->finishWrites();
+            thisPtr->releaseConnection();
+            if (rcb)
+                rcb(r);
+        },
+        [thisPtr, exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &e) {
+            // 提交途中连接断开时无法确定是否已经生效，同样做失效处理
+            thisPtr->finishWrites();
+            // 提交失败后事务仍然打开，回滚之后再归还连接
+            auto release = [thisPtr](auto &&) { thisPtr->releaseConnection(); };
+            thisPtr->conn_->loop()->queueInLoop([thisPtr, release]() {
+                thisPtr->conn_->execSql("rollback",
+                                        makeSqlBinder(),
+                                        release,
+                                        release);
+            });
+            if (exceptCallback)
+                exceptCallback(e);
+        }));
+}
+
+void Transaction::rollback()
+{
+    if (finish())
+        return;
+    auto thisPtr = shared_from_this();
+    enqueue(std::make_shared<SqlCmd>(
+        "rollback",
+        makeSqlBinder(),
+        [thisPtr](const Result &) { thisPtr->releaseConnection(); },
+        [thisPtr](const std::exception_ptr &) {
+            thisPtr->releaseConnection();
+        }));
+}
+
+bool Transaction::finished() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return finished_;
+}
+
+std::exception_ptr Transaction::finish()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (auto exceptPtr = unusableError())
+        return exceptPtr;
+    finished_ = true;
+    return nullptr;
+}
+
+std::exception_ptr Transaction::unusableError() const
+{
+    if (closed_)
+        return std::make_exception_ptr(
+            BrokenConnection("The transaction connection has been closed"));
+    if (finished_)
+        return std::make_exception_ptr(
+            UsageError("The transaction has been committed or rolled back"));
+    return nullptr;
+}
+
+void Transaction::enqueue(std::shared_ptr<SqlCmd> &&cmd)
+{
+    {
+        std::unique_lock<std::mutex> guard(mutex_);
+        // 连接可能在调用者检查状态之后断开，此后队列不会再被取出
+        if (closed_)
+        {
+            guard.unlock();
+            if (cmd->exceptionCallback_)
+                cmd->exceptionCallback_(std::make_exception_ptr(BrokenConnection(
+                    "The transaction connection has been closed")));
+            return;
+        }
+        if (running_)
+        {
+            cmds_.push_back(std::move(cmd));
+            return;
+        }
+        running_ = true;
+    }
+    conn_->execSql(std::move(cmd->sql_),
+                   std::move(cmd->binder_),
+                   std::move(cmd->callback_),
+                   std::move(cmd->exceptionCallback_));
+}
+
+void Transaction::finishWrites()
+{
+    std::vector<std::string> tables;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!modified_)
+            return;
+        if (!unknownTables_)
+            tables.swap(writtenTables_);
+        modified_ = false;
+    }
+    if (auto pool = pool_.lock())
+        pool->finishWrite(tables);
+}
+
+void Transaction::releaseConnection()
+{
+    if (auto pool = pool_.lock())
+        pool->releaseTransactionConnection(conn_);
+}
+
+void Transaction::onIdle()
+{
+    std::shared_ptr<SqlCmd> cmd;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (cmds_.empty())
+        {
+            running_ = false;
+            return;
+        }
+        cmd = std::move(cmds_.front());
+        cmds_.pop_front();
+    }
+    conn_->execSql(std::move(cmd->sql_),
+                   std::move(cmd->binder_),
+                   std::move(cmd->callback_),
+                   std::move(cmd->exceptionCallback_));
+}
+
+void Transaction::onClosed()
+{
+    std::deque<std::shared_ptr<SqlCmd>> cmds;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        closed_ = true;
+        cmds.swap(cmds_);
+    }
+    auto exceptPtr = std::make_exception_ptr(
+        BrokenConnection("The transaction connection has been closed"));
+    for (auto &cmd : cmds)
+    {
+        if (cmd->exceptionCallback_)
+            cmd->exceptionCallback_(exceptPtr);
+    }
+}
@@ -0,0 +1,135 @@
+//
+// Created by cxk_zjq on 25-6-24.
+//
+
+#ifndef TRANSACTION_H
+#define TRANSACTION_H
+
+#include <db/DbConnection.h>
+#include <db/DbCoroutine.h>
+#include <db/SqlBinder.h>
+#include <NonCopyable.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cxk
+{
+class DatabaseManager;
+
+/**
+ * @brief 独占连接池中一个连接的事务
+ *
+ * 通过DatabaseManager::newTransaction()创建，创建时已经执行过BEGIN。
+ * 事务中的SQL按提交顺序依次在该连接上执行。commit()或rollback()之后
+ * 连接归还连接池；若两者都没有调用，最后一个引用释放时自动回滚。
+ */
+class Transaction : public NonCopyable,
+                    public std::enable_shared_from_this<Transaction>
+{
+  public:
+    Transaction(std::weak_ptr<DatabaseManager> pool, DbConnectionPtr conn);
+    ~Transaction();
+
+    /**
+     * @brief 在事务中执行SQL语句，参数由binder持有
+     *
+     * 事务已经结束或连接已断开时，直接以异常回调通知。
+     * 与连接池执行的语句一样，没有单独指定时使用连接池默认的超时和结果内存上限。
+     */
+    void execSql(std::string_view &&sql,
+                 SqlBinderPtr &&binder,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback);
+
+    /**
+     * @brief 以类型安全的方式在事务中执行SQL语句，用法同DbConnection::execSql
+     */
+    template <typename... Arguments>
+    void execSql(std::string_view sql,
+                 ResultCallback rcb,
+                 ExceptPtrCallback exceptCallback,
+                 Arguments &&...args)
+    {
+        execSql(std::move(sql),
+                makeSqlBinder(std::forward<Arguments>(args)...),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    /**
+     * @brief 提交事务，提交失败时自动回滚
+     *
+     * 事务已经结束或连接已断开时，直接以异常回调通知。事务中修改过数据时，
+     * 提交后使连接池查询缓存中对应表的条目失效。
+     */
+    void commit(ResultCallback &&rcb = nullptr,
+                ExceptPtrCallback &&exceptCallback = nullptr);
+
+    /**
+     * @brief 回滚事务，已经提交或回滚时不做任何事
+     */
+    void rollback();
+
+    /**
+     * @brief 是否已经调用过commit()或rollback()
+     */
+    bool finished() const;
+
+#ifdef CXK_HAS_COROUTINE
+    template <typename... Arguments>
+    SqlAwaiter<Transaction> execSqlCoro(std::string_view sql,
+                                        Arguments &&...args)
+    {
+        return SqlAwaiter<Transaction>(
+            shared_from_this(),
+            sql,
+            makeSqlBinder(std::forward<Arguments>(args)...));
+    }
+
+    /**
+     * @brief 提交事务，失败时抛出提交语句的异常
+     */
+    CommitAwaiter<Transaction> commitCoro()
+    {
+        return CommitAwaiter<Transaction>(shared_from_this());
+    }
+#endif
+
+  private:
+    friend class DatabaseManager;
+
+    void enqueue(std::shared_ptr<SqlCmd> &&cmd);
+    /// 标记事务结束，事务已经结束或连接已断开时返回对应的异常
+    std::exception_ptr finish();
+    /// 事务不可再执行语句时返回对应的异常，调用时需持有mutex_
+    std::exception_ptr unusableError() const;
+    /// 提交后使写入的表的缓存失效，并关闭涉及这些表的在途查询
+    void finishWrites();
+    void releaseConnection();
+
+    // 由连接池在连接空闲或断开时调用
+    void onIdle();
+    void onClosed();
+
+    std::weak_ptr<DatabaseManager> pool_;
+    DbConnectionPtr conn_;
+    mutable std::mutex mutex_;
+    std::deque<std::shared_ptr<SqlCmd>> cmds_;
+    bool running_{true};  ///< 连接上是否有本事务的语句在执行，构造后紧接着执行BEGIN
+    bool finished_{false};
+    bool closed_{false};
+    /// 事务中写过的表，提交后在查询缓存中失效
+    std::vector<std::string> writtenTables_;
+    bool modified_{false};
+    bool unknownTables_{false};  ///< 有提取不到表名的写入，提交后全部失效
+};
+
+using TransactionPtr = std::shared_ptr<Transaction>;
+
+}  // namespace cxk
+
+#endif  // TRANSACTION_H
@@ -314,6 +314,11 @@ bool EventLoop::isInLoopThread() const
     return threadId_ == std::this_thread::get_id();
 }
 
+EventLoop *EventLoop::getEventLoopOfCurrentThread()
+{
+    return t_loopInThisThread;
+}
+
 std::thread::id EventLoop::threadId() const
 {
     return threadId_;
@@ -71,6 +71,12 @@ public:
      */
     bool isInLoopThread() const;
 
+    /**
+     * @brief 获取当前线程的事件循环
+     * @return 当前线程不是事件循环线程时返回nullptr
+     */
+    static EventLoop *getEventLoopOfCurrentThread();
+
     /**
      * @brief 获取当前事件循环所属的线程ID。
      * @return std::thread::id 线程ID
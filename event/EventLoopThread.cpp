@@ -63,6 +63,12 @@ EventLoopThread::~EventLoopThread()
     }
 }
 
+EventLoop *EventLoopThread::getLoop()
+{
+    absl::MutexLock lock(&loopMutex_);
+    return loop_.get();
+}
+
 void EventLoopThread::wait()
 {
     thread_.join();
@@ -0,0 +1,239 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef FAKEDBCONNECTION_H
+#define FAKEDBCONNECTION_H
+
+#include "db/DatabaseManager.h"
+#include "db/Exception.h"
+#include "test/MemoryResultImpl.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 测试用的服务端，供FakeDbConnection共用
+ *
+ * 按到达顺序记录语句，由handler生成结果（handler抛出的异常交给异常回调）。
+ * pause()之后的回复暂存起来，resume()时再按顺序投递到各自连接的EventLoop。
+ */
+class FakeServer
+{
+  public:
+    using Handler =
+        std::function<Result(const std::string &sql, const SqlBinder &binder)>;
+
+    void setHandler(Handler handler)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        handler_ = std::move(handler);
+    }
+
+    void pause()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        paused_ = true;
+    }
+
+    void resume()
+    {
+        std::deque<std::pair<EventLoop *, std::function<void()>>> replies;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            paused_ = false;
+            replies.swap(held_);
+        }
+        for (auto &reply : replies)
+            reply.first->queueInLoop(std::move(reply.second));
+    }
+
+    std::vector<std::string> statements() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return statements_;
+    }
+
+    size_t count(const std::string &sql) const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return std::count(statements_.begin(), statements_.end(), sql);
+    }
+
+    /**
+     * @brief 记录sql并生成结果，返回handler抛出的异常（没有时为空）
+     */
+    std::exception_ptr receive(const std::string &sql,
+                               const SqlBinder &binder,
+                               Result &result)
+    {
+        Handler handler;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            statements_.push_back(sql);
+            handler = handler_;
+        }
+        if (!handler)
+            return nullptr;
+        try
+        {
+            result = handler(sql, binder);
+        }
+        catch (...)
+        {
+            return std::current_exception();
+        }
+        return nullptr;
+    }
+
+    void reply(EventLoop *loop, std::function<void()> &&cb)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (paused_)
+            {
+                held_.emplace_back(loop, std::move(cb));
+                return;
+            }
+        }
+        loop->queueInLoop(std::move(cb));
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    Handler handler_;
+    bool paused_{false};
+    std::vector<std::string> statements_;
+    std::deque<std::pair<EventLoop *, std::function<void()>>> held_;
+};
+
+using FakeServerPtr = std::shared_ptr<FakeServer>;
+
+/**
+ * @brief 不访问数据库的连接，语句交给FakeServer处理
+ *
+ * 回调的时序与MySQLConnector一致：init()之后在所属线程中回调okCallback，
+ * 每条语句在所属线程中先回调结果或异常，再回调idleCallback。
+ */
+class FakeDbConnection : public DbConnection,
+                         public std::enable_shared_from_this<FakeDbConnection>
+{
+  public:
+    FakeDbConnection(EventLoop *loop, FakeServerPtr server)
+        : DbConnection(loop), server_(std::move(server))
+    {
+    }
+
+    /**
+     * @brief 供DatabaseManager::setConnectionFactory()使用
+     */
+    static DatabaseManager::ConnectionFactory factory(FakeServerPtr server)
+    {
+        return [server](EventLoop *loop, const std::string &) {
+            return std::make_shared<FakeDbConnection>(loop, server);
+        };
+    }
+
+    void init() override
+    {
+        auto thisPtr = shared_from_this();
+        loop_->queueInLoop([thisPtr]() {
+            thisPtr->status_ = ConnectStatus::Ok;
+            thisPtr->okCallback_(thisPtr);
+        });
+    }
+
+    void execSql(std::string_view &&sql,
+                 size_t,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback) override
+    {
+        execSql(std::move(sql),
+                std::make_shared<VectorSqlBinder>(std::move(parameters),
+                                                  std::move(length),
+                                                  std::move(format)),
+                std::move(rcb),
+                std::move(exceptCallback));
+    }
+
+    void execSql(std::string_view &&sql,
+                 SqlBinderPtr &&binder,
+                 ResultCallback &&rcb,
+                 ExceptPtrCallback &&exceptCallback) override
+    {
+        isWorking_ = true;
+        Result result(std::make_shared<MemoryResultImpl>(
+            std::vector<std::string>{}, std::vector<const char *>{}));
+        auto exception = server_->receive(std::string(sql), *binder, result);
+        server_->reply(loop_,
+                       [thisPtr = shared_from_this(),
+                        result,
+                        exception,
+                        rcb = std::move(rcb),
+                        exceptCallback = std::move(exceptCallback)]() {
+                           if (thisPtr->status_ != ConnectStatus::Ok)
+                           {
+                               if (exceptCallback)
+                                   exceptCallback(std::make_exception_ptr(
+                                       BrokenConnection("Connection is closed")));
+                               return;
+                           }
+                           if (exception)
+                           {
+                               if (exceptCallback)
+                                   exceptCallback(exception);
+                           }
+                           else
+                           {
+                               rcb(result);
+                           }
+                           thisPtr->isWorking_ = false;
+                           thisPtr->idleCb_();
+                       });
+    }
+
+    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) override
+    {
+        for (auto &cmd : sqlCommands)
+        {
+            execSql(std::move(cmd->sql_),
+                    std::move(cmd->binder_),
+                    std::move(cmd->callback_),
+                    std::move(cmd->exceptionCallback_));
+        }
+    }
+
+    void disconnect() override
+    {
+        auto thisPtr = shared_from_this();
+        loop_->runInLoop(
+            [thisPtr]() { thisPtr->status_ = ConnectStatus::Bad; });
+    }
+
+    /**
+     * @brief 模拟服务端断开连接：在所属线程中回调closeCallback
+     */
+    void drop()
+    {
+        auto thisPtr = shared_from_this();
+        loop_->runInLoop([thisPtr]() {
+            if (thisPtr->status_ == ConnectStatus::Bad)
+                return;
+            thisPtr->status_ = ConnectStatus::Bad;
+            thisPtr->closeCallback_(thisPtr);
+        });
+    }
+
+  private:
+    FakeServerPtr server_;
+};
+}  // namespace cxk
+
+#endif  // FAKEDBCONNECTION_H
@@ -0,0 +1,195 @@
+//
+// Created by cxk_zjq on 25-6-29.
+//
+
+#ifndef MEMORYRESULTIMPL_H
+#define MEMORYRESULTIMPL_H
+
+#include "db/ColumnMetadata.h"
+#include "db/Exception.h"
+#include "db/ResultImpl.h"
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace cxk
+{
+/**
+ * @brief 测试用的内存结果集，按行优先存放，nullptr表示NULL
+ *
+ * 字段在构造时拷贝到一块连续内存中，结果可以比实参活得更久（如连接池测试中
+ * 跨线程回调）。与MySQLResultImpl一样，指定resource时这块内存从resource分配，
+ * 否则使用默认资源。kinds为空时各列的类型为ColumnKind::Unknown。
+ */
+class MemoryResultImpl : public ResultImpl
+{
+  public:
+    MemoryResultImpl(std::vector<std::string> names,
+                     const std::vector<const char *> &values,
+                     std::vector<ColumnKind> kinds = {},
+                     std::pmr::memory_resource *resource = nullptr)
+        : names_(std::move(names)),
+          kinds_(std::move(kinds)),
+          resource_(resource ? resource : std::pmr::get_default_resource())
+    {
+        kinds_.resize(names_.size(), ColumnKind::Unknown);
+        for (auto value : values)
+            bufferSize_ += (value ? strlen(value) : 0) + 1;
+        buffer_ = static_cast<char *>(
+            resource_->allocate(bufferSize_ ? bufferSize_ : 1, 1));
+        auto pos = buffer_;
+        for (auto value : values)
+        {
+            auto length = value ? strlen(value) : 0;
+            memcpy(pos, value ? value : "", length + 1);
+            values_.push_back(value ? pos : nullptr);
+            lengths_.push_back(length);
+            pos += length + 1;
+        }
+        metadata_ = std::make_shared<const ColumnMetadata>(
+            descriptions().data(), names_.size());
+    }
+
+    ~MemoryResultImpl() override
+    {
+        resource_->deallocate(buffer_, bufferSize_ ? bufferSize_ : 1, 1);
+    }
+
+    /**
+     * @brief 让columnCells()报告字段连续存放，Result::column()走批量读取
+     */
+    void setContiguous(bool contiguous)
+    {
+        contiguous_ = contiguous;
+    }
+
+    /**
+     * @brief 列信息改由ColumnMetadata::get()获取，metadata()返回按形状共享的对象
+     */
+    void shareMetadata()
+    {
+        metadata_ = ColumnMetadata::get(descriptions().data(), names_.size());
+        shared_ = true;
+    }
+
+    void setAffectedRows(SizeType rows)
+    {
+        affectedRows_ = rows;
+    }
+
+    void setInsertId(unsigned long long id)
+    {
+        insertId_ = id;
+    }
+
+    SizeType size() const noexcept override
+    {
+        return names_.empty() ? 0 : values_.size() / names_.size();
+    }
+
+    RowSizeType columns() const noexcept override
+    {
+        return names_.size();
+    }
+
+    const char *columnName(RowSizeType number) const override
+    {
+        return names_[number].c_str();
+    }
+
+    ColumnKind columnKind(RowSizeType number) const override
+    {
+        return kinds_[number];
+    }
+
+    ColumnMetadataPtr metadata() const override
+    {
+        return shared_ ? metadata_ : nullptr;
+    }
+
+    SizeType affectedRows() const noexcept override
+    {
+        return affectedRows_;
+    }
+
+    unsigned long long insertId() const noexcept override
+    {
+        return insertId_;
+    }
+
+    RowSizeType columnNumber(const char colName[]) const override
+    {
+        ++lookups;
+        auto number = metadata_->find(colName);
+        if (number >= 0)
+            return static_cast<RowSizeType>(number);
+        throw RangeError(std::string("no column named ") + colName);
+    }
+
+    const char *getValue(SizeType row, RowSizeType column) const override
+    {
+        return values_[row * names_.size() + column];
+    }
+
+    bool isNull(SizeType row, RowSizeType column) const override
+    {
+        return getValue(row, column) == nullptr;
+    }
+
+    FieldSizeType getLength(SizeType row, RowSizeType column) const override
+    {
+        return lengths_[row * names_.size() + column];
+    }
+
+    bool columnCells(RowSizeType column, ColumnCells &cells) const override
+    {
+        cells.values = values_.data() + column;
+        cells.lengths = lengths_.data() + column;
+        cells.stride = names_.size();
+        return contiguous_;
+    }
+
+    /// columnNumber()被调用的次数
+    mutable int lookups{0};
+
+  private:
+    std::vector<ColumnDesc> descriptions() const
+    {
+        std::vector<ColumnDesc> columns;
+        for (size_t i = 0; i < names_.size(); ++i)
+            columns.push_back({names_[i], 0, 0, kinds_[i]});
+        return columns;
+    }
+
+    std::vector<std::string> names_;
+    std::vector<ColumnKind> kinds_;
+    std::pmr::memory_resource *resource_;
+    char *buffer_{nullptr};
+    size_t bufferSize_{0};
+    std::vector<const char *> values_;
+    std::vector<unsigned long> lengths_;
+    ColumnMetadataPtr metadata_;
+    bool shared_{false};
+    bool contiguous_{false};
+    SizeType affectedRows_{0};
+    unsigned long long insertId_{0};
+};
+
+/**
+ * @brief 以MemoryResultImpl构造Result
+ */
+inline Result makeMemoryResult(std::vector<std::string> names,
+                               const std::vector<const char *> &values,
+                               std::vector<ColumnKind> kinds = {},
+                               std::pmr::memory_resource *resource = nullptr)
+{
+    return Result(std::make_shared<MemoryResultImpl>(std::move(names),
+                                                     values,
+                                                     std::move(kinds),
+                                                     resource));
+}
+}  // namespace cxk
+
+#endif  // MEMORYRESULTIMPL_H
@@ -0,0 +1,106 @@
+/**
+*@ClassName test_arrayparser
+*@Author cxk
+*@Data 25-6-29 下午5:10
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ArrayParser.h"
+#include "db/Exception.h"
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+using juncture = ArrayParser::juncture;
+
+std::vector<ArrayParser::Token> tokens(const std::string &input)
+{
+    ArrayParser parser(input.data(), input.size());
+    std::vector<ArrayParser::Token> out;
+    for (;;)
+    {
+        auto token = parser.nextToken();
+        if (token.type == juncture::done)
+            break;
+        out.push_back(token);
+    }
+    return out;
+}
+}  // namespace
+
+TEST(ArrayParserTest, YieldsViewsIntoInput)
+{
+    std::string input = "{1,NULL,abc,\"q d\"}";
+    auto found = tokens(input);
+    ASSERT_EQ(found.size(), 6u);
+    EXPECT_EQ(found[0].type, juncture::row_start);
+    EXPECT_EQ(found[1].text, "1");
+    EXPECT_EQ(found[2].type, juncture::null_value);
+    EXPECT_EQ(found[3].text, "abc");
+    EXPECT_EQ(found[4].text, "q d");
+    EXPECT_EQ(found[4].quote, '"');
+    EXPECT_FALSE(found[4].escaped);
+    EXPECT_EQ(found[5].type, juncture::row_end);
+    // 没有转义的值直接指向输入
+    EXPECT_EQ(found[3].text.data(), input.data() + 8);
+}
+
+TEST(ArrayParserTest, UnescapesQuotedStrings)
+{
+    std::string input = "{\"a\\\\b\\\"c\",'it''s','x\\'y'}";
+    auto found = tokens(input);
+    ASSERT_EQ(found.size(), 5u);
+    std::vector<std::string> values;
+    for (size_t i = 1; i < 4; ++i)
+    {
+        EXPECT_TRUE(found[i].escaped);
+        std::string value;
+        ArrayParser::unescape(found[i], value);
+        values.push_back(value);
+    }
+    EXPECT_EQ(values[0], "a\\b\"c");
+    EXPECT_EQ(values[1], "it's");
+    EXPECT_EQ(values[2], "x'y");
+}
+
+TEST(ArrayParserTest, ScansLongElements)
+{
+    // 超过一个SIMD块的元素，分隔符和引号分别落在块内的不同位置
+    for (size_t length = 1; length < 80; ++length)
+    {
+        std::string plain(length, 'x');
+        std::string quoted(length, 'y');
+        quoted[length / 2] = '\\';
+        quoted.insert(length / 2, "\\");
+        auto input = "{" + plain + ",\"" + quoted + "\"}";
+        auto found = tokens(input);
+        ASSERT_EQ(found.size(), 4u) << length;
+        EXPECT_EQ(found[1].text, plain);
+        std::string value;
+        ArrayParser::unescape(found[2], value);
+        std::string expected(length, 'y');
+        expected[length / 2] = '\\';
+        EXPECT_EQ(value, expected);
+    }
+}
+
+TEST(ArrayParserTest, KeepsGetNextCompatible)
+{
+    ArrayParser parser("{'a''b',NULL}");
+    EXPECT_EQ(parser.getNext().first, juncture::row_start);
+    auto value = parser.getNext();
+    EXPECT_EQ(value.first, juncture::string_value);
+    EXPECT_EQ(value.second, "a'b");
+    EXPECT_EQ(parser.getNext().first, juncture::null_value);
+    EXPECT_EQ(parser.getNext().first, juncture::row_end);
+    EXPECT_EQ(parser.getNext().first, juncture::done);
+}
+
+TEST(ArrayParserTest, RejectsUnterminatedStrings)
+{
+    EXPECT_THROW(tokens("{\"abc"), ArgumentError);
+    EXPECT_THROW(tokens("{'abc\\"), ArgumentError);
+}
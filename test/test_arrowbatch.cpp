@@ -0,0 +1,93 @@
+/**
+*@ClassName test_arrowbatch
+*@Author cxk
+*@Data 25-6-29 下午3:10
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ArrowBatch.h"
+#include "test/MemoryResultImpl.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+Result sampleResult()
+{
+    return makeMemoryResult(
+        {"id", "score", "name", "big"},
+        {"1", "1.5", "alice", "18446744073709551615",
+         "-2", nullptr, nullptr, "0",
+         "3", "0.25", "", "7"},
+        {ColumnKind::Integer,
+         ColumnKind::Real,
+         ColumnKind::String,
+         ColumnKind::UnsignedInteger});
+}
+
+template <typename T>
+T valueAt(const ArrowColumn &column, size_t row)
+{
+    T value;
+    memcpy(&value, column.values.data() + row * sizeof(T), sizeof(T));
+    return value;
+}
+}  // namespace
+
+TEST(ArrowBatchTest, BuildsColumnarBuffers)
+{
+    for (unsigned threads : {1u, 4u})
+    {
+        auto batch = ArrowBatch::fromResult(sampleResult(), threads);
+        ASSERT_EQ(batch.rows(), 3);
+        ASSERT_EQ(batch.columns().size(), 4u);
+
+        auto &id = batch.columns()[0];
+        EXPECT_EQ(id.type, ArrowColumn::Type::Int64);
+        EXPECT_EQ(id.nullCount, 0);
+        EXPECT_TRUE(id.validity.empty());
+        EXPECT_EQ(valueAt<int64_t>(id, 1), -2);
+
+        auto &score = batch.columns()[1];
+        EXPECT_EQ(score.type, ArrowColumn::Type::Float64);
+        EXPECT_EQ(score.nullCount, 1);
+        ASSERT_EQ(score.validity.size(), 1u);
+        EXPECT_EQ(score.validity[0], 0b101);
+        EXPECT_DOUBLE_EQ(valueAt<double>(score, 2), 0.25);
+
+        auto &name = batch.columns()[2];
+        EXPECT_EQ(name.type, ArrowColumn::Type::Utf8);
+        EXPECT_EQ(name.offsets, (std::vector<int32_t>{0, 5, 5, 5}));
+        EXPECT_EQ(std::string(name.values.begin(), name.values.end()), "alice");
+
+        auto &big = batch.columns()[3];
+        EXPECT_EQ(big.type, ArrowColumn::Type::UInt64);
+        EXPECT_EQ(valueAt<uint64_t>(big, 0), 18446744073709551615ULL);
+    }
+}
+
+TEST(ArrowBatchTest, RejectsBadNumbers)
+{
+    auto result = makeMemoryResult({"id"}, {"12a"}, {ColumnKind::Integer});
+    EXPECT_THROW(ArrowBatch::fromResult(result), ConversionError);
+}
+
+TEST(ArrowBatchTest, WritesIpcStream)
+{
+    auto batch = ArrowBatch::fromResult(sampleResult());
+    std::string stream;
+    batch.writeIpcStream(stream);
+    ASSERT_GE(stream.size(), 16u);
+    // 每条消息以连续标记开头，元数据长度按8字节对齐，流以空消息结束
+    uint32_t marker, length;
+    memcpy(&marker, stream.data(), 4);
+    memcpy(&length, stream.data() + 4, 4);
+    EXPECT_EQ(marker, 0xFFFFFFFFu);
+    EXPECT_EQ(length % 8, 0u);
+    EXPECT_EQ(stream.size() % 8, 0u);
+    EXPECT_EQ(stream.substr(stream.size() - 8),
+              std::string("\xff\xff\xff\xff\0\0\0\0", 8));
+}
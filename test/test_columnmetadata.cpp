@@ -0,0 +1,49 @@
+/**
+*@ClassName test_columnmetadata
+*@Author cxk
+*@Data 25-6-28 上午9:40
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ColumnMetadata.h"
+#include <string>
+
+using namespace cxk;
+
+TEST(ColumnMetadataTest, FindsColumnsIgnoringCase)
+{
+    ColumnDesc columns[] = {{"id", 3, 0}, {"UserName", 253, 0}, {"city", 253, 0}};
+    ColumnMetadata metadata(columns, 3);
+    ASSERT_EQ(metadata.size(), 3u);
+    EXPECT_STREQ(metadata.name(1), "UserName");
+    EXPECT_EQ(metadata.type(0), 3);
+    EXPECT_EQ(metadata.find("id"), 0);
+    EXPECT_EQ(metadata.find("username"), 1);
+    EXPECT_EQ(metadata.find("USERNAME"), 1);
+    EXPECT_EQ(metadata.find("City"), 2);
+    EXPECT_EQ(metadata.find("missing"), -1);
+    EXPECT_EQ(metadata.find(""), -1);
+}
+
+TEST(ColumnMetadataTest, LastDuplicateWins)
+{
+    ColumnDesc columns[] = {{"id", 3, 0}, {"ID", 3, 0}};
+    ColumnMetadata metadata(columns, 2);
+    EXPECT_EQ(metadata.find("id"), 1);
+}
+
+TEST(ColumnMetadataTest, SharesSameShape)
+{
+    std::string name = "shared_shape_col";
+    ColumnDesc columns[] = {{name, 3, 1}, {"b", 8, 0}};
+    auto first = ColumnMetadata::get(columns, 2);
+    auto second = ColumnMetadata::get(columns, 2);
+    EXPECT_EQ(first, second);
+
+    // 名称大小写、类型或标志不同都是不同的形状
+    ColumnDesc upper[] = {{"SHARED_SHAPE_COL", 3, 1}, {"b", 8, 0}};
+    EXPECT_NE(ColumnMetadata::get(upper, 2), first);
+    ColumnDesc flags[] = {{name, 3, 0}, {"b", 8, 0}};
+    EXPECT_NE(ColumnMetadata::get(flags, 2), first);
+    EXPECT_GE(ColumnMetadata::cachedShapes(), 3u);
+}
@@ -0,0 +1,122 @@
+/**
+*@ClassName test_coroutine
+*@Author cxk
+*@Data 25-6-29 下午10:20
+*/
+//
+// 协程接口需要C++20，本测试单独以C++20编译（见CMakeLists.txt）
+#include <gtest/gtest.h>
+#include "db/DatabaseManager.h"
+#include "db/DbCoroutine.h"
+#include "db/Field.h"
+#include "db/Row.h"
+#include "test/FakeDbConnection.h"
+#include <chrono>
+#include <future>
+#include <string>
+
+#ifndef CXK_HAS_COROUTINE
+#error "test_coroutine must be compiled with C++20 coroutine support"
+#endif
+
+using namespace cxk;
+using namespace std::chrono_literals;
+
+namespace
+{
+class CoroutineTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server_ = std::make_shared<FakeServer>();
+        server_->setHandler([](const std::string &sql, const SqlBinder &) {
+            if (sql.rfind("select bad", 0) == 0)
+                throw SyntaxError("You have an error in your SQL syntax", sql);
+            return makeMemoryResult({"sql"}, {sql.c_str()});
+        });
+        pool_ = std::make_shared<DatabaseManager>("", 1);
+        pool_->setConnectionFactory(FakeDbConnection::factory(server_));
+        pool_->init();
+    }
+
+    void TearDown() override
+    {
+        pool_->closeAll();
+    }
+
+    // 在协程中运行body，等待它结束并返回结果。
+    // body只应捕获裸指针：协程帧在EventLoop线程中销毁，若持有连接池的最后一个
+    // 引用，连接池会在自己的线程中析构
+    template <typename Body>
+    static std::string run(Body body)
+    {
+        auto done = std::make_shared<std::promise<std::string>>();
+        auto future = done->get_future();
+        [](Body body,
+           std::shared_ptr<std::promise<std::string>> done) -> AsyncTask {
+            try
+            {
+                done->set_value(co_await body());
+            }
+            catch (const UsageError &e)
+            {
+                done->set_value(std::string("usage error: ") + e.what());
+            }
+            catch (const SqlError &e)
+            {
+                done->set_value(std::string("sql error: ") + e.what());
+            }
+        }(std::move(body), done);
+        if (future.wait_for(5s) != std::future_status::ready)
+            return "timeout";
+        return future.get();
+    }
+
+    FakeServerPtr server_;
+    DatabaseManagerPtr pool_;
+};
+}  // namespace
+
+TEST_F(CoroutineTest, ExecSqlReturnsResultOnLoopThread)
+{
+    auto *pool = pool_.get();
+    auto text = run([pool]() -> Task<std::string> {
+        auto r = co_await pool->execSqlCoro("select id from users where id = ?",
+                                            1);
+        if (!EventLoop::getEventLoopOfCurrentThread())
+            co_return "resumed outside the loop";
+        co_return r[0][0].as<std::string>();
+    });
+    EXPECT_EQ(text, "select id from users where id = ?");
+}
+
+TEST_F(CoroutineTest, ExecSqlThrowsMappedError)
+{
+    auto *pool = pool_.get();
+    auto text = run([pool]() -> Task<std::string> {
+        co_await pool->execSqlCoro("select bad from users");
+        co_return "no exception";
+    });
+    EXPECT_EQ(text, "sql error: You have an error in your SQL syntax");
+}
+
+TEST_F(CoroutineTest, TransactionCommits)
+{
+    auto *pool = pool_.get();
+    auto text = run([pool]() -> Task<std::string> {
+        auto trans = co_await pool->newTransactionCoro();
+        co_await trans->execSqlCoro("update users set name = ? where id = ?",
+                                    "a",
+                                    1);
+        co_await trans->commitCoro();
+        // 已经提交的事务再次提交时立即抛出，协程不会挂起在等待中
+        co_await trans->commitCoro();
+        co_return "committed twice";
+    });
+    EXPECT_EQ(text,
+              "usage error: The transaction has been committed or rolled back");
+    EXPECT_EQ(server_->count("begin"), 1u);
+    EXPECT_EQ(server_->count("update users set name = ? where id = ?"), 1u);
+    EXPECT_EQ(server_->count("commit"), 1u);
+}
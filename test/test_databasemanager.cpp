@@ -0,0 +1,505 @@
+/**
+*@ClassName test_databasemanager
+*@Author cxk
+*@Data 25-6-29 下午8:40
+*/
+//
+#include <gtest/gtest.h>
+#include "db/DatabaseManager.h"
+#include "db/Field.h"
+#include "db/Row.h"
+#include "test/FakeDbConnection.h"
+#include "utils/utils.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace cxk;
+using namespace std::chrono_literals;
+
+namespace
+{
+// 记录分配字节数的内存资源，用来确认结果放在了调用者指定的资源中
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    size_t allocated() const
+    {
+        return allocated_;
+    }
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocated_ += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::atomic<size_t> allocated_{0};
+};
+
+// 统计memoryBytes()的调用次数，QueryCache每写入一次调用一次
+class SizedResultImpl : public MemoryResultImpl
+{
+  public:
+    SizedResultImpl(const char *text, std::atomic<int> &sized)
+        : MemoryResultImpl({"sql"}, {text}), sized_(sized)
+    {
+    }
+
+    size_t memoryBytes() const override
+    {
+        ++sized_;
+        return MemoryResultImpl::memoryBytes();
+    }
+
+  private:
+    std::atomic<int> &sized_;
+};
+
+class DatabaseManagerTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server_ = std::make_shared<FakeServer>();
+        // 与MySQLConnector一样，指定了结果内存资源时结果从该资源分配
+        server_->setHandler([](const std::string &sql, const SqlBinder &binder) {
+            return makeMemoryResult({"sql"},
+                                    {sql.c_str()},
+                                    {},
+                                    binder.resultResource());
+        });
+    }
+
+    void TearDown() override
+    {
+        if (pool_)
+            pool_->closeAll();
+    }
+
+    DatabaseManagerPtr startPool(size_t connNum = 1)
+    {
+        pool_ = std::make_shared<DatabaseManager>("", connNum);
+        pool_->setConnectionFactory(FakeDbConnection::factory(server_));
+        pool_->init();
+        return pool_;
+    }
+
+    // 执行sql并等待回调，返回结果中的文本或异常的what()
+    std::future<std::string> exec(const std::string &sql,
+                                  std::pmr::memory_resource *resource = nullptr)
+    {
+        return exec(*pool_, sql, resource);
+    }
+
+    template <typename Executor>
+    static std::future<std::string> exec(
+        Executor &executor,
+        const std::string &sql,
+        std::pmr::memory_resource *resource = nullptr)
+    {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto text = std::make_shared<std::string>(sql);
+        auto binder = makeSqlBinder();
+        binder->setResultResource(resource);
+        executor.execSql(
+            std::string_view(*text),
+            std::move(binder),
+            [promise, text](const Result &r) {
+                promise->set_value(r.empty() ? "" : r[0][0].as<std::string>());
+            },
+            [promise, text](const std::exception_ptr &e) {
+                promise->set_value(describe(e));
+            });
+        return promise->get_future();
+    }
+
+    std::future<TransactionPtr> beginTransaction()
+    {
+        auto promise = std::make_shared<std::promise<TransactionPtr>>();
+        pool_->newTransaction(
+            [promise](const TransactionPtr &trans) {
+                promise->set_value(trans);
+            },
+            [promise](const std::exception_ptr &) {
+                promise->set_value(nullptr);
+            });
+        return promise->get_future();
+    }
+
+    // 提交事务并等待回调，成功时返回"committed"
+    static std::future<std::string> commit(const TransactionPtr &trans)
+    {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        trans->commit(
+            [promise](const Result &) { promise->set_value("committed"); },
+            [promise](const std::exception_ptr &e) {
+                promise->set_value(describe(e));
+            });
+        return promise->get_future();
+    }
+
+    static std::string describe(const std::exception_ptr &e)
+    {
+        try
+        {
+            std::rethrow_exception(e);
+        }
+        catch (const UsageError &ex)
+        {
+            return std::string("usage error: ") + ex.what();
+        }
+        catch (const BrokenConnection &ex)
+        {
+            return std::string("broken connection: ") + ex.what();
+        }
+        catch (const std::exception &ex)
+        {
+            return std::string("error: ") + ex.what();
+        }
+    }
+
+    template <typename T>
+    static T get(std::future<T> &&f)
+    {
+        if (f.wait_for(5s) != std::future_status::ready)
+            throw std::runtime_error("timeout");
+        return f.get();
+    }
+
+    // 结果可能在IO线程中最后释放，资源需要比连接池活得更久，放在它前面声明
+    CountingResource arenas_[2];
+    FakeServerPtr server_;
+    DatabaseManagerPtr pool_;
+};
+}  // namespace
+
+TEST(ShareableQueryTest, DetectsConnectionDependentSelects)
+{
+    EXPECT_TRUE(utils::isShareableQuery("select * from users where id = 1"));
+    EXPECT_TRUE(utils::isShareableQuery(
+        "select name from users where note = '@home for update'"));
+    EXPECT_TRUE(utils::isShareableQuery("select `rand`, updated from t"));
+    EXPECT_TRUE(utils::isShareableQuery("select operand(1) from t"));
+
+    EXPECT_FALSE(utils::isShareableQuery("select * from t where id=1 for update"));
+    EXPECT_FALSE(utils::isShareableQuery("SELECT * FROM t FOR SHARE"));
+    EXPECT_FALSE(
+        utils::isShareableQuery("select * from t lock in share mode"));
+    EXPECT_FALSE(utils::isShareableQuery("select LAST_INSERT_ID()"));
+    EXPECT_FALSE(utils::isShareableQuery("select found_rows ( )"));
+    EXPECT_FALSE(utils::isShareableQuery("select row_count()"));
+    EXPECT_FALSE(utils::isShareableQuery("select @counter"));
+    EXPECT_FALSE(utils::isShareableQuery("select @@session.sql_mode"));
+    EXPECT_FALSE(utils::isShareableQuery("select get_lock('job', 10)"));
+    EXPECT_FALSE(utils::isShareableQuery("select id from t order by rand()"));
+    EXPECT_FALSE(
+        utils::isShareableQuery("select sql_calc_found_rows * from t"));
+    EXPECT_FALSE(utils::isShareableQuery("select count(*) into @n from t"));
+}
+
+TEST_F(DatabaseManagerTest, CoalescesIdenticalSelects)
+{
+    auto pool = startPool();
+    pool->setQueryCoalescing(true);
+    server_->pause();
+    auto first = exec("select * from users");
+    auto second = exec("select * from users");
+    EXPECT_EQ(pool->inflightQueries(), 1u);
+    server_->resume();
+    EXPECT_EQ(get(std::move(first)), "select * from users");
+    EXPECT_EQ(get(std::move(second)), "select * from users");
+    EXPECT_EQ(server_->count("select * from users"), 1u);
+    EXPECT_EQ(pool->inflightQueries(), 0u);
+}
+
+TEST_F(DatabaseManagerTest, DoesNotCoalesceByDefault)
+{
+    auto pool = startPool();
+    server_->pause();
+    auto first = exec("select * from users");
+    auto second = exec("select * from users");
+    EXPECT_EQ(pool->inflightQueries(), 0u);
+    server_->resume();
+    get(std::move(first));
+    get(std::move(second));
+    EXPECT_EQ(server_->count("select * from users"), 2u);
+}
+
+TEST_F(DatabaseManagerTest, WritesCloseInflightSelects)
+{
+    auto pool = startPool();
+    pool->setQueryCoalescing(true);
+    server_->pause();
+    auto before = exec("select id from users");
+    auto orders = exec("select id from orders");
+    EXPECT_EQ(pool->inflightQueries(), 2u);
+    auto write = exec("update users set name = 'x'");
+    // 写入之前在途的查询可能读不到这次写入，之后的相同查询不能再挂上去
+    EXPECT_EQ(pool->inflightQueries(), 1u);
+    auto after = exec("select id from users");
+    auto ordersAgain = exec("select id from orders");
+    EXPECT_EQ(pool->inflightQueries(), 2u);
+    server_->resume();
+    for (auto *f : {&before, &orders, &write, &after, &ordersAgain})
+        get(std::move(*f));
+    EXPECT_EQ(server_->count("select id from users"), 2u);
+    EXPECT_EQ(server_->count("select id from orders"), 1u);
+    EXPECT_EQ(pool->inflightQueries(), 0u);
+
+    // 提取不到表名的写入关闭全部在途查询
+    server_->pause();
+    before = exec("select id from users");
+    orders = exec("select id from orders");
+    write = exec("call archive_users()");
+    EXPECT_EQ(pool->inflightQueries(), 0u);
+    server_->resume();
+    for (auto *f : {&before, &orders, &write})
+        get(std::move(*f));
+}
+
+TEST_F(DatabaseManagerTest, RunsConnectionDependentSelectsSeparately)
+{
+    auto pool = startPool();
+    pool->setQueryCoalescing(true);
+    for (std::string sql : {"select * from jobs where id=1 for update",
+                            "select last_insert_id()",
+                            "select @seq",
+                            "select found_rows()"})
+    {
+        server_->pause();
+        auto first = exec(sql);
+        auto second = exec(sql);
+        EXPECT_EQ(pool->inflightQueries(), 0u) << sql;
+        server_->resume();
+        EXPECT_EQ(get(std::move(first)), sql);
+        EXPECT_EQ(get(std::move(second)), sql);
+        EXPECT_EQ(server_->count(sql), 2u) << sql;
+    }
+}
+
+TEST_F(DatabaseManagerTest, DoesNotCacheConnectionDependentSelects)
+{
+    auto pool = startPool();
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    for (int i = 0; i < 2; ++i)
+    {
+        EXPECT_EQ(get(exec("select last_insert_id()")),
+                  "select last_insert_id()");
+        EXPECT_EQ(get(exec("select id from users")), "select id from users");
+    }
+    EXPECT_EQ(server_->count("select last_insert_id()"), 2u);
+    EXPECT_EQ(server_->count("select id from users"), 1u);
+    EXPECT_EQ(pool->queryCache()->size(), 1u);
+}
+
+TEST_F(DatabaseManagerTest, CacheHitsCallBackOnLoopThread)
+{
+    auto pool = startPool();
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    for (int i = 0; i < 2; ++i)
+    {
+        std::promise<bool> onLoop;
+        pool->execSql(
+            "select id from users",
+            [&onLoop](const Result &) {
+                onLoop.set_value(EventLoop::getEventLoopOfCurrentThread() !=
+                                 nullptr);
+            },
+            nullptr);
+        auto f = onLoop.get_future();
+        ASSERT_EQ(f.wait_for(5s), std::future_status::ready);
+        EXPECT_TRUE(f.get()) << i;
+    }
+    EXPECT_EQ(pool->queryCache()->hits(), 1u);
+    EXPECT_EQ(server_->count("select id from users"), 1u);
+}
+
+TEST_F(DatabaseManagerTest, CoalescedMissesFillCacheOnce)
+{
+    std::atomic<int> sized{0};
+    server_->setHandler([&sized](const std::string &sql, const SqlBinder &) {
+        return Result(std::make_shared<SizedResultImpl>(sql.c_str(), sized));
+    });
+    auto pool = startPool();
+    pool->setQueryCoalescing(true);
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    server_->pause();
+    std::vector<std::future<std::string>> results;
+    for (int i = 0; i < 3; ++i)
+        results.push_back(exec("select id from users"));
+    EXPECT_EQ(pool->inflightQueries(), 1u);
+    server_->resume();
+    for (auto &f : results)
+        EXPECT_EQ(get(std::move(f)), "select id from users");
+    // 只有真正下发的请求写入缓存
+    EXPECT_EQ(sized, 1);
+    EXPECT_EQ(pool->queryCache()->size(), 1u);
+    EXPECT_EQ(server_->count("select id from users"), 1u);
+}
+
+TEST_F(DatabaseManagerTest, InvalidatesOnlyWrittenTables)
+{
+    auto pool = startPool();
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    get(exec("select id from users"));
+    get(exec("select id from orders"));
+    EXPECT_EQ(pool->queryCache()->size(), 2u);
+
+    // 会话设置和事务控制不修改数据
+    for (auto sql : {"set names utf8mb4", "commit", "begin", "use shop"})
+        get(exec(sql));
+    EXPECT_EQ(pool->queryCache()->size(), 2u);
+
+    get(exec("update orders set state = 1"));
+    EXPECT_EQ(pool->queryCache()->size(), 1u);
+    get(exec("select id from users"));
+    EXPECT_EQ(server_->count("select id from users"), 1u);
+
+    // 提取不到表名的写入只能全部失效
+    get(exec("call archive_users()"));
+    EXPECT_EQ(pool->queryCache()->size(), 0u);
+}
+
+TEST_F(DatabaseManagerTest, ResultsStayInCallerResource)
+{
+    auto pool = startPool();
+    pool->setQueryCoalescing(true);
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    server_->pause();
+    auto first = exec("select id from users", &arenas_[0]);
+    auto second = exec("select id from users", &arenas_[1]);
+    // 结果属于各自的调用者，不合并也不缓存
+    EXPECT_EQ(pool->inflightQueries(), 0u);
+    server_->resume();
+    EXPECT_EQ(get(std::move(first)), "select id from users");
+    EXPECT_EQ(get(std::move(second)), "select id from users");
+    EXPECT_EQ(server_->count("select id from users"), 2u);
+    EXPECT_GT(arenas_[0].allocated(), 0u);
+    EXPECT_GT(arenas_[1].allocated(), 0u);
+    EXPECT_EQ(pool->queryCache()->size(), 0u);
+
+    // 没有指定资源的相同查询照常缓存
+    get(exec("select id from users"));
+    get(exec("select id from users"));
+    EXPECT_EQ(server_->count("select id from users"), 3u);
+}
+
+TEST_F(DatabaseManagerTest, TransactionCommitInvalidatesWrittenTables)
+{
+    auto pool = startPool();
+    pool->setQueryCache(std::make_shared<QueryCache>(1 << 20, 60.0));
+    get(exec("select id from users"));
+    get(exec("select id from orders"));
+
+    auto trans = get(beginTransaction());
+    ASSERT_TRUE(trans);
+    get(exec(*trans, "update users set name = 'x' where id = 1"));
+    // 提交之前其他连接看不到写入，缓存保持不变
+    EXPECT_EQ(pool->queryCache()->size(), 2u);
+    EXPECT_EQ(get(commit(trans)), "committed");
+    EXPECT_EQ(pool->queryCache()->size(), 1u);
+
+    get(exec("select id from users"));
+    get(exec("select id from orders"));
+    EXPECT_EQ(server_->count("select id from users"), 2u);
+    EXPECT_EQ(server_->count("select id from orders"), 1u);
+
+    // 提取不到表名的写入在提交后全部失效
+    trans = get(beginTransaction());
+    ASSERT_TRUE(trans);
+    get(exec(*trans, "call archive_users()"));
+    EXPECT_EQ(get(commit(trans)), "committed");
+    EXPECT_EQ(pool->queryCache()->size(), 0u);
+}
+
+TEST_F(DatabaseManagerTest, TransactionStatementsUsePoolDefaults)
+{
+    std::mutex mutex;
+    std::vector<std::pair<double, size_t>> limits;
+    server_->setHandler([&](const std::string &sql, const SqlBinder &binder) {
+        std::lock_guard<std::mutex> guard(mutex);
+        limits.emplace_back(binder.timeout(), binder.maxResultBytes());
+        return makeMemoryResult({"sql"}, {sql.c_str()});
+    });
+    auto pool = startPool();
+    pool->setTimeout(2.5);
+    pool->setMaxResultBytes(4096);
+    auto trans = get(beginTransaction());
+    ASSERT_TRUE(trans);
+    get(exec(*trans, "select id from users"));
+    // 语句单独指定的值优先
+    auto binder = makeSqlBinder();
+    binder->setTimeout(0.5);
+    std::promise<void> done;
+    trans->execSql(
+        "select id from orders",
+        std::move(binder),
+        [&done](const Result &) { done.set_value(); },
+        nullptr);
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(get(commit(trans)), "committed");
+
+    std::lock_guard<std::mutex> guard(mutex);
+    // BEGIN，两条语句，COMMIT
+    ASSERT_EQ(limits.size(), 4u);
+    EXPECT_EQ(limits[1], std::make_pair(2.5, size_t(4096)));
+    EXPECT_EQ(limits[2], std::make_pair(0.5, size_t(4096)));
+}
+
+TEST_F(DatabaseManagerTest, FinishedTransactionRejectsCommit)
+{
+    startPool();
+    auto trans = get(beginTransaction());
+    ASSERT_TRUE(trans);
+    EXPECT_EQ(get(commit(trans)), "committed");
+    EXPECT_EQ(get(commit(trans)).rfind("usage error: ", 0), 0u);
+    EXPECT_EQ(get(exec(*trans, "select 1")).rfind("usage error: ", 0), 0u);
+    trans->rollback();
+    EXPECT_EQ(server_->count("commit"), 1u);
+    EXPECT_EQ(server_->count("rollback"), 0u);
+}
+
+TEST_F(DatabaseManagerTest, ClosedTransactionRejectsCommit)
+{
+    auto pool = startPool();
+    auto trans = get(beginTransaction());
+    ASSERT_TRUE(trans);
+    pool->closeAll();
+    EXPECT_EQ(get(commit(trans)).rfind("broken connection: ", 0), 0u);
+    EXPECT_EQ(server_->count("commit"), 0u);
+}
+
+TEST_F(DatabaseManagerTest, CloseAllFailsWaitingTransactions)
+{
+    auto pool = startPool();
+    auto first = get(beginTransaction());
+    ASSERT_TRUE(first);
+    server_->pause();
+    auto running = exec(*first, "update users set name = 'a'");
+    auto queued = exec(*first, "update users set name = 'b'");
+    // 唯一的连接被事务占用，第二个事务只能排队
+    auto waiting = beginTransaction();
+
+    pool->closeAll();
+    EXPECT_EQ(get(std::move(waiting)), nullptr);
+    EXPECT_EQ(get(std::move(queued)).rfind("broken connection: ", 0), 0u);
+    server_->resume();
+    EXPECT_EQ(get(std::move(running)).rfind("broken connection: ", 0), 0u);
+}
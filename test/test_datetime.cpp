@@ -0,0 +1,173 @@
+/**
+*@ClassName test_datetime
+*@Author cxk
+*@Data 25-6-29 下午7:20
+*/
+//
+#include <gtest/gtest.h>
+#include "time/DateTime.h"
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+
+using namespace cxk;
+
+namespace
+{
+int64_t utcSeconds(int year, int month, int day, int hour, int minute, int second)
+{
+    struct tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    return timegm(&tm);
+}
+}  // namespace
+
+TEST(DateTimeTest, ParsesDbStrings)
+{
+    DateTime date;
+    ASSERT_TRUE(DateTime::parseDbStringUtc("2025-06-29 19:20:05", date));
+    EXPECT_EQ(date.secondsSinceEpoch(), utcSeconds(2025, 6, 29, 19, 20, 5));
+    EXPECT_EQ(date.microSecondsSinceEpoch() % 1000000, 0);
+
+    ASSERT_TRUE(DateTime::parseDbStringUtc("2024-02-29 00:00:00.25", date));
+    EXPECT_EQ(date.microSecondsSinceEpoch(),
+              utcSeconds(2024, 2, 29, 0, 0, 0) * 1000000 + 250000);
+
+    ASSERT_TRUE(
+        DateTime::parseDbStringUtc("1969-12-31T23:59:59.123456789", date));
+    EXPECT_EQ(date.microSecondsSinceEpoch(), -1000000 + 123456);
+
+    ASSERT_TRUE(DateTime::parseDbStringUtc("2000-01-01", date));
+    EXPECT_EQ(date.secondsSinceEpoch(), utcSeconds(2000, 1, 1, 0, 0, 0));
+}
+
+TEST(DateTimeTest, RejectsMalformedStrings)
+{
+    DateTime date;
+    for (const char *text : {"",
+                             "2025-6-29",
+                             "2025-06-29 1:20:05",
+                             "2025-13-01",
+                             "2025-02-29",
+                             "0000-00-00 00:00:00",
+                             "2025-06-29 24:00:00",
+                             "2025-06-29 10:00:00.",
+                             "2025-06-29 10:00:00.12x",
+                             "2025/06/29 10:00:00"})
+    {
+        EXPECT_FALSE(DateTime::parseDbString(text, date)) << text;
+        EXPECT_FALSE(DateTime::parseDbStringUtc(text, date)) << text;
+    }
+    EXPECT_EQ(DateTime::fromDbString("garbage"), DateTime());
+    EXPECT_EQ(DateTime::fromDbStringUtc("garbage"), DateTime());
+}
+
+TEST(DateTimeTest, MatchesCalendarAcrossYears)
+{
+    // 逐月检查与timegm一致，覆盖闰年和世纪年
+    for (int year = 1900; year <= 2400; year += 7)
+    {
+        for (int month = 1; month <= 12; ++month)
+        {
+            char text[32];
+            snprintf(text, sizeof(text), "%04d-%02d-28 13:14:15", year, month);
+            DateTime date;
+            ASSERT_TRUE(DateTime::parseDbStringUtc(text, date)) << text;
+            EXPECT_EQ(date.secondsSinceEpoch(),
+                      utcSeconds(year, month, 28, 13, 14, 15))
+                << text;
+            EXPECT_EQ(date.toDbStringUtc(), text);
+        }
+    }
+}
+
+TEST(DateTimeTest, FormatsDbStrings)
+{
+    EXPECT_EQ(DateTime::fromDbStringUtc("2025-06-29 19:20:05").toDbStringUtc(),
+              "2025-06-29 19:20:05");
+    EXPECT_EQ(DateTime::fromDbStringUtc("2025-06-29").toDbStringUtc(),
+              "2025-06-29");
+    // 同一秒内只有微秒部分不同，复用缓存的前缀
+    auto base = DateTime::fromDbStringUtc("2025-06-29 19:20:05");
+    EXPECT_EQ(DateTime(base.microSecondsSinceEpoch() + 7).toDbStringUtc(),
+              "2025-06-29 19:20:05.000007");
+    EXPECT_EQ(DateTime(base.microSecondsSinceEpoch() + 999999).toDbStringUtc(),
+              "2025-06-29 19:20:05.999999");
+    EXPECT_EQ(DateTime(-1).toDbStringUtc(), "1969-12-31 23:59:59.999999");
+    // 四位以外的年份不走缓存，仍可读回
+    for (const char *text : {"0999-12-31 23:59:59",
+                             "0001-01-01",
+                             "0042-03-04 05:06:07.000008"})
+    {
+        EXPECT_EQ(DateTime::fromDbStringUtc(text).toDbStringUtc(), text);
+    }
+}
+
+TEST(DateTimeTest, DbStringsKeepLegacyMeaning)
+{
+    // 与旧实现（按1970年的固定时差平移本地时间）逐个比较，覆盖夏令时切换前后。
+    // 在新线程里执行，避免用到本线程在其他时区下缓存的时差
+    std::string oldTz = getenv("TZ") ? getenv("TZ") : "";
+    bool hadTz = getenv("TZ") != nullptr;
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+    std::thread([]() {
+        auto offset = static_cast<double>(DateTime::timezoneOffset());
+        auto check = [offset](int64_t seconds, int64_t microseconds) {
+            DateTime date(seconds * 1000000 + microseconds);
+            auto text = date.after(-offset).toDbStringLocal();
+            EXPECT_EQ(date.toDbString(), text) << seconds;
+            EXPECT_EQ(DateTime::fromDbString(text),
+                      DateTime::fromDbStringLocal(text).after(offset))
+                << text;
+        };
+        for (int64_t seconds = utcSeconds(2025, 1, 1, 0, 0, 0);
+             seconds < utcSeconds(2026, 1, 1, 0, 0, 0);
+             seconds += 2207)
+            check(seconds, seconds % 3 == 0 ? 0 : seconds % 1000000);
+        // 2025-03-09 07:00 UTC开始夏令时，2025-11-02 06:00 UTC结束
+        for (auto transition : {utcSeconds(2025, 3, 9, 7, 0, 0),
+                                utcSeconds(2025, 11, 2, 6, 0, 0)})
+        {
+            for (int64_t seconds = transition - 3 * 3600;
+                 seconds < transition + 3 * 3600;
+                 seconds += 59)
+                check(seconds - static_cast<int64_t>(offset), 0);
+        }
+        // 本地零点只输出日期
+        auto midnight = DateTime(2025, 7, 1, 0, 0, 0).after(offset);
+        EXPECT_EQ(midnight.toDbString(), "2025-07-01");
+        EXPECT_EQ(DateTime::fromDbString("2025-07-01"), midnight);
+    }).join();
+    if (hadTz)
+        setenv("TZ", oldTz.c_str(), 1);
+    else
+        unsetenv("TZ");
+    tzset();
+}
+
+TEST(DateTimeTest, UtcDbStringsIgnoreLocalTimeZone)
+{
+    std::string oldTz = getenv("TZ") ? getenv("TZ") : "";
+    bool hadTz = getenv("TZ") != nullptr;
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+    auto summer = DateTime(2025, 7, 1, 12, 0, 0);  // EDT，UTC-4
+    auto winter = DateTime(2025, 1, 15, 12, 0, 0);  // EST，UTC-5
+    EXPECT_EQ(summer.secondsSinceEpoch(), utcSeconds(2025, 7, 1, 16, 0, 0));
+    EXPECT_EQ(summer.toDbStringUtc(), "2025-07-01 16:00:00");
+    EXPECT_EQ(DateTime::fromDbStringUtc("2025-07-01 16:00:00"), summer);
+    EXPECT_EQ(winter.toDbStringUtc(), "2025-01-15 17:00:00");
+    EXPECT_EQ(DateTime::fromDbStringUtc("2025-01-15 17:00:00"), winter);
+    if (hadTz)
+        setenv("TZ", oldTz.c_str(), 1);
+    else
+        unsetenv("TZ");
+    tzset();
+}
@@ -0,0 +1,170 @@
+/**
+*@ClassName test_decimal
+*@Author cxk
+*@Data 25-6-29 下午8:10
+*/
+//
+#include <gtest/gtest.h>
+#include "db/Decimal.h"
+#include "db/Exception.h"
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace cxk;
+
+namespace
+{
+Decimal dec(const char *text)
+{
+    return Decimal::fromString(text);
+}
+}  // namespace
+
+TEST(DecimalTest, ParsesText)
+{
+    auto value = dec("-1234.5678");
+    EXPECT_EQ(value.unscaled(), -12345678);
+    EXPECT_EQ(value.scale(), 4u);
+    EXPECT_EQ(dec("+7").unscaled(), 7);
+    EXPECT_EQ(dec("0.05").toString(), "0.05");
+    EXPECT_EQ(dec(".5").toString(), "0.5");
+    EXPECT_EQ(dec("-0.000").toString(), "0.000");
+
+    // 恰好38位有效数字
+    std::string max(38, '9');
+    EXPECT_EQ(dec(max.c_str()).toString(), max);
+    auto fraction = "-0." + std::string(37, '9') + "1";
+    EXPECT_EQ(dec(fraction.c_str()).toString(), fraction);
+    // 前导0不计入有效数字
+    auto padded = "000000000000" + max;
+    EXPECT_EQ(dec(padded.c_str()).toString(), max);
+}
+
+TEST(DecimalTest, RejectsMalformedText)
+{
+    Decimal value = 3;
+    for (const char *text : {"", "-", "+", ".", "1.", "1..2", "1.2.3", "1e5",
+                             "12a", " 1", "1 ", "--1", "0x10",
+                             "123456789012345678901234567890123456789",
+                             "0.000000000000000000000000000000000000001"})
+    {
+        EXPECT_FALSE(Decimal::parse(text, value)) << text;
+    }
+    EXPECT_EQ(value, Decimal(3));
+    EXPECT_THROW(dec("abc"), ConversionError);
+}
+
+TEST(DecimalTest, RoundTripsRandomValues)
+{
+    // 覆盖按8字节分块时各种长度和小数点位置
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto digits = 1 + rng() % 38;
+        std::string text;
+        if (rng() % 2)
+            text += '-';
+        text += static_cast<char>('1' + rng() % 9);
+        for (size_t d = 1; d < digits; ++d)
+            text += static_cast<char>('0' + rng() % 10);
+        auto scale = rng() % digits;
+        if (scale > 0)
+            text.insert(text.size() - scale, 1, '.');
+        Decimal value;
+        ASSERT_TRUE(Decimal::parse(text, value)) << text;
+        EXPECT_EQ(value.scale(), scale);
+        EXPECT_EQ(value.toString(), text);
+    }
+}
+
+TEST(DecimalTest, ComparesByValue)
+{
+    EXPECT_EQ(dec("1.5"), dec("1.50"));
+    EXPECT_LT(dec("1.49"), dec("1.5"));
+    EXPECT_GT(dec("-1.49"), dec("-1.5"));
+    EXPECT_LT(dec("-0.01"), Decimal(0));
+    // 放大scale时溢出的一方绝对值更大
+    auto big = dec("99999999999999999999999999999999999999");
+    auto small = dec("0.00000000000000000000000000000000000001");
+    EXPECT_GT(big, small);
+    EXPECT_LT(-big, small);
+    EXPECT_GT(small, -big);
+}
+
+TEST(DecimalTest, Arithmetic)
+{
+    EXPECT_EQ((dec("19.99") + dec("0.011")).toString(), "20.001");
+    EXPECT_EQ((dec("1") - dec("1.25")).toString(), "-0.25");
+    EXPECT_EQ((dec("19.99") * 3).toString(), "59.97");
+    EXPECT_EQ((dec("1.10") * dec("-2.5")).toString(), "-2.750");
+    // 0.1 + 0.2精确等于0.3
+    EXPECT_EQ(dec("0.1") + dec("0.2"), dec("0.3"));
+
+    auto tiny = Decimal::fromUnscaled(15, 20);
+    EXPECT_EQ((tiny * tiny).scale(), Decimal::kMaxDigits);
+    EXPECT_EQ((tiny * tiny).unscaled(), 2);
+
+    auto big = dec("99999999999999999999999999999999999999");
+    EXPECT_THROW(big * 10, RangeError);
+    EXPECT_THROW(big + big, RangeError);
+    EXPECT_THROW(big.rescale(1), RangeError);
+}
+
+TEST(DecimalTest, RoundsHalfAwayFromZero)
+{
+    EXPECT_EQ(dec("2.345").rescale(2).toString(), "2.35");
+    EXPECT_EQ(dec("-2.345").rescale(2).toString(), "-2.35");
+    EXPECT_EQ(dec("2.344").rescale(2).toString(), "2.34");
+    EXPECT_EQ(dec("0.5").rescale(0).toString(), "1");
+    EXPECT_EQ(dec("7").rescale(3).toString(), "7.000");
+    EXPECT_THROW(dec("7").rescale(39), ArgumentError);
+}
+
+TEST(DecimalTest, Divides)
+{
+    EXPECT_EQ(dec("10").divide(3, 4).toString(), "3.3333");
+    EXPECT_EQ(dec("2").divide(3, 2).toString(), "0.67");
+    EXPECT_EQ(dec("-2").divide(3, 2).toString(), "-0.67");
+    EXPECT_EQ(dec("1.000").divide(dec("0.25"), 0).toString(), "4");
+    EXPECT_EQ(dec("100.00").divide(dec("-8"), 1).toString(), "-12.5");
+    EXPECT_THROW(dec("1").divide(Decimal(), 2), ArgumentError);
+}
+
+TEST(DecimalTest, DividesBeyond128BitIntermediates)
+{
+    // 被除数放大10^25后超过128位，商本身在范围内
+    auto a = dec("12345678901234567890.1234");
+    auto b = dec("3.1415926535897932384");
+    EXPECT_EQ(a.divide(b, 10).toString(), "3929751645913601180.2903484296");
+    EXPECT_EQ((-a).divide(b, 10).toString(), "-3929751645913601180.2903484296");
+    // 放大超过10^38，分两段做长除法
+    EXPECT_EQ(dec("1").divide(dec("0.300000000000000000000000000000"), 20)
+                  .toString(),
+              "3.33333333333333333333");
+    // 除数放大后超过128位，商小于1时按余数舍入
+    auto nines = dec("0.99999999999999999999999999999999999999");
+    EXPECT_EQ(nines.divide(dec("1.5"), 0).toString(), "1");
+    EXPECT_EQ(nines.divide(dec("-2.5"), 0).toString(), "0");
+    EXPECT_EQ((-nines).divide(dec("1.5"), 0).toString(), "-1");
+    // 商本身超出128位时仍然报错
+    EXPECT_THROW(dec("10").divide(3, 38), RangeError);
+    EXPECT_THROW(dec("10000000000000000000000000000000000000")
+                     .divide(dec("0.001"), 10),
+                 RangeError);
+}
+
+TEST(DecimalTest, ConvertsToOtherForms)
+{
+    EXPECT_DOUBLE_EQ(dec("-12.625").toDouble(), -12.625);
+    std::ostringstream os;
+    os << dec("-0.050");
+    EXPECT_EQ(os.str(), "-0.050");
+    char buf[Decimal::kMaxStringLength];
+    auto min = Decimal::fromUnscaled(
+        -static_cast<Decimal::Int128>(dec(std::string(38, '9').c_str())
+                                          .unscaled()),
+        Decimal::kMaxDigits);
+    EXPECT_EQ(std::string(buf, min.toChars(buf)),
+              "-0." + std::string(38, '9'));
+}
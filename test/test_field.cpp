@@ -0,0 +1,252 @@
+/**
+*@ClassName test_field
+*@Author cxk
+*@Data 25-6-27 下午3:40
+*/
+//
+#include <gtest/gtest.h>
+#include "db/Field.h"
+#include "test/MemoryResultImpl.h"
+#include "utils/utils.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+Result makeResult(std::vector<const char *> values, bool contiguous = false)
+{
+    auto impl = std::make_shared<MemoryResultImpl>(
+        std::vector<std::string>{"value"}, values);
+    impl->setContiguous(contiguous);
+    return Result(impl);
+}
+}  // namespace
+
+TEST(FieldTest, ParsesIntegers)
+{
+    auto result = makeResult({"42", "-7", "+9", "9223372036854775807"});
+    EXPECT_EQ(result[0][0].as<int>(), 42);
+    EXPECT_EQ(result[1][0].as<int64_t>(), -7);
+    EXPECT_EQ(result[2][0].as<unsigned int>(), 9u);
+    EXPECT_EQ(result[3][0].as<long long>(), 9223372036854775807LL);
+    EXPECT_EQ(result[0][0].as<int8_t>(), 42);
+}
+
+TEST(FieldTest, ParsesFloatingPoint)
+{
+    auto result = makeResult({"3.25", "-1e3", "12.50"});
+    EXPECT_DOUBLE_EQ(result[0][0].as<double>(), 3.25);
+    EXPECT_FLOAT_EQ(result[1][0].as<float>(), -1000.0f);
+    EXPECT_DOUBLE_EQ(result[2][0].as<double>(), 12.5);
+}
+
+TEST(FieldTest, RejectsInvalidNumbers)
+{
+    auto result = makeResult({"abc", "12.5", "300", "", "-1", "+-5", "+"});
+    EXPECT_THROW(result[0][0].as<int>(), ConversionError);
+    EXPECT_THROW(result[1][0].as<int>(), ConversionError);
+    EXPECT_THROW(result[2][0].as<int8_t>(), ConversionError);
+    EXPECT_THROW(result[3][0].as<double>(), ConversionError);
+    EXPECT_THROW(result[4][0].as<unsigned int>(), ConversionError);
+    EXPECT_THROW(result[5][0].as<int>(), ConversionError);
+    EXPECT_THROW(result[5][0].as<double>(), ConversionError);
+    EXPECT_THROW(result[6][0].as<int>(), ConversionError);
+}
+
+// 每个长度的数字都放在恰好等长的堆内存中，越界读取会被ASAN发现
+TEST(ParseInt64Test, ParsesEveryLength)
+{
+    const std::string digits = "98765432109876543";
+    for (size_t length = 1; length <= digits.size(); ++length)
+    {
+        for (bool negative : {false, true})
+        {
+            auto text = (negative ? "-" : "") + digits.substr(0, length);
+            std::unique_ptr<char[]> buffer(new char[text.size()]);
+            memcpy(buffer.get(), text.data(), text.size());
+            int64_t value = 0;
+            bool ok = utils::parseInt64(buffer.get(), text.size(), value);
+            EXPECT_EQ(ok, length <= 16) << text;
+            if (ok)
+                EXPECT_EQ(value, std::stoll(text)) << text;
+            // 任意位置出现非数字字符都不能通过
+            for (size_t pos = negative ? 1 : 0; pos < text.size(); ++pos)
+            {
+                auto saved = buffer[pos];
+                buffer[pos] = '/';
+                EXPECT_FALSE(
+                    utils::parseInt64(buffer.get(), text.size(), value))
+                    << text << " @" << pos;
+                buffer[pos] = saved;
+            }
+        }
+    }
+}
+
+TEST(FieldTest, TryAsDoesNotThrow)
+{
+    auto result = makeResult({"17", "x", nullptr});
+    EXPECT_EQ(result[0][0].tryAs<int>(), std::optional<int>(17));
+    EXPECT_EQ(result[1][0].tryAs<int>(), std::nullopt);
+    EXPECT_EQ(result[2][0].tryAs<int>(), std::nullopt);
+    EXPECT_EQ(result[0][0].tryAs<std::string>(), std::optional<std::string>("17"));
+}
+
+TEST(FieldTest, NullYieldsDefault)
+{
+    auto result = makeResult({nullptr});
+    EXPECT_TRUE(result[0][0].isNull());
+    EXPECT_EQ(result[0][0].as<int>(), 0);
+    EXPECT_EQ(result[0][0].as<double>(), 0.0);
+}
+
+TEST(FieldTest, ExtractsColumns)
+{
+    for (bool contiguous : {false, true})
+    {
+        // 16位以内走parseInt64，17位回退到from_chars
+        auto result = makeResult({"1",
+                                  nullptr,
+                                  "-30",
+                                  "12345678901234567",
+                                  "9",
+                                  "1234567890123456",
+                                  "-987654321098765"},
+                                 contiguous);
+        std::vector<uint8_t> nulls;
+        auto values = result.column<int64_t>(0, &nulls);
+        EXPECT_EQ(values,
+                  (std::vector<int64_t>{1,
+                                        0,
+                                        -30,
+                                        12345678901234567LL,
+                                        9,
+                                        1234567890123456LL,
+                                        -987654321098765LL}));
+        ASSERT_EQ(nulls.size(), 1u);
+        EXPECT_EQ(nulls[0], 0x02);
+
+        auto doubles = result.column<double>(0);
+        EXPECT_DOUBLE_EQ(doubles[2], -30.0);
+        EXPECT_THROW(result.column<int8_t>(0), ConversionError);
+        EXPECT_THROW(result.column<int>(1), RangeError);
+    }
+}
+
+TEST(FieldTest, DecodesArrays)
+{
+    auto result = makeResult({"{1,NULL,-3}", "{\"a,b\",\"x\\\"y\",plain}", nullptr});
+    auto numbers = result[0][0].asArray<int>();
+    ASSERT_EQ(numbers.size(), 3u);
+    EXPECT_EQ(numbers[0], std::optional<int>(1));
+    EXPECT_EQ(numbers[1], std::nullopt);
+    EXPECT_EQ(numbers[2], std::optional<int>(-3));
+    auto strings = result[1][0].asArray<std::string>();
+    ASSERT_EQ(strings.size(), 3u);
+    EXPECT_EQ(*strings[0], "a,b");
+    EXPECT_EQ(*strings[1], "x\"y");
+    EXPECT_EQ(*strings[2], "plain");
+    EXPECT_TRUE(result[2][0].asArray<int>().empty());
+    EXPECT_THROW(result[1][0].asArray<int>(), ConversionError);
+}
+
+TEST(FieldTest, ExposesRawBytes)
+{
+    auto result = makeResult({"abc", nullptr});
+    EXPECT_EQ(result[0][0].asBytes(), "abc");
+    EXPECT_EQ(result[0][0].asBytes().data(), result[0][0].c_str());
+    EXPECT_TRUE(result[1][0].asBytes().empty());
+}
+
+TEST(HexTest, DecodesAllBlockSizes)
+{
+    static const char kDigits[] = "0123456789abcdefABCDEF";
+    for (size_t bytes = 0; bytes < 70; ++bytes)
+    {
+        std::string hex, expected;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            auto high = kDigits[(i * 7) % 22];
+            auto low = kDigits[(i * 13 + 5) % 22];
+            hex.push_back(high);
+            hex.push_back(low);
+            auto value = [](char c) {
+                return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+            };
+            expected.push_back(static_cast<char>(value(high) * 16 + value(low)));
+        }
+        EXPECT_EQ(utils::hexToBinaryString(hex.data(), hex.size()), expected)
+            << bytes;
+        auto vec = utils::hexToBinaryVector(hex.data(), hex.size());
+        EXPECT_EQ(std::string(vec.begin(), vec.end()), expected) << bytes;
+    }
+}
+
+TEST(HexTest, RejectsInvalidCharacters)
+{
+    std::string hex(64, 'a');
+    for (size_t pos : {0, 15, 16, 31, 40, 63})
+    {
+        for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\xc3'})
+        {
+            auto input = hex;
+            input[pos] = bad;
+            EXPECT_EQ(utils::hexToBinaryString(input.data(), input.size()), "")
+                << pos << " " << bad;
+        }
+    }
+}
+
+TEST(HexTest, RejectsOddLength)
+{
+    // 输入放在恰好等长的堆内存中，越界读取会被ASAN发现
+    for (size_t length : {1, 3, 15, 17, 31, 33, 63, 65})
+    {
+        std::unique_ptr<char[]> hex(new char[length]);
+        memset(hex.get(), 'a', length);
+        char out[64];
+        EXPECT_FALSE(utils::hexToBinary(hex.get(), length, out)) << length;
+        EXPECT_EQ(utils::hexToBinaryString(hex.get(), length), "") << length;
+        EXPECT_TRUE(utils::hexToBinaryVector(hex.get(), length).empty())
+            << length;
+    }
+}
+
+TEST(FieldTest, ParsesDateTime)
+{
+    auto result = makeResult({"2025-06-29 19:20:05.5", nullptr, "not a date"});
+    EXPECT_EQ(result[0][0].as<DateTime>(),
+              DateTime::fromDbString("2025-06-29 19:20:05.500000"));
+    EXPECT_EQ(result[0][0].as<DateTime>().toDbString(),
+              "2025-06-29 19:20:05.500000");
+    EXPECT_EQ(result[1][0].as<DateTime>(), DateTime());
+    EXPECT_THROW(result[2][0].as<DateTime>(), ConversionError);
+    EXPECT_EQ(result[2][0].tryAs<DateTime>(), std::nullopt);
+}
+
+TEST(FieldTest, ZeroDateIsEmptyDateTime)
+{
+    auto result = makeResult({"0000-00-00 00:00:00",
+                              "0000-00-00",
+                              "0000-00-00 00:00:00.000000",
+                              "0000-00-00 00:00:01"});
+    EXPECT_EQ(result[0][0].as<DateTime>(), DateTime());
+    EXPECT_EQ(result[1][0].as<DateTime>(), DateTime());
+    EXPECT_EQ(result[2][0].as<DateTime>(), DateTime());
+    EXPECT_THROW(result[3][0].as<DateTime>(), ConversionError);
+}
+
+TEST(FieldTest, ParsesDecimal)
+{
+    auto result = makeResult({"-1234.50", nullptr, "1.2.3"});
+    auto value = result[0][0].as<Decimal>();
+    EXPECT_EQ(value.unscaled(), -123450);
+    EXPECT_EQ(value.scale(), 2u);
+    EXPECT_EQ(result[1][0].as<Decimal>(), Decimal());
+    EXPECT_THROW(result[2][0].as<Decimal>(), ConversionError);
+    EXPECT_EQ(result[2][0].tryAs<Decimal>(), std::nullopt);
+}
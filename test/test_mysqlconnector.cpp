@@ -0,0 +1,201 @@
+/**
+*@ClassName test_mysqlconnector
+*@Author cxk
+*@Data 25-6-29 下午11:10
+*/
+//
+#include <gtest/gtest.h>
+#include "MySQLImpl/MySQLConnector.h"
+#include "db/DatabaseManager.h"
+#include "db/Exception.h"
+#include "db/Field.h"
+#include "db/ResultMemoryBudget.h"
+#include "db/Row.h"
+#include "event/EventLoopThread.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace cxk;
+using namespace std::chrono_literals;
+
+namespace
+{
+// 每行约4KB，逐行sleep，使逐行读取的语句在测试检查时仍在进行
+constexpr const char *kSlowRows =
+    "with recursive t(n) as (select 1 union all select n + 1 from t "
+    "where n < 500) select n, repeat('x', 4096), sleep(0.02) from t";
+
+// 需要真实的MySQL服务端：CXK_TEST_MYSQL给出连接串，
+// 例如"host=127.0.0.1 port=3306 user=root password=xxx"，未设置时跳过
+class MySQLConnectorTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        auto connInfo = getenv("CXK_TEST_MYSQL");
+        if (!connInfo)
+            GTEST_SKIP() << "CXK_TEST_MYSQL is not set";
+        connInfo_ = connInfo;
+        loopThread_.run();
+    }
+
+    // 建立连接并等待连接完成，失败时返回nullptr
+    MySQLConnectorPtr connect(const ResultMemoryBudgetPtr &budget)
+    {
+        auto conn = std::make_shared<MySQLConnector>(loopThread_.getLoop(),
+                                                     connInfo_);
+        conn->setResultBudget(budget);
+        auto ready = std::make_shared<std::promise<bool>>();
+        auto settled = std::make_shared<std::atomic<bool>>(false);
+        auto future = ready->get_future();
+        conn->setOkCallback([ready, settled](const DbConnectionPtr &) {
+            if (!settled->exchange(true))
+                ready->set_value(true);
+        });
+        conn->setCloseCallback([this, ready, settled](const DbConnectionPtr &) {
+            closed_ = true;
+            if (!settled->exchange(true))
+                ready->set_value(false);
+        });
+        conn->setIdleCallback([]() {});
+        conn->init();
+        if (future.wait_for(10s) != std::future_status::ready || !future.get())
+            return nullptr;
+        return conn;
+    }
+
+    // 执行sql，结果回调返回第一行第一列，异常回调返回what()
+    static std::future<std::string> exec(const MySQLConnectorPtr &conn,
+                                         const std::string &sql)
+    {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto text = std::make_shared<std::string>(sql);
+        conn->loop()->queueInLoop([conn, promise, text]() {
+            conn->execSql(
+                *text,
+                [promise, text](const Result &r) {
+                    promise->set_value(r.empty() ? ""
+                                                 : r[0][0].as<std::string>());
+                },
+                [promise, text](const std::exception_ptr &e) {
+                    try
+                    {
+                        std::rethrow_exception(e);
+                    }
+                    catch (const std::exception &ex)
+                    {
+                        promise->set_value(ex.what());
+                    }
+                });
+        });
+        return promise->get_future();
+    }
+
+    template <typename Pred>
+    static bool waitUntil(Pred pred)
+    {
+        for (int i = 0; i < 500; ++i)
+        {
+            if (pred())
+                return true;
+            std::this_thread::sleep_for(10ms);
+        }
+        return pred();
+    }
+
+    std::string connInfo_;
+    std::atomic<bool> closed_{false};
+    EventLoopThread loopThread_{"MySQLConnectorTest"};
+};
+}  // namespace
+
+TEST_F(MySQLConnectorTest, DisconnectReleasesStreamedRows)
+{
+    // 预算有上限时结果逐行读取，读到的行记在预算上
+    auto budget = std::make_shared<ResultMemoryBudget>(size_t(1) << 30);
+    auto conn = connect(budget);
+    ASSERT_TRUE(conn);
+    auto f = exec(conn, kSlowRows);
+    ASSERT_TRUE(waitUntil([&]() { return budget->usedBytes() > 0; }));
+    conn->disconnect();
+    EXPECT_EQ(budget->usedBytes(), 0u);
+}
+
+TEST_F(MySQLConnectorTest, ClosedConnectionReleasesStreamedRows)
+{
+    auto budget = std::make_shared<ResultMemoryBudget>(size_t(1) << 30);
+    auto conn = connect(budget);
+    ASSERT_TRUE(conn);
+    auto id = exec(conn, "select connection_id()");
+    ASSERT_EQ(id.wait_for(10s), std::future_status::ready);
+    auto threadId = id.get();
+
+    auto f = exec(conn, kSlowRows);
+    ASSERT_TRUE(waitUntil([&]() { return budget->usedBytes() > 0; }));
+    auto killer = connect(ResultMemoryBudget::unbounded());
+    ASSERT_TRUE(killer);
+    auto killed = exec(killer, "kill " + threadId);
+    ASSERT_EQ(killed.wait_for(10s), std::future_status::ready);
+    EXPECT_TRUE(waitUntil([&]() { return closed_.load(); }));
+    EXPECT_TRUE(waitUntil([&]() { return budget->usedBytes() == 0; }));
+    killer->disconnect();
+    conn->disconnect();
+}
+
+TEST_F(MySQLConnectorTest, StoredResultChargesRowsAsIndexed)
+{
+    // 预算没有上限时结果用mysql_store_result整体读取
+    auto budget = std::make_shared<ResultMemoryBudget>();
+    auto conn = connect(budget);
+    ASSERT_TRUE(conn);
+    auto charged = std::make_shared<std::promise<std::pair<size_t, size_t>>>();
+    auto future = charged->get_future();
+    conn->loop()->queueInLoop([conn, budget, charged]() {
+        conn->execSql(
+            "with recursive t(n) as (select 1 union all select n + 1 from t "
+            "where n < 1000) select repeat('x', 1000) from t",
+            [budget, charged](const Result &r) {
+                // 交给回调时只计入行结构，字段值按块建索引时才计入
+                auto before = budget->usedBytes();
+                EXPECT_EQ(r[999][0].as<std::string>().size(), 1000u);
+                charged->set_value({before, budget->usedBytes()});
+            },
+            [charged](const std::exception_ptr &e) {
+                charged->set_exception(e);
+            });
+    });
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    auto [before, after] = future.get();
+    EXPECT_LT(before, 1000u * 1001u);
+    EXPECT_GE(after - before, 1000u * 1001u);
+    EXPECT_TRUE(waitUntil([&]() { return budget->usedBytes() == 0; }));
+    conn->disconnect();
+}
+
+TEST_F(MySQLConnectorTest, SyncStatementsUsePoolDefaults)
+{
+    auto pool = DatabaseManager::newMySQLPool(connInfo_, 1);
+    pool->setTimeout(0.5);
+    pool->setMaxResultBytes(64 * 1024);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(pool->execSqlSync("select sleep(5)"), TimeoutError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 4s);
+    EXPECT_THROW(pool->execSqlSync(
+                     "with recursive t(n) as (select 1 union all select n + 1 "
+                     "from t where n < 100) select repeat('x', 4096) from t"),
+                 ResultTooLarge);
+    // 超出上限的连接作废后重新建立，语句单独指定的值优先于默认值
+    BoundSqlBinder<> binder;
+    binder.setMaxResultBytes(1 << 20);
+    auto result = pool->execSqlSync(
+        "with recursive t(n) as (select 1 union all select n + 1 from t "
+        "where n < 100) select repeat('x', 4096) from t",
+        binder);
+    EXPECT_EQ(result.size(), 100u);
+    pool->closeAll();
+}
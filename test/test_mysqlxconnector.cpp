@@ -0,0 +1,96 @@
+/**
+*@ClassName test_mysqlxconnector
+*@Author cxk
+*@Data 25-6-29 下午10:50
+*/
+//
+#include <gtest/gtest.h>
+#include "MySQLImpl/MySQLXConnector.h"
+#include "db/Exception.h"
+#include "event/EventLoopThread.h"
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+using namespace cxk;
+using namespace std::chrono_literals;
+
+namespace
+{
+// 连接一个没有服务监听的端口，会话建立失败后所有语句都以BrokenConnection结束，
+// 不需要数据库即可检查回调路径
+class MySQLXConnectorTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        loopThread_.run();
+        conn_ = std::make_shared<MySQLXConnector>(
+            loopThread_.getLoop(), "host=127.0.0.1 port=1 user=root pipeline=1");
+        auto closed = std::make_shared<std::promise<void>>();
+        auto future = closed->get_future();
+        conn_->setCloseCallback(
+            [closed](const DbConnectionPtr &) { closed->set_value(); });
+        conn_->init();
+        ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    }
+
+    // 执行sql，异常回调先调用onError，返回异常的what()
+    std::future<std::string> exec(const std::string &sql,
+                                  std::function<void()> onError = nullptr)
+    {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto text = std::make_shared<std::string>(sql);
+        conn_->execSql(
+            *text,
+            [promise, text](const Result &) { promise->set_value("result"); },
+            [promise, text, onError](const std::exception_ptr &e) {
+                try
+                {
+                    std::rethrow_exception(e);
+                }
+                catch (const std::exception &ex)
+                {
+                    promise->set_value(ex.what());
+                }
+                if (onError)
+                    onError();
+            });
+        return promise->get_future();
+    }
+
+    // 在连接的EventLoop线程中读取isWorking()
+    bool isWorking()
+    {
+        std::promise<bool> working;
+        conn_->loop()->queueInLoop(
+            [this, &working]() { working.set_value(conn_->isWorking()); });
+        return working.get_future().get();
+    }
+
+    EventLoopThread loopThread_{"MySQLXConnectorTest"};
+    MySQLXConnectorPtr conn_;
+};
+}  // namespace
+
+TEST_F(MySQLXConnectorTest, ReportsClosedSession)
+{
+    auto f = exec("select 1");
+    ASSERT_EQ(f.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(f.get(), "The X Protocol session is not open");
+    EXPECT_FALSE(isWorking());
+}
+
+TEST_F(MySQLXConnectorTest, ThrowingCallbacksKeepConnectionUsable)
+{
+    // pipeline=1时在途计数没有归还会让连接一直处于工作状态
+    auto first = exec("select 1", []() {
+        throw std::runtime_error("thrown from the exception callback");
+    });
+    ASSERT_EQ(first.wait_for(5s), std::future_status::ready);
+    auto second = exec("select 2");
+    ASSERT_EQ(second.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(second.get(), "The X Protocol session is not open");
+    EXPECT_FALSE(isWorking());
+}
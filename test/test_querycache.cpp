@@ -0,0 +1,78 @@
+/**
+*@ClassName test_querycache
+*@Author cxk
+*@Data 25-6-29 下午9:10
+*/
+//
+#include <gtest/gtest.h>
+#include "db/Field.h"
+#include "db/QueryCache.h"
+#include "db/Row.h"
+#include "test/MemoryResultImpl.h"
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+Result textResult(const char *text)
+{
+    return makeMemoryResult({"value"}, {text});
+}
+
+std::string cachedText(QueryCache &cache, const std::string &key)
+{
+    auto hit = cache.get(key);
+    return hit ? hit->result[0][0].as<std::string>() : "miss";
+}
+}  // namespace
+
+TEST(QueryCacheTest, UnrelatedWritesKeepInflightPuts)
+{
+    QueryCache cache(1 << 20, 60.0);
+    cache.put("orders", textResult("o"), {"orders"}, cache.epoch());
+    auto epoch = cache.epoch();
+    cache.invalidateTables({"audit_log"});
+    cache.put("users", textResult("u"), {"users"}, epoch);
+    EXPECT_EQ(cachedText(cache, "users"), "u");
+    EXPECT_EQ(cachedText(cache, "orders"), "o");
+}
+
+TEST(QueryCacheTest, WritesToQueriedTablesDropInflightPuts)
+{
+    QueryCache cache(1 << 20, 60.0);
+    auto epoch = cache.epoch();
+    cache.invalidateTables({"users"});
+    cache.put("join", textResult("old"), {"orders", "users"}, epoch);
+    EXPECT_EQ(cachedText(cache, "join"), "miss");
+
+    // 失效之后写入的条目不被更早下发的查询覆盖或删除
+    cache.put("join", textResult("new"), {"orders", "users"}, cache.epoch());
+    cache.put("join", textResult("old"), {"orders", "users"}, epoch);
+    EXPECT_EQ(cachedText(cache, "join"), "new");
+}
+
+TEST(QueryCacheTest, EmptyTableListInvalidatesNothing)
+{
+    QueryCache cache(1 << 20, 60.0);
+    auto epoch = cache.epoch();
+    cache.put("users", textResult("u"), {"users"}, epoch);
+    cache.invalidateTables({});
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.epoch(), epoch);
+}
+
+TEST(QueryCacheTest, InvalidateAllDropsEntriesAndInflightPuts)
+{
+    QueryCache cache(1 << 20, 60.0);
+    cache.put("users", textResult("u"), {"users"}, cache.epoch());
+    auto epoch = cache.epoch();
+    cache.invalidateAll();
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.memoryUsage(), 0u);
+    cache.put("orders", textResult("o"), {"orders"}, epoch);
+    EXPECT_EQ(cachedText(cache, "orders"), "miss");
+    cache.put("orders", textResult("o"), {"orders"}, cache.epoch());
+    EXPECT_EQ(cachedText(cache, "orders"), "o");
+}
@@ -0,0 +1,64 @@
+/**
+*@ClassName test_resultjson
+*@Author cxk
+*@Data 25-6-28 下午5:20
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ResultJsonWriter.h"
+#include "test/MemoryResultImpl.h"
+#include <json/json.h>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+TEST(ResultJsonWriterTest, WritesObjectsByColumnKind)
+{
+    auto result = makeMemoryResult(
+        {"id", "name", "price", "doc", "raw"},
+        {"1", "a\"b", "9.50", "{\"k\":[1]}", "abcd",
+         "2", "", nullptr, nullptr, nullptr},
+        {ColumnKind::Integer,
+         ColumnKind::String,
+         ColumnKind::Decimal,
+         ColumnKind::Json,
+         ColumnKind::Binary});
+    EXPECT_EQ(ResultJsonWriter().write(result),
+              "[{\"id\":1,\"name\":\"a\\\"b\",\"price\":9.50,"
+              "\"doc\":{\"k\":[1]},\"raw\":\"YWJjZA==\"},"
+              "{\"id\":2,\"name\":\"\",\"price\":null,\"doc\":null,"
+              "\"raw\":null}]");
+}
+
+TEST(ResultJsonWriterTest, WritesArraysAndAppends)
+{
+    auto result = makeMemoryResult({"id", "name"},
+                                   {"1", "x", "2", "y"},
+                                   {ColumnKind::Integer, ColumnKind::Unknown});
+    std::string out = "prefix:";
+    ResultJsonWriter(ResultJsonWriter::Layout::Arrays).write(result, out);
+    EXPECT_EQ(out, "prefix:[[1,\"x\"],[2,\"y\"]]");
+
+    auto empty = makeMemoryResult({"id"}, {}, {ColumnKind::Integer});
+    EXPECT_EQ(ResultJsonWriter().write(empty), "[]");
+}
+
+TEST(ResultJsonWriterTest, EscapesLikeJsonCpp)
+{
+    std::string text = "plain text that is long enough for the vector path, ";
+    for (int c = 1; c < 0x20; ++c)
+        text.push_back(static_cast<char>(c));
+    text += "\"\\ tail \xe4\xb8\xad\xe6\x96\x87";
+    std::string out;
+    ResultJsonWriter::appendString(out, text);
+
+    Json::Value parsed;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    ASSERT_TRUE(reader->parse(out.data(), out.data() + out.size(), &parsed,
+                              &errors))
+        << errors;
+    EXPECT_EQ(parsed.asString(), text);
+}
@@ -0,0 +1,100 @@
+/**
+*@ClassName test_resultmemory
+*@Author cxk
+*@Data 25-6-29 下午4:20
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ResultMemoryBudget.h"
+#include "db/Result.h"
+#include "db/Row.h"
+#include "db/Field.h"
+#include "MySQLImpl/MySQLResultImpl.h"
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace cxk;
+
+namespace
+{
+MySQLResultImpl::StreamedRows makeRows()
+{
+    ColumnDesc columns[] = {{"id", MYSQL_TYPE_LONG, 0, ColumnKind::Integer},
+                            {"name", MYSQL_TYPE_VAR_STRING, 0, ColumnKind::String}};
+    return MySQLResultImpl::StreamedRows(ColumnMetadata::get(columns, 2),
+                                         nullptr);
+}
+
+void appendRow(MySQLResultImpl::StreamedRows &rows,
+               const char *id,
+               const char *name)
+{
+    char *row[] = {const_cast<char *>(id), const_cast<char *>(name)};
+    unsigned long lengths[] = {id ? strlen(id) : 0, name ? strlen(name) : 0};
+    rows.append(row, lengths);
+}
+}  // namespace
+
+TEST(ResultMemoryBudgetTest, TryReserveRespectsLimit)
+{
+    ResultMemoryBudget budget(100);
+    EXPECT_TRUE(budget.tryReserve(60));
+    EXPECT_FALSE(budget.tryReserve(50));
+    EXPECT_EQ(budget.usedBytes(), 60u);
+    // reserve()记录已经在内存中的结果，不受上限约束
+    budget.reserve(50);
+    EXPECT_EQ(budget.usedBytes(), 110u);
+    EXPECT_FALSE(budget.tryReserve(1));
+    budget.release(110);
+    EXPECT_EQ(budget.usedBytes(), 0u);
+    EXPECT_FALSE(budget.tryReserve(101));
+    EXPECT_TRUE(budget.tryReserve(100));
+    budget.release(100);
+}
+
+TEST(ResultMemoryBudgetTest, ZeroLimitIsUnbounded)
+{
+    ResultMemoryBudget budget;
+    auto total = ResultMemoryBudget::totalBytes();
+    EXPECT_TRUE(budget.tryReserve(size_t(1) << 40));
+    EXPECT_EQ(ResultMemoryBudget::totalBytes(), total + (size_t(1) << 40));
+    budget.release(size_t(1) << 40);
+    EXPECT_EQ(ResultMemoryBudget::totalBytes(), total);
+}
+
+TEST(ResultMemoryBudgetTest, StreamedRowsCountFieldBytes)
+{
+    auto rows = makeRows();
+    EXPECT_EQ(rows.bytes(), 0u);
+    appendRow(rows, "1", "alice");
+    auto oneRow = rows.bytes();
+    // 字段值各带一个'\0'，另有每个字段的指针和长度
+    EXPECT_GE(oneRow, 2u + 6u + 2 * (sizeof(char *) + sizeof(unsigned long)));
+    appendRow(rows, "2", nullptr);
+    EXPECT_GT(rows.bytes(), oneRow);
+}
+
+TEST(ResultMemoryBudgetTest, StreamedResultHoldsItsBytes)
+{
+    auto budget = std::make_shared<ResultMemoryBudget>();
+    auto rows = makeRows();
+    appendRow(rows, "1", "alice");
+    appendRow(rows, "2", nullptr);
+    appendRow(rows, "3", "carol");
+    auto bytes = rows.bytes();
+    // 读取过程中按块多占用的部分在构造时归还
+    ASSERT_TRUE(budget->tryReserve(bytes + 4096));
+    {
+        Result result(std::make_shared<MySQLResultImpl>(
+            std::move(rows), 3, 0, budget, bytes + 4096));
+        EXPECT_EQ(budget->usedBytes(), bytes);
+        ASSERT_EQ(result.size(), 3u);
+        EXPECT_EQ(result[0]["name"].as<std::string>(), "alice");
+        EXPECT_TRUE(result[1]["name"].isNull());
+        EXPECT_EQ(result[2]["id"].as<int>(), 3);
+        auto copy = result;
+        EXPECT_EQ(budget->usedBytes(), bytes);
+    }
+    EXPECT_EQ(budget->usedBytes(), 0u);
+}
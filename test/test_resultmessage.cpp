@@ -0,0 +1,148 @@
+/**
+*@ClassName test_resultmessage
+*@Author cxk
+*@Data 25-6-29 上午10:30
+*/
+//
+#include <gtest/gtest.h>
+#include "db/ResultMessageFiller.h"
+#include "test/MemoryResultImpl.h"
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+using namespace google::protobuf;
+
+namespace
+{
+// 列信息按形状共享的结果集，与MySQLResultImpl一致
+Result sharedShapeResult(const std::vector<std::string> &names,
+                         const std::vector<const char *> &values)
+{
+    auto impl = std::make_shared<MemoryResultImpl>(
+        names, values, std::vector<ColumnKind>(names.size(), ColumnKind::String));
+    impl->shareMetadata();
+    return Result(impl);
+}
+
+// 动态构造的消息类型：User {id, name, score, active, status}和UserList {users}
+class DynamicUserProto : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        FileDescriptorProto file;
+        file.set_name("user_test.proto");
+        file.set_package("cxk.test");
+        file.set_syntax("proto3");
+        auto status = file.add_enum_type();
+        status->set_name("Status");
+        auto v0 = status->add_value();
+        v0->set_name("UNKNOWN");
+        v0->set_number(0);
+        auto v1 = status->add_value();
+        v1->set_name("ACTIVE");
+        v1->set_number(1);
+
+        auto user = file.add_message_type();
+        user->set_name("User");
+        addField(user, "id", 1, FieldDescriptorProto::TYPE_INT64);
+        addField(user, "name", 2, FieldDescriptorProto::TYPE_STRING);
+        addField(user, "score", 3, FieldDescriptorProto::TYPE_DOUBLE);
+        addField(user, "active", 4, FieldDescriptorProto::TYPE_BOOL);
+        addField(user, "status", 5, FieldDescriptorProto::TYPE_ENUM)
+            ->set_type_name(".cxk.test.Status");
+        addField(user, "avatar", 6, FieldDescriptorProto::TYPE_BYTES);
+
+        auto list = file.add_message_type();
+        list->set_name("UserList");
+        auto users = addField(list, "users", 1, FieldDescriptorProto::TYPE_MESSAGE);
+        users->set_type_name(".cxk.test.User");
+        users->set_label(FieldDescriptorProto::LABEL_REPEATED);
+
+        ASSERT_NE(pool_.BuildFile(file), nullptr);
+        userType_ = pool_.FindMessageTypeByName("cxk.test.User");
+        listType_ = pool_.FindMessageTypeByName("cxk.test.UserList");
+    }
+
+    static FieldDescriptorProto *addField(DescriptorProto *message,
+                                          const char *name,
+                                          int number,
+                                          FieldDescriptorProto::Type type)
+    {
+        auto field = message->add_field();
+        field->set_name(name);
+        field->set_number(number);
+        field->set_type(type);
+        field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+        return field;
+    }
+
+    DescriptorPool pool_;
+    DynamicMessageFactory factory_{&pool_};
+    const Descriptor *userType_{nullptr};
+    const Descriptor *listType_{nullptr};
+};
+}  // namespace
+
+TEST_F(DynamicUserProto, FillsRepeatedField)
+{
+    auto result = sharedShapeResult(
+        {"ID", "Name", "score", "active", "status", "ignored"},
+        {"7", "alice", "1.5", "1", "ACTIVE", "x",
+         "8", nullptr, "2", "0", "1", "y"});
+    std::unique_ptr<Message> list(factory_.GetPrototype(listType_)->New());
+    auto users = listType_->FindFieldByName("users");
+    ResultMessageFiller::fill(result, *list, users);
+
+    auto reflection = list->GetReflection();
+    ASSERT_EQ(reflection->FieldSize(*list, users), 2);
+    auto &first = reflection->GetRepeatedMessage(*list, users, 0);
+    auto &second = reflection->GetRepeatedMessage(*list, users, 1);
+    auto userReflection = first.GetReflection();
+    auto field = [this](const char *name) {
+        return userType_->FindFieldByName(name);
+    };
+    EXPECT_EQ(userReflection->GetInt64(first, field("id")), 7);
+    EXPECT_EQ(userReflection->GetString(first, field("name")), "alice");
+    EXPECT_DOUBLE_EQ(userReflection->GetDouble(first, field("score")), 1.5);
+    EXPECT_TRUE(userReflection->GetBool(first, field("active")));
+    EXPECT_EQ(userReflection->GetEnumValue(first, field("status")), 1);
+    EXPECT_EQ(userReflection->GetInt64(second, field("id")), 8);
+    EXPECT_EQ(userReflection->GetString(second, field("name")), "");
+    EXPECT_EQ(userReflection->GetEnumValue(second, field("status")), 1);
+}
+
+TEST_F(DynamicUserProto, CachesPlanPerShape)
+{
+    std::vector<std::string> names{"id", "plan_cache_shape"};
+    auto before = ResultMessageFiller::cachedPlans();
+    for (int i = 0; i < 3; ++i)
+    {
+        auto result = sharedShapeResult(names, {"1", "a"});
+        std::unique_ptr<Message> user(factory_.GetPrototype(userType_)->New());
+        ResultMessageFiller::fill(result, 0, *user);
+        EXPECT_EQ(user->GetReflection()->GetInt64(
+                      *user, userType_->FindFieldByName("id")),
+                  1);
+    }
+    EXPECT_EQ(ResultMessageFiller::cachedPlans(), before + 1);
+}
+
+TEST_F(DynamicUserProto, RejectsBadValues)
+{
+    auto result =
+        sharedShapeResult({"id", "status"}, {"1x", "ACTIVE", "1", "NOPE"});
+    std::unique_ptr<Message> user(factory_.GetPrototype(userType_)->New());
+    EXPECT_THROW(ResultMessageFiller::fill(result, 0, *user), ConversionError);
+    EXPECT_THROW(ResultMessageFiller::fill(result, 1, *user), ConversionError);
+    EXPECT_THROW(ResultMessageFiller::fill(result, 2, *user), RangeError);
+
+    std::unique_ptr<Message> list(factory_.GetPrototype(listType_)->New());
+    EXPECT_THROW(ResultMessageFiller::fill(result,
+                                           *list,
+                                           userType_->FindFieldByName("id")),
+                 UsageError);
+}
@@ -0,0 +1,89 @@
+/**
+*@ClassName test_rowmapper
+*@Author cxk
+*@Data 25-6-28 下午2:15
+*/
+//
+#include <gtest/gtest.h>
+#include "db/RowMapper.h"
+#include "test/MemoryResultImpl.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+namespace
+{
+struct User
+{
+    int64_t id{0};
+    std::string name;
+    std::optional<double> score;
+    bool active{false};
+};
+
+std::shared_ptr<MemoryResultImpl> makeTable(
+    std::vector<std::string> names,
+    const std::vector<const char *> &values,
+    bool contiguous)
+{
+    auto impl = std::make_shared<MemoryResultImpl>(std::move(names), values);
+    impl->setContiguous(contiguous);
+    return impl;
+}
+}  // namespace
+
+CXK_ROW_MAPPING(User,
+                CXK_COLUMN(User, id),
+                cxk::column("user_name", &User::name),
+                CXK_COLUMN(User, score),
+                CXK_COLUMN(User, active));
+
+TEST(RowMapperTest, DecodesAllRows)
+{
+    for (bool contiguous : {true, false})
+    {
+        auto impl = makeTable(
+            {"ID", "active", "user_name", "score"},
+            {"1", "1", "alice", "9.5", "2", "0", "bob", nullptr},
+            contiguous);
+        auto users = mapRows<User>(Result(impl));
+        ASSERT_EQ(users.size(), 2u);
+        EXPECT_EQ(users[0].id, 1);
+        EXPECT_EQ(users[0].name, "alice");
+        EXPECT_DOUBLE_EQ(users[0].score.value(), 9.5);
+        EXPECT_TRUE(users[0].active);
+        EXPECT_EQ(users[1].id, 2);
+        EXPECT_EQ(users[1].name, "bob");
+        EXPECT_FALSE(users[1].score.has_value());
+        EXPECT_FALSE(users[1].active);
+        // 每列只按名字查找一次
+        EXPECT_EQ(impl->lookups, 4);
+    }
+}
+
+TEST(RowMapperTest, ReportsBadValuesAndMissingColumns)
+{
+    Result bad(makeTable({"id", "user_name", "score", "active"},
+                         {"x1", "alice", "1", "1"},
+                         true));
+    EXPECT_THROW(mapRows<User>(bad), ConversionError);
+
+    Result missing(makeTable({"id", "user_name", "active"},
+                             {"1", "alice", "1"},
+                             true));
+    EXPECT_THROW(mapRows<User>(missing), RangeError);
+}
+
+TEST(RowMapperTest, AppendsToExistingVector)
+{
+    Result result(makeTable({"id", "user_name", "score", "active"},
+                            {"3", "carol", "1", "t"},
+                            true));
+    std::vector<User> users(1);
+    RowMapper<User>::map(result, users);
+    ASSERT_EQ(users.size(), 2u);
+    EXPECT_EQ(users[1].id, 3);
+    EXPECT_TRUE(users[1].active);
+}
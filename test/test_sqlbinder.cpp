@@ -0,0 +1,164 @@
+/**
+*@ClassName test_sqlbinder
+*@Author cxk
+*@Data 25-6-23 上午10:05
+*/
+//
+#include <gtest/gtest.h>
+#include "db/SqlBinder.h"
+#include "utils/utils.h"
+#include <mariadb/mysql.h>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cxk;
+
+static_assert(placeholderCount("select * from t where a = ? and b = ?") == 2);
+static_assert(placeholderCount("select '?' from t -- ?\n where a = ?") == 1);
+static_assert(decltype(CXK_SQL("insert into t values(?,?,?)"))::placeholders ==
+              3);
+
+TEST(SqlBinderTest, DeducesIntegerFormats)
+{
+    auto binder = makeSqlBinder(int8_t(-3), short(7), 42, int64_t(1) << 40);
+    ASSERT_EQ(binder->size(), 4u);
+    EXPECT_EQ(binder->formats()[0], type::MySqlTiny);
+    EXPECT_EQ(binder->formats()[1], type::MySqlShort);
+    EXPECT_EQ(binder->formats()[2], type::MySqlLong);
+    EXPECT_EQ(binder->formats()[3], type::MySqlLongLong);
+    EXPECT_EQ(*binder->parameters()[0], -3);
+    EXPECT_EQ(*reinterpret_cast<const short *>(binder->parameters()[1]), 7);
+    EXPECT_EQ(*reinterpret_cast<const int32_t *>(binder->parameters()[2]), 42);
+    EXPECT_EQ(*reinterpret_cast<const int64_t *>(binder->parameters()[3]),
+              int64_t(1) << 40);
+}
+
+TEST(SqlBinderTest, WidensUnsignedIntegers)
+{
+    auto binder = makeSqlBinder(uint8_t(200), uint32_t(4000000000u));
+    EXPECT_EQ(binder->formats()[0], type::MySqlShort);
+    EXPECT_EQ(*reinterpret_cast<const short *>(binder->parameters()[0]), 200);
+    EXPECT_EQ(binder->formats()[1], type::MySqlLongLong);
+    EXPECT_EQ(*reinterpret_cast<const int64_t *>(binder->parameters()[1]),
+              4000000000LL);
+
+    auto big = makeSqlBinder(uint64_t(18446744073709551615ULL));
+    EXPECT_EQ(big->formats()[0], type::MySqlString);
+    EXPECT_EQ(std::string(big->parameters()[0], big->lengths()[0]),
+              "18446744073709551615");
+}
+
+TEST(SqlBinderTest, CopiesStrings)
+{
+    std::string name = "alice";
+    const char *city = "paris";
+    auto binder = makeSqlBinder(name, std::string_view("bob"), city, "lit");
+    name = "changed";
+    ASSERT_EQ(binder->size(), 4u);
+    for (size_t i = 0; i < binder->size(); ++i)
+    {
+        EXPECT_EQ(binder->formats()[i], type::MySqlString);
+    }
+    EXPECT_EQ(std::string(binder->parameters()[0], binder->lengths()[0]),
+              "alice");
+    EXPECT_EQ(std::string(binder->parameters()[1], binder->lengths()[1]),
+              "bob");
+    EXPECT_EQ(std::string(binder->parameters()[2], binder->lengths()[2]),
+              "paris");
+    EXPECT_EQ(std::string(binder->parameters()[3], binder->lengths()[3]),
+              "lit");
+}
+
+TEST(SqlBinderTest, NullAndOptional)
+{
+    std::optional<int> empty;
+    std::optional<std::string> text("x");
+    auto binder = makeSqlBinder(nullptr, empty, text, 1.5);
+    EXPECT_EQ(binder->formats()[0], type::MySqlNull);
+    EXPECT_EQ(binder->parameters()[0], nullptr);
+    EXPECT_EQ(binder->formats()[1], type::MySqlNull);
+    EXPECT_EQ(binder->formats()[2], type::MySqlString);
+    EXPECT_EQ(std::string(binder->parameters()[2], binder->lengths()[2]), "x");
+    EXPECT_EQ(binder->formats()[3], type::MySqlString);
+    EXPECT_EQ(std::string(binder->parameters()[3], binder->lengths()[3]),
+              "1.5");
+}
+
+TEST(SqlBinderTest, BindsDecimalAsText)
+{
+    std::optional<Decimal> none;
+    auto binder =
+        makeSqlBinder(Decimal::fromString("-0.050"), none, Decimal(42));
+    EXPECT_EQ(binder->formats()[0], type::MySqlString);
+    EXPECT_EQ(std::string(binder->parameters()[0], binder->lengths()[0]),
+              "-0.050");
+    EXPECT_EQ(binder->formats()[1], type::MySqlNull);
+    EXPECT_EQ(std::string(binder->parameters()[2], binder->lengths()[2]), "42");
+}
+
+TEST(SqlBinderTest, VectorBinderKeepsArrays)
+{
+    int32_t id = 5;
+    VectorSqlBinder binder({reinterpret_cast<const char *>(&id)},
+                           {0},
+                           {type::MySqlLong});
+    ASSERT_EQ(binder.size(), 1u);
+    EXPECT_EQ(binder.formats()[0], type::MySqlLong);
+    EXPECT_EQ(binder.parameters()[0], reinterpret_cast<const char *>(&id));
+}
+
+TEST(SqlBinderTest, CarriesTimeout)
+{
+    auto binder = makeSqlBinder(1);
+    EXPECT_LE(binder->timeout(), 0.0);
+    binder->setTimeout(0.5);
+    EXPECT_DOUBLE_EQ(binder->timeout(), 0.5);
+}
+
+// 与libmariadb逐字节比较，特殊字符落在16/32字节分块的各个位置
+TEST(EscapeTest, MatchesMysqlRealEscapeString)
+{
+    std::unique_ptr<MYSQL, void (*)(MYSQL *)> mysql(mysql_init(nullptr),
+                                                     mysql_close);
+    ASSERT_TRUE(mysql);
+    const std::string specials("\0'\"\\\n\r\x1a", 7);
+    std::vector<std::string> inputs;
+    for (size_t length : {1, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65, 100})
+    {
+        for (size_t pos = 0; pos < length; ++pos)
+        {
+            for (char c : specials)
+            {
+                std::string input(length, 'x');
+                input[pos] = c;
+                inputs.push_back(std::move(input));
+            }
+        }
+    }
+    // 随机内容，含非ASCII字节和相邻的特殊字符
+    std::mt19937 rng(20250629);
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string input(rng() % 100, '\0');
+        for (auto &c : input)
+            c = rng() % 4 == 0 ? specials[rng() % specials.size()]
+                               : static_cast<char>(rng() % 256);
+        inputs.push_back(std::move(input));
+    }
+    inputs.emplace_back();
+    inputs.push_back(specials + specials + specials + specials + specials);
+
+    for (auto const &input : inputs)
+    {
+        std::string expected(input.size() * 2 + 1, '\0');
+        expected.resize(mysql_real_escape_string(
+            mysql.get(), expected.data(), input.data(), input.size()));
+        std::string actual(input.size() * 2, '\0');
+        actual.resize(
+            utils::escapeSqlString(input.data(), input.size(), actual.data()));
+        ASSERT_EQ(actual, expected) << "input length " << input.size();
+    }
+}
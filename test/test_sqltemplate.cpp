@@ -0,0 +1,60 @@
+/**
+*@ClassName test_sqltemplate
+*@Author cxk
+*@Data 25-6-22 下午4:12
+*/
+//
+#include <gtest/gtest.h>
+#include "db/SqlTemplate.h"
+#include <string>
+
+using namespace cxk;
+
+TEST(SqlTemplateTest, SplitsOnPlaceholders)
+{
+    SqlTemplate tmpl("select * from users where id = ? and name = ?");
+    ASSERT_EQ(tmpl.placeholders(), 2u);
+    EXPECT_EQ(tmpl.fragment(0), "select * from users where id = ");
+    EXPECT_EQ(tmpl.fragment(1), " and name = ");
+    EXPECT_EQ(tmpl.fragment(2), "");
+}
+
+TEST(SqlTemplateTest, NoPlaceholders)
+{
+    SqlTemplate tmpl("select 1");
+    EXPECT_EQ(tmpl.placeholders(), 0u);
+    EXPECT_EQ(tmpl.fragment(0), "select 1");
+}
+
+TEST(SqlTemplateTest, IgnoresQuestionMarksInLiterals)
+{
+    SqlTemplate tmpl(
+        "select '?', \"a?b\", `c?` from t where a = ? and b = 'it''s ?' "
+        "and c = 'x\\'?' and d = ?");
+    ASSERT_EQ(tmpl.placeholders(), 2u);
+    EXPECT_EQ(tmpl.fragment(2), "");
+    EXPECT_EQ(tmpl.fragment(1),
+              " and b = 'it''s ?' and c = 'x\\'?' and d = ");
+}
+
+TEST(SqlTemplateTest, IgnoresQuestionMarksInComments)
+{
+    SqlTemplate tmpl(
+        "select /* why? */ a from t -- really?\n"
+        "# still?\n"
+        "where a = ?");
+    EXPECT_EQ(tmpl.placeholders(), 1u);
+}
+
+TEST(SqlTemplateTest, CacheReturnsSameTemplate)
+{
+    std::string sql = "select * from cached where id = ?";
+    auto first = SqlTemplate::get(sql);
+    // 调用者的内存改变后，缓存中的模板不受影响
+    std::string copy = sql;
+    sql.assign(sql.size(), 'x');
+    auto second = SqlTemplate::get(copy);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(second->fragment(0), "select * from cached where id = ");
+    EXPECT_GE(SqlTemplate::cachedTemplates(), 1u);
+}
